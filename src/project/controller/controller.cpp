@@ -1,5 +1,11 @@
 #include "controller.hpp"
 
+#include "bilateral.hpp"
+#include "gradient.hpp"
+#include "hash.hpp"
+#include "median.hpp"
+#include "morphology.hpp"
+
 /**
  * @brief функция ошибок
  *
@@ -14,70 +20,780 @@ QPixmap error(QString &reason_link, QString &&reason, bool &status) {
   return QPixmap();
 }
 
+namespace {
 /**
- * @brief валидирует изображение
+ * @brief запуск цепочки через кеш результатов сеанса
  *
+ * @param data сеанс
+ * @param pipeline цепочка
+ * @param roi область (пустая - все изображение)
+ * @return результат
+ */
+model::ImageBuffer runCached(s21::ProgramData &data,
+                             const model::pipeline::Pipeline &pipeline,
+                             const QRect &roi = QRect()) {
+  const model::cache::Key key{data.sourceHash,
+                              controller::describe(pipeline, roi)};
+  model::ImageBuffer result;
+  if (data.cache && data.cache->find(key, result)) return result;
+  result = roi.isNull() ? pipeline.run(data.sourceImage)
+                        : pipeline.run(data.sourceImage, roi);
+  if (data.cache) data.cache->insert(key, result);
+  return result;
+}
+
+/**
+ * @brief переход к состоянию истории: снимок результата (или исходное
+ * изображение для пустой цепочки) кладется в кеш, и start показывает его
+ * сразу; состояние без снимка пересчитывается
+ *
+ * @param data сеанс
+ * @param result результат состояния из истории
+ */
+void restore(s21::ProgramData &data, model::ImageBuffer &&result) {
+  if (result.isNull() && data.chain.isEmpty()) result = data.sourceImage;
+  if (result.isNull()) return;
+  data.resultingImage = std::move(result);
+  if (data.cache)
+    data.cache->insert({data.sourceHash, data.chain.digest()},
+                       data.resultingImage);
+}
+
+/**
+ * @brief разбор списка чисел через запятую
+ *
+ * @param user_input строка
+ * @param least наименьшее число значений
+ * @param most наибольшее число значений
+ * @param values результат разбора
+ * @param reason причина ошибки
+ * @return true, если список корректен
+ */
+bool parseNumbers(const QString &user_input, int least, int most,
+                  std::vector<float> &values, QString &reason) {
+  const QStringList items = user_input.split(',', Qt::SkipEmptyParts);
+  if (items.size() < least || items.size() > most) {
+    reason = QString("Invalid size.");
+    return false;
+  }
+  values.resize(items.size());
+  for (int i = 0; i < items.size(); ++i) {
+    bool ok;
+    values[i] = items[i].toFloat(&ok);
+    if (!ok) {
+      reason = QString("Parsing error.");
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+/**
+ * @brief валидирует и загружает изображение сеанса из data.filename
+ *
+ * @param data сеанс
  * @return true, если изображение валидное
  * @return false, если изображение невалидное
  */
-bool controller::image_validation() {
-  QImage image_test;
-  auto is_valid_image = image_test.load(model::programData.filename);
-  model::programData.isValidImage =
-      !(model::programData.filename.isEmpty() ||
-        model::programData.filename.isNull() || !is_valid_image);
-  return model::programData.isValidImage;
+bool controller::image_validation(s21::ProgramData &data) {
+  QImage image;
+  bool is_valid_image;
+  {
+    model::trace::Scope scope("load");
+    is_valid_image = image.load(data.filename);
+  }
+  if (data.filename.isEmpty() || data.filename.isNull() || !is_valid_image) {
+    data.isValidImage = false;
+    return false;
+  }
+  return image_validation(data, image);
+}
+
+/**
+ * @brief валидирует изображение, уже находящееся в памяти (например,
+ * полученное сервером), и делает его исходным изображением сеанса
+ *
+ * @param data сеанс
+ * @param image изображение
+ * @return true, если изображение валидное
+ */
+bool controller::image_validation(s21::ProgramData &data,
+                                  const QImage &image) {
+  data.isValidImage = !image.isNull();
+  data.sourceImage = model::ImageBuffer::fromImage(image);
+  data.sourceHash = model::hash::image(data.sourceImage);
+  data.resultingImage = data.sourceImage;
+  data.chain.clear();
+  data.history.clear();
+  data.history.record(data.chain);
+  return data.isValidImage;
+}
+
+/**
+ * @brief сеанс предпросмотра: исходное изображение - результат текущей
+ * цепочки (или его видимая часть), уменьшенный до размера экрана. Готовый
+ * результат берется из кеша, иначе цепочка применяется к уменьшенному
+ * источнику, так что прокси не зависит от идущей фоновой отрисовки.
+ * Фильтры simple и convolution над ним считаются сразу и не кешируются,
+ * полный результат сеанса data не меняется
+ *
+ * @param data сеанс
+ * @param bound наибольший размер прокси
+ * @param region часть результата (пустая - весь результат)
+ * @return s21::ProgramData
+ */
+s21::ProgramData controller::proxy(const s21::ProgramData &data,
+                                   const QSize &bound, const QRect &region) {
+  s21::ProgramData res;
+  res.filename = data.filename;
+  if (!data.isValidImage) return res;
+  {
+    model::trace::Scope scope("proxy");
+    // при промахе кеша full остается источником
+    model::ImageBuffer full = data.sourceImage;
+    const bool ready =
+        data.chain.isEmpty() ||
+        (data.cache &&
+         data.cache->find({data.sourceHash, data.chain.digest()}, full));
+    const model::ImageBuffer part =
+        region.isNull() ? full : full.view(region);
+    res.sourceImage = part.downscaled(bound);
+    if (!ready) res.sourceImage = data.chain.run(res.sourceImage);
+  }
+  res.sourceHash = model::hash::image(res.sourceImage);
+  res.resultingImage = res.sourceImage;
+  res.isValidImage = !res.sourceImage.isNull();
+  // свой кеш прокси не нужен: экранные результаты вытесняли бы из общего
+  // бюджета полноразмерные
+  res.cache = nullptr;
+  return res;
+}
+
+/**
+ * @brief предпросмотр настроек с ползунками: операция применяется к
+ * прокси (видимой части результата размером с экран), а не ко всему
+ * изображению, так что каждое движение ползунка - это только сборка
+ * таблицы и один проход по экранному числу пикселей
+ *
+ * @param preview сеанс предпросмотра (см. proxy)
+ * @param adjustment параметры
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @param histogram гистограмма предпросмотра, если нужна
+ * @return QPixmap
+ */
+QPixmap controller::adjust(const s21::ProgramData &preview,
+                           const model::pointop::Adjustment &adjustment,
+                           QString &reason, bool &status,
+                           model::histogram::Histogram *histogram) {
+  if (!preview.isValidImage)
+    return error(reason, QString("Invalid image."), status);
+  model::ImageBuffer res;
+  {
+    model::trace::Scope scope("adjust");
+    res = model::pointop::apply(model::pointop::adjustment(adjustment),
+                                preview.sourceImage);
+  }
+  if (histogram) *histogram = model::histogram::compute(res);
+  status = true;
+  return QPixmap::fromImage(res.toImage());
+}
+
+/**
+ * @brief гистограмма текущего результата сеанса (для показа и для
+ * фильтров, строящих таблицу по гистограмме своего входа)
+ *
+ * @param data сеанс
+ * @return model::histogram::Histogram пустая, если изображения нет
+ */
+model::histogram::Histogram controller::histogram(
+    const s21::ProgramData &data) {
+  if (!data.isValidImage) return model::histogram::Histogram();
+  return model::histogram::compute(data.resultingImage);
+}
+
+/**
+ * @brief размер прокси для следующего предпросмотра: если прошлый не уложился
+ * в бюджет времени кадра, прокси уменьшается так, чтобы уложиться (время
+ * свертки пропорционально площади), если уложился с запасом - растет
+ * обратно до размера окна, но не меньше 1/8 от него
+ *
+ * @param viewport размер окна предпросмотра
+ * @param last размер прокси прошлого предпросмотра
+ * @param elapsed время прошлого предпросмотра в мс (0 - не было)
+ * @param budget бюджет кадра в мс
+ * @return QSize
+ */
+QSize controller::previewBound(const QSize &viewport, const QSize &last,
+                               double elapsed, double budget) {
+  if (elapsed <= 0 || budget <= 0 || last.isEmpty() || viewport.isEmpty())
+    return viewport;
+  const double area = double(last.width()) * last.height() * budget / elapsed;
+  const double full = double(viewport.width()) * viewport.height();
+  const double scale = std::clamp(std::sqrt(area / full), 0.125, 1.0);
+  return QSize(std::max(1, int(std::lround(viewport.width() * scale))),
+               std::max(1, int(std::lround(viewport.height() * scale))));
+}
+
+/**
+ * @brief предпросмотр пользовательского ядра на прокси в фоне. Ядро
+ * проверяется так же, как в convolution; прежний запуск отменяется и при
+ * ошибке разбора, чтобы не тратить время на устаревшее ядро. Плитки мельче
+ * обычных, так что отмена срабатывает быстро
+ *
+ * @param preview сеанс предпросмотра (см. proxy)
+ * @param renderer фоновая отрисовка предпросмотра
+ * @param user_input ядро, как для convolution
+ * @param onDone вызывается из фонового потока после последней плитки
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @return номер отрисовки (0 при ошибке)
+ */
+std::uint64_t controller::kernelPreview(
+    const s21::ProgramData &preview, model::render::Renderer &renderer,
+    const QString &user_input, model::render::Renderer::DoneCallback onDone,
+    QString &reason, bool &status) {
+  status = false;
+  std::vector<float> kernel;
+  if (!preview.isValidImage) {
+    renderer.cancel();
+    error(reason, QString("Invalid image."), status);
+    return 0;
+  }
+  if (!parseKernel(user_input, kernel, reason)) {
+    renderer.cancel();
+    return 0;
+  }
+  model::pipeline::Pipeline pipeline;
+  pipeline.push(model::pipeline::Operation::convolution("Custom", kernel));
+  status = true;
+  return renderer.start(pipeline, preview.sourceImage,
+                        preview.sourceImage.rect(), 1.0, {},
+                        std::move(onDone), kPreviewTile);
 }
 
 /**
  * @brief контроллер для пользовательского сверточного фильтра
  *
+ * @param data сеанс
  * @param user_input пользовательский ввод
  * @param reason причина ошибки
  * @param status статус
+ * @param lumaOnly сворачивать только яркость Y (YCbCr)
  * @return QPixmap
  */
-QPixmap controller::convolution(const QString &user_input, QString &reason,
-                                bool &status) {
-  bool ok;
+QPixmap controller::convolution(s21::ProgramData &data,
+                                const QString &user_input, QString &reason,
+                                bool &status, bool lumaOnly) {
   status = false;
+  if (!data.isValidImage)
+    return error(reason, QString("Invalid image or filename."), status);
+  std::vector<float> custom_filter;
+  if (!parseKernel(user_input, custom_filter, reason)) return QPixmap();
+  status = true;
+  data.custom = custom_filter;
+  return model::convolution::getResultingImage(data, data.custom, lumaOnly);
+}
+
+/**
+ * @brief разбор и валидация пользовательского ядра свертки
+ *
+ * @param user_input строка вида "a,b,c,..." из NxN чисел, 3 <= N <= 15
+ * @param kernel результат разбора
+ * @param reason причина ошибки
+ * @return true, если ядро корректно
+ */
+bool controller::parseKernel(const QString &user_input,
+                             std::vector<float> &kernel, QString &reason) {
+  bool ok;
   QStringList stringArray = user_input.split(',', Qt::SkipEmptyParts);
   QStringList::size_type n = stringArray.size();
   auto squared = QStringList::size_type(sqrt(n));
-  if (!model::programData.isValidImage)
-    return error(reason, QString("Invalid image or filename."), status);
   if (squared * squared != n || squared < 3 || squared > 15) {
-    return error(reason, QString("Invalid size."), status);
+    reason = QString("Invalid size.");
+    return false;
   }
-  auto custom_filter = std::vector<float>(stringArray.size());
+  kernel = std::vector<float>(stringArray.size());
   for (int i = 0; i < n; ++i) {
-    custom_filter[i] = stringArray[i].toDouble(&ok);
-    if (!ok) return error(reason, QString("Parsing error."), status);
+    kernel[i] = stringArray[i].toDouble(&ok);
+    if (!ok) {
+      reason = QString("Parsing error.");
+      return false;
+    }
   }
-  status = true;
-  model::filter::custom = custom_filter;
-  return model::convolution::getResultingImage(model::filter::custom);
+  return true;
 }
 
 /**
  * @brief контроллер для выбранного фильтра
  *
+ * @param data сеанс
  * @param filter выбранный фильтр
  * @param reason причина ошибки
  * @param status статус выполнения
+ * @param lumaOnly сворачивать только яркость Y (YCbCr)
  * @return QPixmap
  */
-QPixmap controller::convolution(const std::vector<float> &filter,
-                                QString &reason, bool &status) {
-  if (!model::programData.isValidImage)
+QPixmap controller::convolution(s21::ProgramData &data,
+                                const std::vector<float> &filter,
+                                QString &reason, bool &status,
+                                bool lumaOnly) {
+  if (!data.isValidImage)
     return error(reason, QString("Invalid image."), status);
-  return model::convolution::getResultingImage(filter);
+  return model::convolution::getResultingImage(data, filter, lumaOnly);
 }
 
 /**
  * @brief Передача изображения в модель
+ * @param data сеанс
  * @param img изображение
  */
-void controller::tranferResultingImage(QImage &&img) {
-  model::programData.resultingImage = img;
+void controller::tranferResultingImage(s21::ProgramData &data, QImage &&img) {
+  data.resultingImage = model::ImageBuffer::fromImage(img);
+}
+
+/**
+ * @brief разбор пользовательской цветовой матрицы
+ *
+ * @param user_input 9 (3x3) или 12 (3x4, последний столбец - смещение в
+ * единицах 0..255) чисел через запятую, по строкам R, G, B
+ * @param matrix результат разбора
+ * @param reason причина ошибки
+ * @return true, если матрица корректна
+ */
+bool controller::parseMatrix(const QString &user_input,
+                             model::pointop::Matrix &matrix, QString &reason) {
+  bool ok;
+  QStringList stringArray = user_input.split(',', Qt::SkipEmptyParts);
+  auto n = stringArray.size();
+  if (n != 9 && n != 12) {
+    reason = QString("Invalid size.");
+    return false;
+  }
+  const int columns = n == 9 ? 3 : 4;
+  matrix = model::pointop::Matrix{};
+  for (int i = 0; i < n; ++i) {
+    matrix.m[i / columns][i % columns] = stringArray[i].toFloat(&ok);
+    if (!ok) {
+      reason = QString("Parsing error.");
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief разбор области обработки
+ *
+ * @param user_input строка "x,y,ширина,высота"
+ * @param rect результат разбора
+ * @param reason причина ошибки
+ * @return true, если область корректна
+ */
+bool controller::parseRect(const QString &user_input, QRect &rect,
+                           QString &reason) {
+  QStringList stringArray = user_input.split(',', Qt::SkipEmptyParts);
+  if (stringArray.size() != 4) {
+    reason = QString("Invalid region.");
+    return false;
+  }
+  int values[4];
+  for (int i = 0; i < 4; ++i) {
+    bool ok;
+    values[i] = stringArray[i].trimmed().toInt(&ok);
+    if (!ok || values[i] < 0) {
+      reason = QString("Parsing error.");
+      return false;
+    }
+  }
+  rect = QRect(values[0], values[1], values[2], values[3]);
+  if (rect.isEmpty()) {
+    reason = QString("Invalid region.");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief создание операции цепочки по описанию "имя[:параметр]"
+ *
+ * @param spec имя фильтра (emboss, sharpen, box-blur, gaussian-blur,
+ * laplacian, prewitt, custom, negative, grayscale, toning, sepia, matrix,
+ * levels, median, bilateral, erode, dilate, open, close, gradient) и
+ * параметр после двоеточия: ядро для custom, режим или веса r,g,b для
+ * grayscale, цвет и сила для toning, коэффициенты для matrix, яркость,
+ * контраст и гамма для levels, радиус для median, пространственная сигма и
+ * сигма по яркости для bilateral, радиусы элемента по горизонтали и
+ * вертикали для морфологии, ядро (sobel, prewitt), модуль (l1, l2) и
+ * orientation через запятую для gradient
+ * @param op результат
+ * @param reason причина ошибки
+ * @param lumaOnly свертки применяются только к яркости Y (YCbCr)
+ * @return true, если описание корректно
+ */
+bool controller::makeOperation(const QString &spec,
+                               model::pipeline::Operation &op,
+                               QString &reason, bool lumaOnly) {
+  static const std::map<QString, const std::vector<float> *> kernels{
+      {"emboss", &model::filter::emboss},
+      {"sharpen", &model::filter::sharpen},
+      {"box-blur", &model::filter::boxBlur},
+      {"gaussian-blur", &model::filter::gaussianBlur},
+      {"laplacian", &model::filter::leplacianFilter},
+      {"prewitt", &model::filter::sobelLeft}};
+  static const std::map<QString, model::morphology::Mode> morphology{
+      {"erode", model::morphology::ERODE},
+      {"dilate", model::morphology::DILATE},
+      {"open", model::morphology::OPEN},
+      {"close", model::morphology::CLOSE}};
+  auto separator = spec.indexOf(':');
+  QString name = separator < 0 ? spec : spec.left(separator);
+  QString argument = separator < 0 ? QString() : spec.mid(separator + 1);
+
+  std::vector<float> kernel, values;
+  auto found = kernels.find(name);
+  if (found != kernels.end()) {
+    op = model::pipeline::Operation::convolution(name.toStdString(),
+                                                 *found->second, lumaOnly);
+  } else if (name == "custom") {
+    if (!parseKernel(argument, kernel, reason)) return false;
+    op = model::pipeline::Operation::convolution("custom", kernel, lumaOnly);
+  } else if (name == "negative") {
+    op = model::pipeline::negative();
+  } else if (name == "grayscale" && argument.contains(',')) {
+    if (!parseNumbers(argument, 3, 3, values, reason)) return false;
+    op = model::pipeline::grayscale(values[0], values[1], values[2]);
+  } else if (name == "grayscale") {
+    static const std::map<QString, char> modes{
+        {"", LUMA}, {"average", AVERAGE}, {"luma", LUMA}, {"dissat", DISSAT}};
+    auto mode = modes.find(argument);
+    if (mode == modes.end()) {
+      reason = QString("Invalid grayscale mode: ") + argument;
+      return false;
+    }
+    op = model::pipeline::grayscale(mode->second);
+  } else if (name == "toning") {
+    const auto comma = argument.indexOf(',');
+    QColor tone(comma < 0 ? argument : argument.left(comma));
+    if (!tone.isValid()) {
+      reason = QString("Invalid tone color.");
+      return false;
+    }
+    if (comma < 0) {
+      op = model::pipeline::toning(tone);
+    } else if (parseNumbers(argument.mid(comma + 1), 1, 1, values, reason)) {
+      op = model::pipeline::toning(tone, values[0]);
+    } else {
+      return false;
+    }
+  } else if (name == "levels") {
+    if (!parseNumbers(argument, 3, 3, values, reason)) return false;
+    op = model::pipeline::levels(values[0], values[1], values[2]);
+  } else if (name == "median") {
+    if (!argument.isEmpty() && !parseNumbers(argument, 1, 1, values, reason))
+      return false;
+    const float radius = values.empty() ? 1.0f : values[0];
+    if (radius < 1 || radius > model::median::kMaxRadius ||
+        radius != std::floor(radius)) {
+      reason = QString("Invalid median radius.");
+      return false;
+    }
+    op = model::pipeline::median(int(radius));
+  } else if (name == "bilateral") {
+    if (!argument.isEmpty() && !parseNumbers(argument, 2, 2, values, reason))
+      return false;
+    if (values.empty()) values = {8, 24};
+    if (values[0] < model::bilateral::kMinSpatial ||
+        values[0] > model::bilateral::kMaxSpatial ||
+        values[1] < model::bilateral::kMinRange ||
+        values[1] > model::bilateral::kMaxRange) {
+      reason = QString("Invalid bilateral sigma.");
+      return false;
+    }
+    op = model::pipeline::bilateral(values[0], values[1]);
+  } else if (name == "gradient") {
+    auto kernel = model::gradient::SOBEL;
+    auto norm = model::gradient::L2;
+    bool orientation = false;
+    for (const QString &option : argument.split(',', Qt::SkipEmptyParts)) {
+      if (option == "sobel" || option == "prewitt") {
+        kernel = option == "sobel" ? model::gradient::SOBEL
+                                   : model::gradient::PREWITT;
+      } else if (option == "l1" || option == "l2") {
+        norm = option == "l1" ? model::gradient::L1 : model::gradient::L2;
+      } else if (option == "orientation") {
+        orientation = true;
+      } else {
+        reason = QString("Invalid gradient option: ") + option;
+        return false;
+      }
+    }
+    op = model::pipeline::gradient(kernel, norm, orientation);
+  } else if (morphology.count(name)) {
+    if (!argument.isEmpty() && !parseNumbers(argument, 1, 2, values, reason))
+      return false;
+    if (values.empty()) values = {1};
+    if (values.size() == 1) values.push_back(values[0]);
+    for (float r : values)
+      if (r < 0 || r > model::morphology::kMaxRadius || r != std::floor(r)) {
+        reason = QString("Invalid structuring element.");
+        return false;
+      }
+    op = model::pipeline::morphology(morphology.at(name), int(values[0]),
+                                     int(values[1]));
+  } else if (name == "sepia") {
+    op = model::pipeline::sepia();
+  } else if (name == "matrix") {
+    model::pointop::Matrix matrix;
+    if (!parseMatrix(argument, matrix, reason)) return false;
+    op = model::pipeline::colorMatrix(matrix);
+  } else {
+    reason = QString("Unknown filter: ") + name;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief сборка цепочки из описаний фильтров
+ *
+ * @param filters описания фильтров в порядке применения (см. makeOperation)
+ * @param pipeline результат
+ * @param reason причина ошибки
+ * @param lumaOnly свертки применяются только к яркости Y (YCbCr)
+ * @return true, если все описания корректны
+ */
+bool controller::makePipeline(const QStringList &filters,
+                              model::pipeline::Pipeline &pipeline,
+                              QString &reason, bool lumaOnly) {
+  pipeline.clear();
+  for (auto const &spec : filters) {
+    model::pipeline::Operation op;
+    if (!makeOperation(spec, op, reason, lumaOnly)) return false;
+    pipeline.push(std::move(op));
+  }
+  return true;
+}
+
+/**
+ * @brief описание обработки для ключей кеша: хеш цепочки и области
+ *
+ * @param pipeline цепочка
+ * @param roi область обработки (пустая - все изображение)
+ * @return std::uint64_t
+ */
+std::uint64_t controller::describe(const model::pipeline::Pipeline &pipeline,
+                                   const QRect &roi) {
+  std::uint64_t res = pipeline.digest();
+  if (roi.isNull()) return res;
+  const int rect[4] = {roi.x(), roi.y(), roi.width(), roi.height()};
+  return model::hash::bytes(rect, sizeof(rect), res);
+}
+
+/**
+ * @brief применение цепочки фильтров (для консольного режима и пакетной
+ * обработки, не создает QPixmap и может вызываться из любого потока)
+ *
+ * @param data сеанс
+ * @param filters описания фильтров в порядке применения (см. makeOperation)
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @param lumaOnly свертки применяются только к яркости Y (YCbCr)
+ * @param roi область обработки (пустая - все изображение)
+ * @return QImage результат, пустой при ошибке
+ */
+QImage controller::process(s21::ProgramData &data, const QStringList &filters,
+                           QString &reason, bool &status, bool lumaOnly,
+                           const QRect &roi) {
+  status = false;
+  if (!data.isValidImage) {
+    reason = QString("Invalid image.");
+    return QImage();
+  }
+  model::pipeline::Pipeline pipeline;
+  if (!makePipeline(filters, pipeline, reason, lumaOnly)) return QImage();
+  data.resultingImage = runCached(data, pipeline, roi);
+  status = true;
+  return data.resultingImage.toImage();
+}
+
+/**
+ * @brief пересчет цепочки от исходного изображения
+ *
+ * @param data сеанс
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @return QPixmap результат цепочки
+ */
+QPixmap controller::chain::render(s21::ProgramData &data, QString &reason,
+                                  bool &status) {
+  if (!data.isValidImage)
+    return error(reason, QString("Invalid image."), status);
+  data.resultingImage = runCached(data, data.chain);
+  data.history.attach(data.chain, data.resultingImage);
+  status = true;
+  return QPixmap::fromImage(data.resultingImage.toImage());
+}
+
+/**
+ * @brief добавление фильтра в цепочку и пересчет результата
+ *
+ * @param data сеанс
+ * @param op операция
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @return QPixmap
+ */
+QPixmap controller::chain::push(s21::ProgramData &data,
+                                model::pipeline::Operation &&op,
+                                QString &reason, bool &status) {
+  if (!data.isValidImage)
+    return error(reason, QString("Invalid image."), status);
+  append(data, std::move(op));
+  return render(data, reason, status);
+}
+
+/**
+ * @brief удаление последнего фильтра цепочки и пересчет результата
+ *
+ * @param data сеанс
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @return QPixmap
+ */
+QPixmap controller::chain::pop(s21::ProgramData &data, QString &reason,
+                               bool &status) {
+  drop(data);
+  return render(data, reason, status);
+}
+
+/**
+ * @brief очистка цепочки
+ *
+ * @param data сеанс
+ */
+void controller::chain::clear(s21::ProgramData &data) {
+  data.chain.clear();
+  data.history.record(data.chain);
+}
+
+/**
+ * @brief добавление фильтра в цепочку без пересчета (результат считает
+ * фоновая отрисовка, см. start)
+ *
+ * @param data сеанс
+ * @param op операция
+ */
+void controller::chain::append(s21::ProgramData &data,
+                               model::pipeline::Operation &&op) {
+  data.chain.push(std::move(op));
+  data.history.record(data.chain);
+}
+
+/**
+ * @brief удаление последнего фильтра цепочки без пересчета
+ *
+ * @param data сеанс
+ */
+void controller::chain::drop(s21::ProgramData &data) {
+  data.chain.pop();
+  data.history.record(data.chain);
+}
+
+/**
+ * @brief запуск фоновой отрисовки цепочки: сначала плитки видимой области
+ *
+ * @param data сеанс
+ * @param renderer фоновая отрисовка окна
+ * @param visible видимая область в координатах изображения
+ * @param scale масштаб показа (уменьшенный показ сначала получает черновик
+ * видимой области на уровне пирамиды)
+ * @param onTile вызывается из фонового потока для каждой готовой плитки
+ * @param onDone вызывается из фонового потока после последней плитки
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ * @return номер отрисовки (0 при ошибке)
+ */
+std::uint64_t controller::chain::start(
+    s21::ProgramData &data, model::render::Renderer &renderer,
+    const QRect &visible, double scale,
+    model::render::Renderer::TileCallback onTile,
+    model::render::Renderer::DoneCallback onDone, QString &reason,
+    bool &status) {
+  if (!data.isValidImage) {
+    error(reason, QString("Invalid image."), status);
+    return 0;
+  }
+  status = true;
+  model::ImageBuffer cached;
+  if (data.cache &&
+      data.cache->find({data.sourceHash, data.chain.digest()}, cached))
+    return renderer.present(cached, std::move(onTile), std::move(onDone));
+  return renderer.start(data.chain, data.sourceImage,
+                        visible.intersected(data.sourceImage.rect()), scale,
+                        std::move(onTile), std::move(onDone));
+}
+
+/**
+ * @brief сохранение итога фоновой отрисовки как результата сеанса
+ *
+ * @param data сеанс
+ * @param renderer фоновая отрисовка окна
+ * @param generation номер отрисовки
+ * @return true, если отрисовка актуальна и завершена
+ */
+bool controller::chain::commit(s21::ProgramData &data,
+                               const model::render::Renderer &renderer,
+                               std::uint64_t generation) {
+  if (generation != renderer.generation()) return false;
+  model::ImageBuffer result = renderer.result();
+  if (result.isNull()) return false;
+  data.resultingImage = result;
+  if (data.cache)
+    data.cache->insert({data.sourceHash, data.chain.digest()}, result);
+  data.history.attach(data.chain, result);
+  return true;
+}
+
+/**
+ * @brief отмена последней правки цепочки (добавления, удаления фильтра
+ * или очистки). Результат показывается через start
+ *
+ * @param data сеанс
+ * @return true, если было что отменять
+ */
+bool controller::chain::undo(s21::ProgramData &data) {
+  model::ImageBuffer result;
+  if (!data.isValidImage || !data.history.undo(data.chain, result))
+    return false;
+  restore(data, std::move(result));
+  return true;
+}
+
+/**
+ * @brief повтор отмененной правки цепочки
+ *
+ * @param data сеанс
+ * @return true, если было что повторять
+ */
+bool controller::chain::redo(s21::ProgramData &data) {
+  model::ImageBuffer result;
+  if (!data.isValidImage || !data.history.redo(data.chain, result))
+    return false;
+  restore(data, std::move(result));
+  return true;
+}
+
+/**
+ * @brief имена примененных фильтров в порядке применения
+ *
+ * @param data сеанс
+ * @return QStringList
+ */
+QStringList controller::chain::names(const s21::ProgramData &data) {
+  QStringList res;
+  for (auto const &op : data.chain.operations())
+    res.append(QString::fromStdString(op.name));
+  return res;
 }
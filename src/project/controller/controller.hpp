@@ -8,40 +8,105 @@
 #include <QColorDialog>
 #include <QImage>
 #include <QPixmap>
+#include <algorithm>
+#include <cmath>
+#include <map>
 
+#include "histogram.hpp"
 #include "model.hpp"
+#include "render.hpp"
+#include "trace.hpp"
 
 QPixmap error(QString &reason_link, QString &&reason, bool &status);
 namespace controller {
-bool image_validation();
+// сторона плитки предпросмотра и бюджет одного кадра предпросмотра в мс
+constexpr int kPreviewTile = 64;
+constexpr double kFrameBudget = 16.0;
+
+bool image_validation(s21::ProgramData &data);
+bool image_validation(s21::ProgramData &data, const QImage &image);
+s21::ProgramData proxy(const s21::ProgramData &data, const QSize &bound,
+                       const QRect &region = QRect());
+QPixmap adjust(const s21::ProgramData &preview,
+               const model::pointop::Adjustment &adjustment, QString &reason,
+               bool &status, model::histogram::Histogram *histogram = nullptr);
+model::histogram::Histogram histogram(const s21::ProgramData &data);
+QSize previewBound(const QSize &viewport, const QSize &last, double elapsed,
+                   double budget);
+std::uint64_t kernelPreview(const s21::ProgramData &preview,
+                            model::render::Renderer &renderer,
+                            const QString &user_input,
+                            model::render::Renderer::DoneCallback onDone,
+                            QString &reason, bool &status);
 
 /**
  * @brief контроллер для simple фильтров
  *
+ * @param data сеанс
  * @param t список параметров для контроллера
  * @return QPixmap
  */
 template <std::size_t N, typename Head, typename... Tail>
-QPixmap simple(std::tuple<Head &, Tail &...> &&t) {
+QPixmap simple(s21::ProgramData &data, std::tuple<Head &, Tail &...> &&t) {
   QString &reason = std::get<N - 2>(t);
   bool &status = std::get<N - 1>(t);
   auto f = std::get<0>(t);
-  if (!model::programData.isValidImage)
+  if (!data.isValidImage)
     return error(reason, QString("Invalid image."), status);
-  QImage image(model::programData.filename);
-  if constexpr (N == 4) {
-    f(image, std::get<1>(t));
-  } else {
-    f(image);
+  QImage image = data.sourceImage.toImage();
+  {
+    model::trace::Scope scope("point");
+    if constexpr (N == 4) {
+      f(image, std::get<1>(t));
+    } else {
+      f(image);
+    }
   }
-  model::programData.resultingImage = QImage(image);
+  data.resultingImage = model::ImageBuffer::fromImage(image);
+  status = true;
   return QPixmap::fromImage(image);
 }
 
-QPixmap convolution(const QString &user_input, QString &reason, bool &status);
-QPixmap convolution(const std::vector<float> &filter, QString &reason,
-                    bool &status);
-void tranferResultingImage(QImage &&img);
+QPixmap convolution(s21::ProgramData &data, const QString &user_input,
+                    QString &reason, bool &status, bool lumaOnly = false);
+bool parseKernel(const QString &user_input, std::vector<float> &kernel,
+                 QString &reason);
+QPixmap convolution(s21::ProgramData &data, const std::vector<float> &filter,
+                    QString &reason, bool &status, bool lumaOnly = false);
+void tranferResultingImage(s21::ProgramData &data, QImage &&img);
+bool parseMatrix(const QString &user_input, model::pointop::Matrix &matrix,
+                 QString &reason);
+bool makeOperation(const QString &spec, model::pipeline::Operation &op,
+                   QString &reason, bool lumaOnly = false);
+bool makePipeline(const QStringList &filters,
+                  model::pipeline::Pipeline &pipeline, QString &reason,
+                  bool lumaOnly = false);
+std::uint64_t describe(const model::pipeline::Pipeline &pipeline,
+                       const QRect &roi = QRect());
+QImage process(s21::ProgramData &data, const QStringList &filters,
+               QString &reason, bool &status, bool lumaOnly = false,
+               const QRect &roi = QRect());
+bool parseRect(const QString &user_input, QRect &rect, QString &reason);
+
+namespace chain {
+QPixmap render(s21::ProgramData &data, QString &reason, bool &status);
+QPixmap push(s21::ProgramData &data, model::pipeline::Operation &&op,
+             QString &reason, bool &status);
+QPixmap pop(s21::ProgramData &data, QString &reason, bool &status);
+void clear(s21::ProgramData &data);
+void append(s21::ProgramData &data, model::pipeline::Operation &&op);
+void drop(s21::ProgramData &data);
+std::uint64_t start(s21::ProgramData &data, model::render::Renderer &renderer,
+                    const QRect &visible, double scale,
+                    model::render::Renderer::TileCallback onTile,
+                    model::render::Renderer::DoneCallback onDone,
+                    QString &reason, bool &status);
+bool commit(s21::ProgramData &data, const model::render::Renderer &renderer,
+            std::uint64_t generation);
+bool undo(s21::ProgramData &data);
+bool redo(s21::ProgramData &data);
+QStringList names(const s21::ProgramData &data);
+}  // namespace chain
 }  // namespace controller
 
 #endif
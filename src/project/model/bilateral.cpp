@@ -0,0 +1,191 @@
+#include "bilateral.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace model {
+namespace bilateral {
+namespace {
+// клеток запаса с каждой стороны сетки под ядро размытия 1 4 6 4 1
+constexpr int kPad = 2;
+// в клетке: сумма R, G, B и вес
+constexpr int kComponents = 4;
+
+inline int luma(QRgb p) {
+  return (77 * qRed(p) + 150 * qGreen(p) + 29 * qBlue(p) + 128) >> 8;
+}
+
+// ближайшая клетка для координаты в клетках
+inline int nearest(float cell) { return int(std::floor(cell + 0.5f)); }
+
+/**
+ * @brief Размытие сетки ядром 1 4 6 4 1 (гауссиана с сигмой в клетку) вдоль
+ * одной оси: outer независимых линий по length блоков из block float
+ * подряд, соседние по оси блоки идут один за другим. За краями сетки нули
+ */
+void blur(std::vector<float> &grid, int outer, int length, int block) {
+  std::vector<float> line(static_cast<std::size_t>(length + 2 * kPad) * block,
+                          0.0f);
+  for (int o = 0; o < outer; ++o) {
+    float *base = grid.data() + static_cast<std::size_t>(o) * length * block;
+    std::copy(base, base + static_cast<std::size_t>(length) * block,
+              line.begin() + kPad * block);
+    for (int i = 0; i < length; ++i) {
+      const float *a = line.data() + static_cast<std::size_t>(i) * block;
+      const float *b = a + block, *c = b + block, *d = c + block,
+                  *e = d + block;
+      float *out = base + static_cast<std::size_t>(i) * block;
+      for (int k = 0; k < block; ++k)
+        out[k] = (a[k] + e[k] + 4.0f * (b[k] + d[k]) + 6.0f * c[k]) *
+                 (1.0f / 16.0f);
+    }
+  }
+}
+}  // namespace
+
+/**
+ * @brief Запас строк полосы для сетки: результат пикселя зависит от клеток
+ * в двух клетках от соседних с ним, а те - от пикселей в половине клетки
+ * @param sigmaSpatial - пространственная сигма (размер клетки), пиксели
+ */
+int radius(float sigmaSpatial) {
+  const float cell = std::clamp(sigmaSpatial, kMinSpatial, kMaxSpatial);
+  return int(std::ceil((kPad + 1.5f) * cell)) + 1;
+}
+
+/**
+ * @brief Билатеральный фильтр на прореженной билатеральной сетке (Chen,
+ * Paris, Durand): пиксели полосы накапливаются в ближайшие клетки сетки
+ * x/sigmaSpatial, y/sigmaSpatial, яркость/sigmaRange, сетка размывается
+ * гауссианой по трем осям, результат - трилинейная выборка сетки в точке
+ * пикселя, деленная на вес. Цвет сглаживается с краями по яркости. Клетки
+ * привязаны к координатам изображения, поэтому полосы и области не
+ * отличаются от обработки целиком. Размер сетки падает с квадратом
+ * sigmaSpatial, и время почти от нее не зависит
+ * @param sigmaSpatial - пространственная сигма kMinSpatial..kMaxSpatial
+ * @param sigmaRange - сигма по яркости kMinRange..kMaxRange
+ */
+window::Filter filter(float sigmaSpatial, float sigmaRange) {
+  const float cell = std::clamp(sigmaSpatial, kMinSpatial, kMaxSpatial);
+  const float level = std::clamp(sigmaRange, kMinRange, kMaxRange);
+  return [cell, level](const window::Strip &in, int lo, int hi, QRgb *out) {
+    // координаты пикселей в клетках, первая клетка каждой оси - с запасом
+    const int left = nearest(in.left / cell) - kPad;
+    const int top = nearest(in.first / cell) - kPad;
+    const int nx =
+        nearest((in.left + in.width - 1) / cell) - left + kPad + 2;
+    const int ny =
+        nearest((in.first + in.count - 1) / cell) - top + kPad + 2;
+    const int nz = nearest(255 / level) + 2 * kPad + 2;
+    std::vector<int> splatX(in.width), sliceX(in.width);
+    std::vector<float> fractionX(in.width);
+    for (int x = 0; x < in.width; ++x) {
+      const float at = (in.left + x) / cell;
+      splatX[x] = nearest(at) - left;
+      sliceX[x] = int(std::floor(at)) - left;
+      fractionX[x] = at - std::floor(at);
+    }
+    int splatZ[256], sliceZ[256];
+    float fractionZ[256];
+    for (int v = 0; v < 256; ++v) {
+      const float at = v / level;
+      splatZ[v] = nearest(at) + kPad;
+      sliceZ[v] = int(std::floor(at)) + kPad;
+      fractionZ[v] = at - std::floor(at);
+    }
+
+    const std::size_t rowCells = static_cast<std::size_t>(nx) * nz;
+    std::vector<float> grid(rowCells * ny * kComponents, 0.0f);
+    auto at = [&](int y, int x, int z) {
+      return grid.data() + ((y * rowCells + x * nz) + z) * kComponents;
+    };
+    for (int y = in.first; y < in.first + in.count; ++y) {
+      const QRgb *px = in.row(y);
+      const int cy = nearest(y / cell) - top;
+      for (int x = 0; x < in.width; ++x) {
+        float *c = at(cy, splatX[x], splatZ[luma(px[x])]);
+        c[0] += qRed(px[x]);
+        c[1] += qGreen(px[x]);
+        c[2] += qBlue(px[x]);
+        c[3] += 1.0f;
+      }
+    }
+    blur(grid, ny * nx, nz, kComponents);
+    blur(grid, ny, nx, nz * kComponents);
+    blur(grid, 1, ny, int(rowCells) * kComponents);
+
+    for (int y = lo; y < hi; ++y) {
+      const QRgb *px = in.row(y);
+      QRgb *dst = out + static_cast<std::size_t>(y - lo) * in.width;
+      const float rowAt = y / cell;
+      const int cy = int(std::floor(rowAt)) - top;
+      const float fy = rowAt - std::floor(rowAt);
+      for (int x = 0; x < in.width; ++x) {
+        const int v = luma(px[x]);
+        const float fx = fractionX[x], fz = fractionZ[v];
+        float sum[kComponents] = {0, 0, 0, 0};
+        for (int dy = 0; dy < 2; ++dy)
+          for (int dx = 0; dx < 2; ++dx) {
+            const float w = (dy ? fy : 1 - fy) * (dx ? fx : 1 - fx);
+            const float *c = at(cy + dy, sliceX[x] + dx, sliceZ[v]);
+            for (int k = 0; k < kComponents; ++k)
+              sum[k] += w * ((1 - fz) * c[k] + fz * c[k + kComponents]);
+          }
+        if (sum[3] <= 0) {
+          dst[x] = px[x];
+          continue;
+        }
+        const float scale = 1.0f / sum[3];
+        dst[x] = qRgb(int(std::min(255.0f, sum[0] * scale + 0.5f)),
+                      int(std::min(255.0f, sum[1] * scale + 0.5f)),
+                      int(std::min(255.0f, sum[2] * scale + 0.5f)));
+      }
+    }
+  };
+}
+
+/**
+ * @brief Точный билатеральный фильтр перебором окна 2 sigmaSpatial: эталон
+ * для проверки сетки и замеров. Окно не выходит за полосу (за краями
+ * ничего нет), поэтому полоса должна быть изображением целиком
+ * @param sigmaSpatial - пространственная сигма, пиксели
+ * @param sigmaRange - сигма по яркости
+ */
+window::Filter reference(float sigmaSpatial, float sigmaRange) {
+  return [sigmaSpatial, sigmaRange](const window::Strip &in, int lo, int hi,
+                                    QRgb *out) {
+    const int r = int(std::ceil(2 * sigmaSpatial));
+    std::vector<float> spatial((2 * r + 1) * (2 * r + 1)), range(256);
+    for (int dy = -r; dy <= r; ++dy)
+      for (int dx = -r; dx <= r; ++dx)
+        spatial[(dy + r) * (2 * r + 1) + dx + r] = std::exp(
+            -(dx * dx + dy * dy) / (2 * sigmaSpatial * sigmaSpatial));
+    for (int d = 0; d < 256; ++d)
+      range[d] = std::exp(-(d * d) / (2 * sigmaRange * sigmaRange));
+    const int last = in.first + in.count - 1;
+    for (int y = lo; y < hi; ++y)
+      for (int x = 0; x < in.width; ++x) {
+        const int center = luma(in.row(y)[x]);
+        double sum[4] = {0, 0, 0, 0};
+        for (int ny = std::max(in.first, y - r); ny <= std::min(last, y + r);
+             ++ny) {
+          const QRgb *px = in.row(ny);
+          for (int nx = std::max(0, x - r);
+               nx <= std::min(in.width - 1, x + r); ++nx) {
+            const double w =
+                spatial[(ny - y + r) * (2 * r + 1) + nx - x + r] *
+                range[std::abs(luma(px[nx]) - center)];
+            sum[0] += w * qRed(px[nx]);
+            sum[1] += w * qGreen(px[nx]);
+            sum[2] += w * qBlue(px[nx]);
+            sum[3] += w;
+          }
+        }
+        out[static_cast<std::size_t>(y - lo) * in.width + x] =
+            qRgb(int(sum[0] / sum[3] + 0.5), int(sum[1] / sum[3] + 0.5),
+                 int(sum[2] / sum[3] + 0.5));
+      }
+  };
+}
+}  // namespace bilateral
+}  // namespace model
@@ -0,0 +1,20 @@
+#ifndef BILATERAL_HPP
+#define BILATERAL_HPP
+
+#include "window.hpp"
+
+namespace model {
+namespace bilateral {
+// границы сигм: пространственная в пикселях, по яркости в единицах 0..255
+constexpr float kMinSpatial = 2;
+constexpr float kMaxSpatial = 64;
+constexpr float kMinRange = 4;
+constexpr float kMaxRange = 128;
+
+int radius(float sigmaSpatial);
+window::Filter filter(float sigmaSpatial, float sigmaRange);
+window::Filter reference(float sigmaSpatial, float sigmaRange);
+}  // namespace bilateral
+}  // namespace model
+
+#endif
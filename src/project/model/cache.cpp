@@ -0,0 +1,119 @@
+#include "cache.hpp"
+
+#include "metrics.hpp"
+
+namespace model {
+namespace cache {
+/**
+ * @brief Пустой кеш
+ * @param budget - наибольший суммарный размер результатов в байтах
+ */
+ResultCache::ResultCache(std::size_t budget) : limit(budget) {}
+
+/**
+ * @brief Поиск результата; найденный становится самым свежим
+ * @param key - ключ
+ * @param result - найденный результат (без копирования пикселей)
+ * @return true при попадании
+ */
+bool ResultCache::find(const Key &key, ImageBuffer &result) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    metrics::count("cache.misses");
+    return false;
+  }
+  entries.splice(entries.begin(), entries, it->second);
+  result = it->second->second;
+  metrics::count("cache.hits");
+  return true;
+}
+
+/**
+ * @brief Сохранение результата. Результат больше всего бюджета не
+ * сохраняется, старые вытесняются, пока не хватит места
+ * @param key - ключ
+ * @param result - результат
+ */
+void ResultCache::insert(const Key &key, const ImageBuffer &result) {
+  const std::size_t size = footprint(result);
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it != index.end()) {
+    used -= footprint(it->second->second);
+    entries.erase(it->second);
+    index.erase(it);
+  }
+  if (result.isNull() || size > limit) return;
+  entries.emplace_front(key, result);
+  index[key] = entries.begin();
+  used += size;
+  evict();
+}
+
+/**
+ * @brief Смена бюджета памяти (лишнее сразу вытесняется)
+ * @param bytes - бюджет в байтах
+ */
+void ResultCache::setBudget(std::size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  limit = bytes;
+  evict();
+}
+
+/**
+ * @brief Бюджет памяти в байтах
+ */
+std::size_t ResultCache::budget() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return limit;
+}
+
+/**
+ * @brief Суммарный размер сохраненных результатов в байтах
+ */
+std::size_t ResultCache::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return used;
+}
+
+/**
+ * @brief Количество сохраненных результатов
+ */
+std::size_t ResultCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+/**
+ * @brief Удаление всех результатов
+ */
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  index.clear();
+  used = 0;
+}
+
+/**
+ * @brief Вытеснение самых старых результатов до бюджета (под блокировкой)
+ */
+void ResultCache::evict() {
+  while (used > limit && !entries.empty()) {
+    used -= footprint(entries.back().second);
+    index.erase(entries.back().first);
+    entries.pop_back();
+    metrics::count("cache.evictions");
+  }
+}
+
+/**
+ * @brief Память, занимаемая пикселями изображения
+ * @param image - изображение
+ */
+std::size_t footprint(const ImageBuffer &image) {
+  return static_cast<std::size_t>(image.width()) * image.height() *
+         image.bytesPerPixel() * image.planes();
+}
+}  // namespace cache
+}  // namespace model
@@ -0,0 +1,69 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+
+#include "imagebuffer.hpp"
+
+namespace model {
+namespace cache {
+/**
+ * @brief Ключ результата: хеш содержимого исходного изображения и хеш
+ * операции (или цепочки) с параметрами
+ */
+struct Key {
+  std::uint64_t content;
+  std::uint64_t operation;
+
+  bool operator<(const Key &other) const {
+    return std::tie(content, operation) <
+           std::tie(other.content, other.operation);
+  }
+};
+
+/**
+ * @brief Кеш готовых результатов с вытеснением давно не использованных
+ * (LRU) при превышении бюджета памяти. Результаты хранятся как буферы с
+ * копированием при записи: показанный результат не занимает память
+ * дважды. Попадания, промахи и вытеснения считаются в метриках
+ * (cache.hits, cache.misses, cache.evictions)
+ */
+class ResultCache {
+ public:
+  static constexpr std::size_t kDefaultBudget = std::size_t(256) << 20;
+
+  explicit ResultCache(std::size_t budget = kDefaultBudget);
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+
+  bool find(const Key &key, ImageBuffer &result);
+  void insert(const Key &key, const ImageBuffer &result);
+  void setBudget(std::size_t bytes);
+  std::size_t budget() const;
+  std::size_t bytes() const;
+  std::size_t size() const;
+  void clear();
+
+ private:
+  using Entry = std::pair<Key, ImageBuffer>;
+
+  void evict();
+
+  mutable std::mutex mutex;
+  std::size_t limit;
+  std::size_t used{0};
+  std::list<Entry> entries;
+  std::map<Key, std::list<Entry>::iterator> index;
+};
+
+std::size_t footprint(const ImageBuffer &image);
+}  // namespace cache
+}  // namespace model
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#define RED 0
+#define GREEN 1
+#define BLUE 2
+#define AVERAGE 'a'
+#define LUMA 'l'
+#define DISSAT 'd'
+
+#endif
@@ -0,0 +1,211 @@
+#include "colormatrix.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "cpu.hpp"
+#include "parallel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLORMATRIX_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+using model::pointop::Matrix;
+
+// кратность длины ряда для ядер (шаг AVX2-ядра, SSE2 проходит его за четыре
+// итерации); хвост дополняется до этого размера, чтобы все пиксели шли через
+// одно ядро и округлялись одинаково
+constexpr std::size_t kStep = 16;
+
+using Kernel = void (*)(const Matrix &, const QRgb *, QRgb *, std::size_t);
+
+/**
+ * @brief Скалярное ядро (если нет SSE2)
+ */
+void transformScalar(const Matrix &mat, const QRgb *src, QRgb *dst,
+                     std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    float in[3] = {float(qRed(src[i])), float(qGreen(src[i])),
+                   float(qBlue(src[i]))};
+    int out[3];
+    for (int c = 0; c < 3; ++c) {
+      float v = mat.m[c][3];
+      v += mat.m[c][0] * in[0];
+      v += mat.m[c][1] * in[1];
+      v += mat.m[c][2] * in[2];
+      out[c] = static_cast<int>(std::clamp(v, 0.0f, 255.0f) + 0.5f);
+    }
+    dst[i] = qRgb(out[0], out[1], out[2]);
+  }
+}
+
+#ifdef COLORMATRIX_X86
+/**
+ * @brief SSE2: один регистр (4 пикселя) за итерацию
+ */
+__attribute__((target("sse2"))) void transformSse2(const Matrix &mat,
+                                                   const QRgb *src, QRgb *dst,
+                                                   std::size_t count) {
+  const __m128i mask = _mm_set1_epi32(0xff);
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000u));
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 max = _mm_set1_ps(255.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  __m128 m[3][4];
+  for (int c = 0; c < 3; ++c)
+    for (int k = 0; k < 4; ++k) m[c][k] = _mm_set1_ps(mat.m[c][k]);
+  for (std::size_t i = 0; i < count; i += 4) {
+    __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(p, mask));
+    __m128i out[3];
+    for (int c = 0; c < 3; ++c) {
+      __m128 v = m[c][3];
+      v = _mm_add_ps(v, _mm_mul_ps(m[c][0], r));
+      v = _mm_add_ps(v, _mm_mul_ps(m[c][1], g));
+      v = _mm_add_ps(v, _mm_mul_ps(m[c][2], b));
+      v = _mm_add_ps(_mm_min_ps(_mm_max_ps(v, zero), max), half);
+      out[c] = _mm_cvttps_epi32(v);
+    }
+    __m128i res = _mm_or_si128(alpha, _mm_slli_epi32(out[0], 16));
+    res = _mm_or_si128(res, _mm_slli_epi32(out[1], 8));
+    res = _mm_or_si128(res, out[2]);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), res);
+  }
+}
+
+/**
+ * @brief AVX2: преобразование 8 пикселей одного регистра
+ * @param m - коэффициенты матрицы, размноженные по регистру
+ */
+__attribute__((target("avx2"))) inline __m256i pixelsAvx2(
+    const __m256 (&m)[3][4], __m256i p) {
+  const __m256i mask = _mm256_set1_epi32(0xff);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 max = _mm256_set1_ps(255.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  __m256 r =
+      _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask));
+  __m256 g =
+      _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask));
+  __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(p, mask));
+  __m256i out[3];
+  for (int c = 0; c < 3; ++c) {
+    __m256 v = m[c][3];
+    v = _mm256_add_ps(v, _mm256_mul_ps(m[c][0], r));
+    v = _mm256_add_ps(v, _mm256_mul_ps(m[c][1], g));
+    v = _mm256_add_ps(v, _mm256_mul_ps(m[c][2], b));
+    v = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(v, zero), max), half);
+    out[c] = _mm256_cvttps_epi32(v);
+  }
+  __m256i res = _mm256_or_si256(_mm256_set1_epi32(int(0xff000000u)),
+                                _mm256_slli_epi32(out[0], 16));
+  res = _mm256_or_si256(res, _mm256_slli_epi32(out[1], 8));
+  return _mm256_or_si256(res, out[2]);
+}
+
+/**
+ * @brief AVX2: 8 пикселей на регистр, два независимых регистра (16
+ * пикселей) за итерацию. FMA сознательно не используется, чтобы результат
+ * совпадал с SSE2 и скалярным ядром
+ */
+__attribute__((target("avx2"))) void transformAvx2(const Matrix &mat,
+                                                   const QRgb *src, QRgb *dst,
+                                                   std::size_t count) {
+  __m256 m[3][4];
+  for (int c = 0; c < 3; ++c)
+    for (int k = 0; k < 4; ++k) m[c][k] = _mm256_set1_ps(mat.m[c][k]);
+  for (std::size_t i = 0; i < count; i += 16) {
+    auto in = reinterpret_cast<const __m256i *>(src + i);
+    __m256i lo = pixelsAvx2(m, _mm256_loadu_si256(in));
+    __m256i hi = pixelsAvx2(m, _mm256_loadu_si256(in + 1));
+    auto out = reinterpret_cast<__m256i *>(dst + i);
+    _mm256_storeu_si256(out, lo);
+    _mm256_storeu_si256(out + 1, hi);
+  }
+}
+#endif
+
+model::cpu::Level kernelLevel() {
+  return model::cpu::pick({model::cpu::AVX2, model::cpu::SSE2});
+}
+
+/**
+ * @brief Выбор ядра по возможностям процессора (один раз)
+ */
+Kernel kernel() {
+#ifdef COLORMATRIX_X86
+  static const Kernel selected =
+      kernelLevel() == model::cpu::AVX2   ? transformAvx2
+      : kernelLevel() == model::cpu::SSE2 ? transformSse2
+                                          : transformScalar;
+  return selected;
+#else
+  return transformScalar;
+#endif
+}
+}  // namespace
+
+namespace model {
+namespace colormatrix {
+
+/**
+ * @brief Применение цветовой матрицы к ряду пикселей RGB32. Основная часть
+ * длиной кратной kStep обрабатывается векторным ядром (AVX2 - 16 пикселей за
+ * итерацию, SSE2 - 4), хвост - тем же ядром через временный буфер
+ * @param matrix - матрица 3x4 (значения каналов 0..255)
+ * @param src - исходные пиксели
+ * @param dst - результат (может совпадать с src)
+ * @param count - количество пикселей
+ */
+void transform(const pointop::Matrix &matrix, const QRgb *src, QRgb *dst,
+               std::size_t count) {
+  Kernel run = kernel();
+  std::size_t body = count - count % kStep;
+  if (body) run(matrix, src, dst, body);
+  if (body == count) return;
+  QRgb tail[kStep] = {};
+  std::memcpy(tail, src + body, (count - body) * sizeof(QRgb));
+  run(matrix, tail, tail, kStep);
+  std::memcpy(dst + body, tail, (count - body) * sizeof(QRgb));
+}
+
+/**
+ * @brief Применение цветовой матрицы к изображению, строки делятся между
+ * потоками (изображение приводится к RGB32, у палитровых меняется палитра)
+ * @param img - изображение
+ * @param matrix - матрица
+ * @param threads - число потоков (0 - по числу ядер)
+ */
+void apply(QImage &img, const pointop::Matrix &matrix, int threads) {
+  if (pointop::isIndexed(img)) {
+    auto table = img.colorTable();
+    transform(matrix, table.data(), table.data(),
+              static_cast<std::size_t>(table.size()));
+    img.setColorTable(table);
+    return;
+  }
+  img = img.convertToFormat(QImage::Format_RGB32);
+  const int width = img.width();
+  uchar *bits = img.bits();
+  const qsizetype stride = img.bytesPerLine();
+  parallel::forRange(
+      img.height(),
+      [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+          auto line = reinterpret_cast<QRgb *>(bits + y * stride);
+          transform(matrix, line, line, static_cast<std::size_t>(width));
+        }
+      },
+      threads, std::max(1, (1 << 16) / std::max(1, width)));
+}
+
+/**
+ * @brief Ядро матрицы: avx2, sse2 или scalar
+ */
+const char *kernelName() { return cpu::name(kernelLevel()); }
+}  // namespace colormatrix
+}  // namespace model
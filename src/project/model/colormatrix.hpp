@@ -0,0 +1,18 @@
+#ifndef COLORMATRIX_HPP
+#define COLORMATRIX_HPP
+
+#include <QImage>
+#include <cstddef>
+
+#include "pointop.hpp"
+
+namespace model {
+namespace colormatrix {
+void transform(const pointop::Matrix &matrix, const QRgb *src, QRgb *dst,
+               std::size_t count);
+void apply(QImage &img, const pointop::Matrix &matrix, int threads = 0);
+const char *kernelName();
+}  // namespace colormatrix
+}  // namespace model
+
+#endif
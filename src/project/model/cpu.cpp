@@ -0,0 +1,46 @@
+#include "cpu.hpp"
+
+namespace model {
+namespace cpu {
+
+/**
+ * @brief Поддерживает ли процессор набор инструкций (проверка один раз)
+ * @param level - набор инструкций; вне x86 доступно только скалярное ядро
+ */
+bool supports(Level level) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  static const bool sse2 = __builtin_cpu_supports("sse2");
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return level == SCALAR || (level == SSE2 && sse2) ||
+         (level == AVX2 && avx2);
+#else
+  return level == SCALAR;
+#endif
+}
+
+/**
+ * @brief Выбор ядра модуля по возможностям процессора
+ * @param levels - векторные ядра модуля от лучшего к худшему
+ * @return первый поддерживаемый набор, иначе скалярное ядро
+ */
+Level pick(std::initializer_list<Level> levels) {
+  for (Level level : levels)
+    if (supports(level)) return level;
+  return SCALAR;
+}
+
+/**
+ * @brief Имя ядра (для отладки и метрик)
+ */
+const char *name(Level level) {
+  switch (level) {
+    case AVX2:
+      return "avx2";
+    case SSE2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+}  // namespace cpu
+}  // namespace model
@@ -0,0 +1,16 @@
+#ifndef CPU_HPP
+#define CPU_HPP
+
+#include <initializer_list>
+
+namespace model {
+namespace cpu {
+enum Level { SCALAR, SSE2, AVX2 };
+
+bool supports(Level level);
+Level pick(std::initializer_list<Level> levels);
+const char *name(Level level);
+}  // namespace cpu
+}  // namespace model
+
+#endif
@@ -0,0 +1,187 @@
+#include "diskcache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "hash.hpp"
+#include "metrics.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+// размер блока чтения при хешировании файла
+constexpr std::size_t kChunk = std::size_t(1) << 20;
+
+/**
+ * @brief Имя временного файла, уникальное для процесса и потока: файл
+ * дописывается под ним и переименовывается, так что параллельные задачи
+ * не видят недописанных результатов
+ */
+std::string temporaryName(std::uint64_t key) {
+  static std::atomic<unsigned> counter{0};
+  const std::size_t thread = std::hash<std::thread::id>()(
+      std::this_thread::get_id());
+  char name[80];
+  std::snprintf(name, sizeof(name), ".tmp-%016llx-%zx-%u",
+                static_cast<unsigned long long>(key), thread, counter++);
+  return name;
+}
+}  // namespace
+
+namespace model {
+namespace cache {
+/**
+ * @brief Кеш в каталоге (создается при необходимости)
+ * @param directory - каталог
+ * @param limit - наибольший суммарный размер файлов в байтах
+ */
+DiskCache::DiskCache(const std::string &directory, std::uintmax_t limit)
+    : root(directory), limit(limit) {
+  std::error_code error;
+  fs::create_directories(root, error);
+  valid = fs::is_directory(root, error);
+}
+
+/**
+ * @brief Каталог доступен
+ */
+bool DiskCache::isValid() const { return valid; }
+
+/**
+ * @brief Ключ результата: версия кеша, хеш входного файла и описание
+ * цепочки
+ * @param content - хеш входного файла (см. hashFile)
+ * @param chain - описание цепочки
+ */
+std::uint64_t DiskCache::key(std::uint64_t content, std::uint64_t chain) {
+  return hash::combine(hash::combine(kVersion, content), chain);
+}
+
+/**
+ * @brief Путь файла результата для ключа
+ * @param key - ключ
+ * @param extension - расширение (формат) результата
+ */
+std::string DiskCache::path(std::uint64_t key,
+                            const std::string &extension) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(key));
+  return (root / (name + ("." + extension))).string();
+}
+
+/**
+ * @brief Копирование сохраненного результата в output. Найденный файл
+ * помечается как недавно использованный
+ * @param key - ключ
+ * @param extension - расширение результата
+ * @param output - куда скопировать
+ * @return true при попадании
+ */
+bool DiskCache::fetch(std::uint64_t key, const std::string &extension,
+                      const std::string &output) {
+  std::error_code error;
+  const fs::path file = path(key, extension);
+  if (!valid || !fs::is_regular_file(file, error) ||
+      !fs::copy_file(file, output, fs::copy_options::overwrite_existing,
+                     error)) {
+    metrics::count("disk_cache.misses");
+    return false;
+  }
+  fs::last_write_time(file, fs::file_time_type::clock::now(), error);
+  metrics::count("disk_cache.hits");
+  return true;
+}
+
+/**
+ * @brief Сохранение файла результата под ключом, затем удаление давно не
+ * использованных файлов сверх лимита
+ * @param key - ключ
+ * @param extension - расширение результата
+ * @param file - файл результата
+ * @return true, если файл сохранен
+ */
+bool DiskCache::store(std::uint64_t key, const std::string &extension,
+                      const std::string &file) {
+  if (!valid) return false;
+  std::error_code error;
+  const fs::path temporary = root / temporaryName(key);
+  if (!fs::copy_file(file, temporary, fs::copy_options::overwrite_existing,
+                     error))
+    return false;
+  fs::rename(temporary, path(key, extension), error);
+  if (error) {
+    fs::remove(temporary, error);
+    return false;
+  }
+  evict();
+  return true;
+}
+
+/**
+ * @brief Суммарный размер файлов кеша в байтах
+ */
+std::uintmax_t DiskCache::bytes() const {
+  std::uintmax_t total = 0;
+  std::error_code error;
+  for (auto const &entry : fs::directory_iterator(root, error))
+    if (entry.is_regular_file(error)) total += entry.file_size(error);
+  return total;
+}
+
+/**
+ * @brief Удаление файлов, которые дольше всех не использовались, пока
+ * размер кеша больше лимита. Временные файлы других задач не трогаются
+ */
+void DiskCache::evict() {
+  struct File {
+    fs::file_time_type used;
+    std::uintmax_t size;
+    fs::path path;
+  };
+  std::vector<File> files;
+  std::uintmax_t total = 0;
+  std::error_code error;
+  for (auto const &entry : fs::directory_iterator(root, error)) {
+    if (!entry.is_regular_file(error)) continue;
+    const std::uintmax_t size = entry.file_size(error);
+    total += size;
+    if (entry.path().filename().string().rfind(".tmp-", 0) == 0) continue;
+    files.push_back({entry.last_write_time(error), size, entry.path()});
+  }
+  if (total <= limit) return;
+  std::sort(files.begin(), files.end(),
+            [](const File &a, const File &b) { return a.used < b.used; });
+  for (auto const &file : files) {
+    if (total <= limit) break;
+    if (fs::remove(file.path, error)) {
+      total -= file.size;
+      metrics::count("disk_cache.evictions");
+    }
+  }
+}
+
+/**
+ * @brief Хеш содержимого файла (блоками, без чтения целиком в память)
+ * @param path - файл
+ * @param digest - результат
+ * @return false, если файл не читается
+ */
+bool hashFile(const std::string &path, std::uint64_t &digest) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  std::vector<char> chunk(kChunk);
+  digest = 0;
+  while (in) {
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    const std::streamsize read = in.gcount();
+    if (read > 0) digest = hash::bytes(chunk.data(), std::size_t(read), digest);
+  }
+  return in.eof();
+}
+}  // namespace cache
+}  // namespace model
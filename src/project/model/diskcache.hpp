@@ -0,0 +1,49 @@
+#ifndef DISKCACHE_HPP
+#define DISKCACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace model {
+namespace cache {
+/**
+ * @brief Кеш результатов в каталоге на диске для пакетной обработки:
+ * файл результата называется по ключу (хеш входного файла и цепочки),
+ * при превышении лимита размера удаляются файлы, которые дольше всех не
+ * использовались. Попадания, промахи и удаления считаются в метриках
+ * (disk_cache.hits, disk_cache.misses, disk_cache.evictions)
+ */
+class DiskCache {
+ public:
+  static constexpr std::uintmax_t kDefaultLimit = std::uintmax_t(1) << 30;
+  // версия ключей: увеличивается, когда меняются результаты фильтров или
+  // формат файлов, чтобы записи прежних версий не находились
+  static constexpr std::uint64_t kVersion = 1;
+
+  static std::uint64_t key(std::uint64_t content, std::uint64_t chain);
+
+  explicit DiskCache(const std::string &directory,
+                     std::uintmax_t limit = kDefaultLimit);
+
+  bool isValid() const;
+  std::string path(std::uint64_t key, const std::string &extension) const;
+  bool fetch(std::uint64_t key, const std::string &extension,
+             const std::string &output);
+  bool store(std::uint64_t key, const std::string &extension,
+             const std::string &file);
+  std::uintmax_t bytes() const;
+
+ private:
+  void evict();
+
+  std::filesystem::path root;
+  std::uintmax_t limit;
+  bool valid{false};
+};
+
+bool hashFile(const std::string &path, std::uint64_t &digest);
+}  // namespace cache
+}  // namespace model
+
+#endif
@@ -0,0 +1,305 @@
+#include "gradient.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "cpu.hpp"
+#include "channel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRADIENT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+// единиц направления на радиан: полный оборот - 256
+constexpr float kTurn = 128 / 3.14159265f;
+
+// Ряд результата по трем рядам a, b, c (выше, свой, ниже), у которых есть
+// пиксели [-1] и [count]: модуль, при необходимости gx и gy
+using RowKernel = void (*)(const std::uint8_t *, const std::uint8_t *,
+                           const std::uint8_t *, std::uint8_t *,
+                           std::int16_t *, std::int16_t *, std::size_t);
+
+/**
+ * @brief Скалярное ядро (и хвост ряда векторных): столбцы окна
+ * сглаживаются по вертикали (a + k b + c) и дифференцируются (c - a) один
+ * раз, gx - разность сглаженных соседей, gy - сглаженная по горизонтали
+ * разность. Модуль ограничивается 255
+ */
+template <bool kSobel, bool kL2>
+void rowScalar(const std::uint8_t *a, const std::uint8_t *b,
+               const std::uint8_t *c, std::uint8_t *magnitude,
+               std::int16_t *gx, std::int16_t *gy, std::size_t count) {
+  const int k = kSobel ? 2 : 1;
+  for (std::size_t i = 0; i < count; ++i) {
+    const std::uint8_t *pa = a + i, *pb = b + i, *pc = c + i;
+    const int x = (pa[1] + k * pb[1] + pc[1]) - (pa[-1] + k * pb[-1] + pc[-1]);
+    const int y = (pc[-1] - pa[-1]) + k * (pc[0] - pa[0]) + (pc[1] - pa[1]);
+    if (gx) {
+      gx[i] = std::int16_t(x);
+      gy[i] = std::int16_t(y);
+    }
+    const int m = kL2 ? int(std::lround(std::sqrt(float(x * x + y * y))))
+                      : std::abs(x) + std::abs(y);
+    magnitude[i] = std::uint8_t(std::min(m, 255));
+  }
+}
+
+#ifdef GRADIENT_X86
+__attribute__((target("sse2"))) inline __m128i load8(const std::uint8_t *p) {
+  return _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)),
+      _mm_setzero_si128());
+}
+
+/**
+ * @brief SSE2: 8 пикселей за итерацию в 16-битных словах. Для L2 пары
+ * (gx, gy) перемножаются _mm_madd_epi16 сразу в gx^2 + gy^2
+ */
+template <bool kSobel, bool kL2>
+__attribute__((target("sse2"))) void rowSse2(
+    const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+    std::uint8_t *magnitude, std::int16_t *gx, std::int16_t *gy,
+    std::size_t count) {
+  const __m128i zero = _mm_setzero_si128();
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i al = load8(a + i - 1), am = load8(a + i),
+                  ar = load8(a + i + 1);
+    const __m128i bl = load8(b + i - 1), br = load8(b + i + 1);
+    const __m128i cl = load8(c + i - 1), cm = load8(c + i),
+                  cr = load8(c + i + 1);
+    const __m128i left = _mm_add_epi16(
+        _mm_add_epi16(al, cl), kSobel ? _mm_slli_epi16(bl, 1) : bl);
+    const __m128i right = _mm_add_epi16(
+        _mm_add_epi16(ar, cr), kSobel ? _mm_slli_epi16(br, 1) : br);
+    const __m128i middle = _mm_sub_epi16(cm, am);
+    const __m128i x = _mm_sub_epi16(right, left);
+    const __m128i y = _mm_add_epi16(
+        _mm_add_epi16(_mm_sub_epi16(cl, al), _mm_sub_epi16(cr, ar)),
+        kSobel ? _mm_slli_epi16(middle, 1) : middle);
+    if (gx) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(gx + i), x);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(gy + i), y);
+    }
+    __m128i m;
+    if (kL2) {
+      __m128i lo = _mm_unpacklo_epi16(x, y), hi = _mm_unpackhi_epi16(x, y);
+      lo = _mm_cvtps_epi32(
+          _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo))));
+      hi = _mm_cvtps_epi32(
+          _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi))));
+      m = _mm_packs_epi32(lo, hi);
+    } else {
+      m = _mm_add_epi16(_mm_max_epi16(x, _mm_sub_epi16(zero, x)),
+                        _mm_max_epi16(y, _mm_sub_epi16(zero, y)));
+    }
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(magnitude + i),
+                     _mm_packus_epi16(m, m));
+  }
+  rowScalar<kSobel, kL2>(a + i, b + i, c + i, magnitude + i,
+                         gx ? gx + i : nullptr, gy ? gy + i : nullptr,
+                         count - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i load16(const std::uint8_t *p) {
+  return _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+/**
+ * @brief AVX2: 16 пикселей за итерацию, хвост - ядром SSE2. Распаковка и
+ * упаковка для L2 идут внутри 128-битных половин и сохраняют порядок
+ */
+template <bool kSobel, bool kL2>
+__attribute__((target("avx2"))) void rowAvx2(
+    const std::uint8_t *a, const std::uint8_t *b, const std::uint8_t *c,
+    std::uint8_t *magnitude, std::int16_t *gx, std::int16_t *gy,
+    std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m256i al = load16(a + i - 1), am = load16(a + i),
+                  ar = load16(a + i + 1);
+    const __m256i bl = load16(b + i - 1), br = load16(b + i + 1);
+    const __m256i cl = load16(c + i - 1), cm = load16(c + i),
+                  cr = load16(c + i + 1);
+    const __m256i left = _mm256_add_epi16(
+        _mm256_add_epi16(al, cl), kSobel ? _mm256_slli_epi16(bl, 1) : bl);
+    const __m256i right = _mm256_add_epi16(
+        _mm256_add_epi16(ar, cr), kSobel ? _mm256_slli_epi16(br, 1) : br);
+    const __m256i middle = _mm256_sub_epi16(cm, am);
+    const __m256i x = _mm256_sub_epi16(right, left);
+    const __m256i y = _mm256_add_epi16(
+        _mm256_add_epi16(_mm256_sub_epi16(cl, al), _mm256_sub_epi16(cr, ar)),
+        kSobel ? _mm256_slli_epi16(middle, 1) : middle);
+    if (gx) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(gx + i), x);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(gy + i), y);
+    }
+    __m256i m;
+    if (kL2) {
+      __m256i lo = _mm256_unpacklo_epi16(x, y),
+              hi = _mm256_unpackhi_epi16(x, y);
+      lo = _mm256_cvtps_epi32(
+          _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(lo, lo))));
+      hi = _mm256_cvtps_epi32(
+          _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(hi, hi))));
+      m = _mm256_packs_epi32(lo, hi);
+    } else {
+      m = _mm256_add_epi16(_mm256_abs_epi16(x), _mm256_abs_epi16(y));
+    }
+    __m256i packed = _mm256_packus_epi16(m, m);
+    packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(magnitude + i),
+                     _mm256_castsi256_si128(packed));
+  }
+  rowSse2<kSobel, kL2>(a + i, b + i, c + i, magnitude + i,
+                       gx ? gx + i : nullptr, gy ? gy + i : nullptr,
+                       count - i);
+}
+#endif
+
+model::cpu::Level kernelLevel() {
+  return model::cpu::pick({model::cpu::AVX2, model::cpu::SSE2});
+}
+
+template <bool kSobel, bool kL2>
+RowKernel pick() {
+#ifdef GRADIENT_X86
+  if (kernelLevel() == model::cpu::AVX2) return rowAvx2<kSobel, kL2>;
+  return rowSse2<kSobel, kL2>;
+#else
+  return rowScalar<kSobel, kL2>;
+#endif
+}
+
+RowKernel rowKernel(model::gradient::Kernel kernel,
+                    model::gradient::Norm norm) {
+  const bool sobel = kernel == model::gradient::SOBEL;
+  if (norm == model::gradient::L2)
+    return sobel ? pick<true, true>() : pick<false, true>();
+  return sobel ? pick<true, false>() : pick<false, false>();
+}
+
+/**
+ * @brief Цвет направления на круге оттенков (полная насыщенность): 0 -
+ * красный, дальше через желтый, зеленый, голубой, синий, пурпурный
+ */
+QRgb hue(int orientation) {
+  const int h = orientation * 6;  // 0..1535: шесть участков по 256
+  const int sector = h >> 8, f = h & 255;
+  switch (sector) {
+    case 0:
+      return qRgb(255, f, 0);
+    case 1:
+      return qRgb(255 - f, 255, 0);
+    case 2:
+      return qRgb(0, 255, f);
+    case 3:
+      return qRgb(0, 255 - f, 255);
+    case 4:
+      return qRgb(f, 0, 255);
+    default:
+      return qRgb(255, 0, 255 - f);
+  }
+}
+}  // namespace
+
+namespace model {
+namespace gradient {
+/**
+ * @brief Градиент плоскости ядром 3x3 за один проход: gx и gy считаются
+ * вместе по одним и тем же загруженным рядам, модуль (L1 или L2,
+ * ограниченный 255) - векторным ядром SSE2/AVX2 по 8/16 пикселей. За
+ * краями плоскости повторяются крайние строки и столбцы
+ * @param src - плоскость rows x width
+ * @param width - ширина
+ * @param rows - число строк
+ * @param kernel - ядро Собеля или Превитта
+ * @param norm - L1 или L2
+ * @param lo - первая строка результата
+ * @param hi - строка после последней строки результата
+ * @param magnitude - модуль (hi - lo) x width
+ * @param orientation - направление (hi - lo) x width или nullptr: угол
+ * atan2(gy, gx) (ось y вниз), полный оборот - 256 единиц
+ */
+void plane(const std::uint8_t *src, int width, int rows, Kernel kernel,
+           Norm norm, int lo, int hi, std::uint8_t *magnitude,
+           std::uint8_t *orientation) {
+  if (width <= 0 || rows <= 0 || hi <= lo) return;
+  const RowKernel run = rowKernel(kernel, norm);
+  // строки lo - 1 .. hi с повторенными крайними столбцами
+  const std::size_t stride = width + 2;
+  std::vector<std::uint8_t> padded((hi - lo + 2) * stride);
+  for (int y = lo - 1; y <= hi; ++y) {
+    const std::uint8_t *line =
+        src + std::size_t(std::clamp(y, 0, rows - 1)) * width;
+    std::uint8_t *dst = padded.data() + (y - lo + 1) * stride;
+    std::memcpy(dst + 1, line, width);
+    dst[0] = line[0];
+    dst[width + 1] = line[width - 1];
+  }
+  std::vector<std::int16_t> gx(orientation ? width : 0),
+      gy(orientation ? width : 0);
+  for (int y = lo; y < hi; ++y) {
+    const std::uint8_t *b = padded.data() + (y - lo + 1) * stride + 1;
+    const std::size_t row = std::size_t(y - lo) * width;
+    run(b - stride, b, b + stride, magnitude + row,
+        orientation ? gx.data() : nullptr, orientation ? gy.data() : nullptr,
+        width);
+    if (!orientation) continue;
+    for (int x = 0; x < width; ++x)
+      orientation[row + x] = std::uint8_t(
+          std::lround(std::atan2(float(gy[x]), float(gx[x])) * kTurn) & 255);
+  }
+}
+
+/**
+ * @brief Градиент как оконный фильтр по яркости полосы: серый модуль или,
+ * с направлением, цвет направления на круге оттенков с яркостью модуля
+ * @param kernel - ядро Собеля или Превитта
+ * @param norm - L1 или L2
+ * @param orientation - показывать направление
+ */
+window::Filter filter(Kernel kernel, Norm norm, bool orientation) {
+  return [=](const window::Strip &in, int lo, int hi, QRgb *out) {
+    window::Plane luma;
+    if (window::isGray(in)) {
+      window::split(in, BLUE, luma);
+    } else {
+      luma.resize(static_cast<std::size_t>(in.count) * in.width);
+      for (std::size_t i = 0; i < luma.size(); ++i) {
+        const QRgb p = in.px[i];
+        luma[i] = std::uint8_t(
+            (77 * qRed(p) + 150 * qGreen(p) + 29 * qBlue(p) + 128) >> 8);
+      }
+    }
+    window::Plane planes[2];
+    planes[0].resize(static_cast<std::size_t>(hi - lo) * in.width);
+    if (orientation) planes[1].resize(planes[0].size());
+    plane(luma.data(), in.width, in.count, kernel, norm, lo - in.first,
+          hi - in.first, planes[0].data(),
+          orientation ? planes[1].data() : nullptr);
+    if (!orientation) {
+      window::merge(planes, 1, in.width, hi - lo, out);
+      return;
+    }
+    for (std::size_t i = 0; i < planes[0].size(); ++i) {
+      const QRgb color = hue(planes[1][i]);
+      const int m = planes[0][i];
+      out[i] = qRgb((qRed(color) * m + 127) / 255,
+                    (qGreen(color) * m + 127) / 255,
+                    (qBlue(color) * m + 127) / 255);
+    }
+  };
+}
+
+/**
+ * @brief Ядро производных: avx2, sse2 (scalar вне x86)
+ */
+const char *kernelName() { return cpu::name(kernelLevel()); }
+}  // namespace gradient
+}  // namespace model
@@ -0,0 +1,23 @@
+#ifndef GRADIENT_HPP
+#define GRADIENT_HPP
+
+#include <cstdint>
+
+#include "window.hpp"
+
+namespace model {
+namespace gradient {
+// ядро производных: Собель (центральная строка с весом 2) или Превитт
+enum Kernel { SOBEL, PREWITT };
+// модуль градиента: |gx| + |gy| или sqrt(gx^2 + gy^2)
+enum Norm { L1, L2 };
+
+void plane(const std::uint8_t *src, int width, int rows, Kernel kernel,
+           Norm norm, int lo, int hi, std::uint8_t *magnitude,
+           std::uint8_t *orientation = nullptr);
+window::Filter filter(Kernel kernel, Norm norm, bool orientation);
+const char *kernelName();
+}  // namespace gradient
+}  // namespace model
+
+#endif
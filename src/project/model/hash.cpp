@@ -0,0 +1,91 @@
+#include "hash.hpp"
+
+#include <cstring>
+
+namespace {
+constexpr std::uint64_t kPrime1 = 0x9e3779b185ebca87ULL;
+constexpr std::uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr std::uint64_t kPrime3 = 0x165667b19e3779f9ULL;
+
+std::uint64_t rotl(std::uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+std::uint64_t round(std::uint64_t acc, std::uint64_t word) {
+  return rotl(acc + word * kPrime2, 31) * kPrime1;
+}
+
+// перемешивание итога, чтобы близкие входы давали далекие значения
+std::uint64_t avalanche(std::uint64_t value) {
+  value ^= value >> 33;
+  value *= kPrime2;
+  value ^= value >> 29;
+  value *= kPrime3;
+  return value ^ (value >> 32);
+}
+}  // namespace
+
+namespace model {
+namespace hash {
+/**
+ * @brief Некриптографический 64-битный хеш блока памяти (в духе xxHash64:
+ * четыре независимых накопителя по 8 байт, чтобы умножения шли
+ * параллельно). Для ключей кеша результатов, не для защиты
+ * @param data - данные
+ * @param size - размер в байтах
+ * @param seed - начальное значение (для продолжения цепочки)
+ */
+std::uint64_t bytes(const void *data, std::size_t size, std::uint64_t seed) {
+  auto p = static_cast<const unsigned char *>(data);
+  std::uint64_t acc[4] = {seed + kPrime1 + kPrime2, seed + kPrime2, seed,
+                          seed - kPrime1};
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32)
+    for (int lane = 0; lane < 4; ++lane) {
+      std::uint64_t word;
+      std::memcpy(&word, p + i + 8 * lane, 8);
+      acc[lane] = round(acc[lane], word);
+    }
+  std::uint64_t res = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) +
+                      rotl(acc[3], 18) + size;
+  for (; i + 8 <= size; i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p + i, 8);
+    res = rotl(res ^ round(0, word), 27) * kPrime1 + kPrime3;
+  }
+  for (; i < size; ++i) res = rotl(res ^ (p[i] * kPrime3), 11) * kPrime1;
+  return avalanche(res);
+}
+
+/**
+ * @brief Добавление значения к хешу
+ * @param seed - хеш
+ * @param value - значение
+ */
+std::uint64_t combine(std::uint64_t seed, std::uint64_t value) {
+  return bytes(&value, sizeof(value), seed);
+}
+
+/**
+ * @brief Хеш содержимого изображения: размер, формат, палитра и пиксели
+ * (без выравнивания строк, так что область и ее копия совпадают)
+ * @param image - изображение
+ */
+std::uint64_t image(const ImageBuffer &image) {
+  if (image.isNull()) return 0;
+  const std::uint64_t header[3] = {std::uint64_t(image.width()),
+                                   std::uint64_t(image.height()),
+                                   std::uint64_t(image.format())};
+  std::uint64_t res = bytes(header, sizeof(header));
+  const auto colors = image.colorTable();
+  if (!colors.isEmpty())
+    res = bytes(colors.constData(), colors.size() * sizeof(QRgb), res);
+  const std::size_t row =
+      static_cast<std::size_t>(image.width()) * image.bytesPerPixel();
+  for (int plane = 0; plane < image.planes(); ++plane)
+    for (int y = 0; y < image.height(); ++y)
+      res = bytes(image.constLine(y, plane), row, res);
+  return res;
+}
+}  // namespace hash
+}  // namespace model
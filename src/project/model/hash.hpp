@@ -0,0 +1,18 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "imagebuffer.hpp"
+
+namespace model {
+namespace hash {
+std::uint64_t bytes(const void *data, std::size_t size,
+                    std::uint64_t seed = 0);
+std::uint64_t combine(std::uint64_t seed, std::uint64_t value);
+std::uint64_t image(const ImageBuffer &image);
+}  // namespace hash
+}  // namespace model
+
+#endif
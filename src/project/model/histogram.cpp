@@ -0,0 +1,220 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "channel.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace model {
+namespace histogram {
+namespace {
+// отсчетов 16-битных данных в одном куске параллельного цикла
+constexpr std::size_t kBlock = std::size_t(1) << 16;
+
+using Bins = std::uint32_t[4][256];
+
+inline unsigned luma(unsigned r, unsigned g, unsigned b) {
+  return (77 * r + 150 * g + 29 * b + 128) >> 8;
+}
+
+inline void add(Bins &bins, QRgb pixel) {
+  const unsigned r = (pixel >> 16) & 0xff;
+  const unsigned g = (pixel >> 8) & 0xff;
+  const unsigned b = pixel & 0xff;
+  ++bins[RED][r];
+  ++bins[GREEN][g];
+  ++bins[BLUE][b];
+  ++bins[kLuma][luma(r, g, b)];
+}
+}  // namespace
+
+/**
+ * @brief Наименьшее значение, до которого включительно набирается доля
+ * fraction пикселей (не меньше одного пикселя)
+ * @param channel - канал (RED, GREEN, BLUE или kLuma)
+ * @param fraction - доля 0..1
+ */
+int Histogram::percentile(int channel, double fraction) const {
+  if (count == 0) return 0;
+  const double wanted = std::ceil(std::clamp(fraction, 0.0, 1.0) * count);
+  const std::uint64_t target = std::max<std::uint64_t>(1, wanted);
+  std::uint64_t sum = 0;
+  for (int v = 0; v < 256; ++v) {
+    sum += bins[channel][v];
+    if (sum >= target) return v;
+  }
+  return 255;
+}
+
+/**
+ * @brief Среднее значение канала
+ * @param channel - канал (RED, GREEN, BLUE или kLuma)
+ */
+double Histogram::mean(int channel) const {
+  if (count == 0) return 0;
+  double sum = 0;
+  for (int v = 0; v < 256; ++v) sum += double(v) * bins[channel][v];
+  return sum / count;
+}
+
+bool Histogram::operator==(const Histogram &other) const {
+  return count == other.count && bins == other.bins;
+}
+
+/**
+ * @brief Гистограмма изображения: строки делятся между потоками, каждый
+ * кусок считается в свои 32-битные корзины на стеке, которые складываются
+ * в общий результат по окончании куска. Однобайтовые форматы считаются по
+ * значению байта и переводятся в каналы один раз на кусок
+ * @param image - изображение
+ * @param threads - число потоков (0 - по числу ядер)
+ */
+Histogram compute(const ImageBuffer &image, int threads) {
+  model::trace::Scope scope("histogram");
+  Histogram res;
+  if (image.isNull()) return res;
+  const bool bytes = image.format() == ImageBuffer::GRAY8 ||
+                     image.format() == ImageBuffer::INDEXED8;
+  const ImageBuffer source =
+      bytes ? image : image.convertTo(ImageBuffer::RGB32);
+  // значение байта -> пиксель для однобайтовых форматов
+  std::vector<QRgb> colors(256);
+  for (int v = 0; v < 256; ++v) colors[v] = qRgb(v, v, v);
+  if (source.format() == ImageBuffer::INDEXED8) {
+    const QList<QRgb> table = source.colorTable();
+    for (int v = 0; v < 256 && v < table.size(); ++v) colors[v] = table[v];
+  }
+  const int width = source.width();
+  std::mutex lock;
+  parallel::forRange(
+      source.height(),
+      [&](int begin, int end) {
+        Bins bins = {};
+        for (int y = begin; y < end; ++y) {
+          const uchar *line = source.constLine(y);
+          if (bytes) {
+            for (int x = 0; x < width; ++x) ++bins[0][line[x]];
+          } else {
+            const QRgb *px = reinterpret_cast<const QRgb *>(line);
+            for (int x = 0; x < width; ++x) add(bins, px[x]);
+          }
+        }
+        if (bytes) {
+          Bins values = {};
+          std::swap(values, bins);
+          for (int v = 0; v < 256; ++v) {
+            const QRgb p = colors[v];
+            const unsigned r = qRed(p), g = qGreen(p), b = qBlue(p);
+            bins[RED][r] += values[0][v];
+            bins[GREEN][g] += values[0][v];
+            bins[BLUE][b] += values[0][v];
+            bins[kLuma][luma(r, g, b)] += values[0][v];
+          }
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        for (int c = 0; c < 4; ++c)
+          for (int v = 0; v < 256; ++v) res.bins[c][v] += bins[c][v];
+      },
+      threads);
+  res.count = std::uint64_t(width) * source.height();
+  return res;
+}
+
+/**
+ * @brief Гистограмма 16-битных отсчетов (65536 корзин), например одного
+ * канала кадра с глубиной больше 8 бит
+ * @param samples - отсчеты
+ * @param count - число отсчетов
+ * @param threads - число потоков (0 - по числу ядер)
+ */
+std::vector<std::uint64_t> compute16(const std::uint16_t *samples,
+                                     std::size_t count, int threads) {
+  model::trace::Scope scope("histogram16");
+  std::vector<std::uint64_t> res(65536, 0);
+  if (!samples || count == 0) return res;
+  const int blocks = int((count + kBlock - 1) / kBlock);
+  std::mutex lock;
+  parallel::forRange(
+      blocks,
+      [&](int begin, int end) {
+        std::vector<std::uint32_t> bins(65536, 0);
+        const std::size_t last = std::min(count, end * kBlock);
+        for (std::size_t i = begin * kBlock; i < last; ++i)
+          ++bins[samples[i]];
+        std::lock_guard<std::mutex> guard(lock);
+        for (std::size_t v = 0; v < bins.size(); ++v) res[v] += bins[v];
+      },
+      threads);
+  return res;
+}
+
+/**
+ * @brief Таблица выравнивания гистограммы по каждому каналу: значение
+ * переходит в долю пикселей не ярче него. Однотонный канал не меняется
+ * @param histogram - гистограмма изображения
+ */
+pointop::Lut equalization(const Histogram &histogram) {
+  pointop::Lut res = pointop::identityLut();
+  if (histogram.count == 0) return res;
+  for (int c = RED; c <= BLUE; ++c) {
+    const auto &bins = histogram.bins[c];
+    const std::uint64_t least =
+        *std::find_if(bins.begin(), bins.end(),
+                      [](std::uint64_t n) { return n > 0; });
+    if (histogram.count <= least) continue;
+    const double scale = 255.0 / double(histogram.count - least);
+    std::uint64_t sum = 0;
+    for (int v = 0; v < 256; ++v) {
+      sum += bins[v];
+      res[c][v] =
+          std::uint8_t(sum < least ? 0 : (sum - least) * scale + 0.5);
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Таблица автоуровней: каждый канал растягивается так, чтобы доля
+ * clip самых темных и самых светлых пикселей ушла в 0 и 255
+ * @param histogram - гистограмма изображения
+ * @param clip - доля отсекаемых пикселей с каждой стороны
+ */
+pointop::Lut autoLevels(const Histogram &histogram, double clip) {
+  pointop::Lut res = pointop::identityLut();
+  for (int c = RED; c <= BLUE; ++c) {
+    const int low = histogram.percentile(c, clip);
+    const int high = histogram.percentile(c, 1.0 - clip);
+    if (high <= low) continue;
+    const double scale = 255.0 / (high - low);
+    for (int v = 0; v < 256; ++v)
+      res[c][v] =
+          std::uint8_t(std::clamp((v - low) * scale, 0.0, 255.0) + 0.5);
+  }
+  return res;
+}
+
+/**
+ * @brief Сводка для проверки результата: по каждому каналу минимум, 1%,
+ * медиана, 99%, максимум и среднее
+ * @param histogram - гистограмма изображения
+ */
+std::string report(const Histogram &histogram) {
+  static const char *names[4] = {"red", "green", "blue", "luma"};
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  for (int c = 0; c < 4; ++c)
+    out << names[c] << ": min " << histogram.percentile(c, 0) << ", 1% "
+        << histogram.percentile(c, 0.01) << ", median "
+        << histogram.percentile(c, 0.5) << ", 99% "
+        << histogram.percentile(c, 0.99) << ", max "
+        << histogram.percentile(c, 1) << ", mean " << histogram.mean(c)
+        << "\n";
+  return out.str();
+}
+}  // namespace histogram
+}  // namespace model
@@ -0,0 +1,40 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "imagebuffer.hpp"
+#include "pointop.hpp"
+
+namespace model {
+namespace histogram {
+// индекс гистограммы яркости после каналов RED, GREEN, BLUE
+constexpr int kLuma = 3;
+
+/**
+ * @brief Гистограмма 8-битного изображения: по 256 корзин на каналы R, G, B
+ * и яркость (0.299R + 0.587G + 0.114B в целых), count - число пикселей
+ */
+struct Histogram {
+  std::array<std::array<std::uint64_t, 256>, 4> bins{};
+  std::uint64_t count{0};
+
+  int percentile(int channel, double fraction) const;
+  double mean(int channel) const;
+  bool operator==(const Histogram &other) const;
+};
+
+Histogram compute(const ImageBuffer &image, int threads = 0);
+std::vector<std::uint64_t> compute16(const std::uint16_t *samples,
+                                     std::size_t count, int threads = 0);
+pointop::Lut equalization(const Histogram &histogram);
+pointop::Lut autoLevels(const Histogram &histogram, double clip = 0.005);
+std::string report(const Histogram &histogram);
+}  // namespace histogram
+}  // namespace model
+
+#endif
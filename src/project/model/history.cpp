@@ -0,0 +1,470 @@
+#include "history.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <set>
+
+#include "hash.hpp"
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+namespace model {
+namespace history {
+namespace {
+// число байтов в блоке с общей разрядностью
+constexpr std::size_t kBlock = 32;
+// наибольшая длина цепочки плиток-разностей: распаковка плитки распаковывает
+// и все плитки, от которых она отсчитана
+constexpr int kMaxDepth = 4;
+
+/**
+ * @brief Разность байтов со знаком в виде 0, -1, 1, -2, ... -> 0, 1, 2, 3
+ */
+inline std::uint8_t zigzag(std::uint8_t delta) {
+  return std::uint8_t((delta << 1) ^ (delta & 0x80 ? 0xff : 0));
+}
+
+inline std::uint8_t unzigzag(std::uint8_t value) {
+  return std::uint8_t((value >> 1) ^ (value & 1 ? 0xff : 0));
+}
+
+/**
+ * @brief Размер результата compress без самого сжатия
+ */
+std::size_t packedSize(const std::uint8_t *data, std::size_t size) {
+  std::size_t res = 0;
+  std::uint8_t previous = 0;
+  for (std::size_t start = 0; start < size; start += kBlock) {
+    const std::size_t n = std::min(kBlock, size - start);
+    std::uint8_t all = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      all |= zigzag(std::uint8_t(data[start + i] - previous));
+      previous = data[start + i];
+    }
+    int bits = 0;
+    while (all >> bits) ++bits;
+    res += 1 + (n * bits + 7) / 8;
+  }
+  return res;
+}
+
+/**
+ * @brief Область плитки index в сетке плиток стороны side
+ */
+QRect tileRect(int index, int columns, int side, int width, int height) {
+  const int x = index % columns * side, y = index / columns * side;
+  return QRect(x, y, std::min(side, width - x), std::min(side, height - y));
+}
+
+/**
+ * @brief Байты плитки по каналам: для каждой плоскости и каждого байта
+ * пикселя подряд идут строки плитки. Так соседние байты - один канал
+ * соседних пикселей, и их разности малы
+ */
+void gather(const ImageBuffer &image, const QRect &rect,
+            std::vector<std::uint8_t> &raw) {
+  const int bpp = image.bytesPerPixel();
+  raw.resize(std::size_t(rect.width()) * rect.height() * bpp *
+             image.planes());
+  std::uint8_t *out = raw.data();
+  for (int p = 0; p < image.planes(); ++p)
+    for (int k = 0; k < bpp; ++k)
+      for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const uchar *in = image.constLine(y, p) + rect.x() * bpp + k;
+        for (int x = 0; x < rect.width(); ++x) *out++ = in[x * bpp];
+      }
+}
+
+/**
+ * @brief Обратное к gather: раскладывает байты плитки по изображению
+ */
+void scatter(const std::vector<std::uint8_t> &raw, const QRect &rect,
+             ImageBuffer &image) {
+  const int bpp = image.bytesPerPixel();
+  const std::uint8_t *in = raw.data();
+  for (int p = 0; p < image.planes(); ++p)
+    for (int k = 0; k < bpp; ++k)
+      for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        uchar *out = image.line(y, p) + rect.x() * bpp + k;
+        for (int x = 0; x < rect.width(); ++x) out[x * bpp] = *in++;
+      }
+}
+}  // namespace
+
+/**
+ * @brief Сжатие байтов: разности соседних байтов, затем блоки по kBlock
+ * разностей, упакованных по столько бит, сколько нужно наибольшей из них
+ * (байт разрядности перед блоком). Однотонные области и неизменные каналы
+ * (альфа) сжимаются в 32 раза, плавные переходы - в 4-8 раз, шум - с
+ * накладными расходами около 3%
+ * @param data - байты
+ * @param size - их число
+ * @return сжатые байты
+ */
+std::vector<std::uint8_t> compress(const std::uint8_t *data,
+                                   std::size_t size) {
+  std::vector<std::uint8_t> res;
+  res.reserve(size / 2 + 16);
+  std::uint8_t values[kBlock];
+  std::uint8_t previous = 0;
+  for (std::size_t start = 0; start < size; start += kBlock) {
+    const std::size_t n = std::min(kBlock, size - start);
+    std::uint8_t all = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      values[i] = zigzag(std::uint8_t(data[start + i] - previous));
+      previous = data[start + i];
+      all |= values[i];
+    }
+    int bits = 0;
+    while (all >> bits) ++bits;
+    res.push_back(std::uint8_t(bits));
+    std::uint64_t accumulator = 0;
+    int filled = 0;
+    for (std::size_t i = 0; i < n && bits; ++i) {
+      accumulator |= std::uint64_t(values[i]) << filled;
+      filled += bits;
+      for (; filled >= 8; filled -= 8, accumulator >>= 8)
+        res.push_back(std::uint8_t(accumulator));
+    }
+    if (filled > 0) res.push_back(std::uint8_t(accumulator));
+  }
+  res.shrink_to_fit();
+  return res;
+}
+
+/**
+ * @brief Распаковка результата compress
+ * @param packed - сжатые байты
+ * @param data - буфер для исходных байтов
+ * @param size - их число
+ * @return false, если данные повреждены или другой длины
+ */
+bool decompress(const std::vector<std::uint8_t> &packed, std::uint8_t *data,
+                std::size_t size) {
+  std::size_t in = 0;
+  std::uint8_t previous = 0;
+  for (std::size_t start = 0; start < size; start += kBlock) {
+    const std::size_t n = std::min(kBlock, size - start);
+    if (in >= packed.size() || packed[in] > 8) return false;
+    const int bits = packed[in++];
+    const std::size_t bytes = (n * bits + 7) / 8;
+    if (in + bytes > packed.size()) return false;
+    std::uint64_t accumulator = 0;
+    int filled = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      for (; filled < bits; filled += 8)
+        accumulator |= std::uint64_t(packed[in++]) << filled;
+      const std::uint8_t value =
+          std::uint8_t(accumulator & ((1u << bits) - 1));
+      accumulator >>= bits;
+      filled -= bits;
+      previous = std::uint8_t(previous + unzigzag(value));
+      data[start + i] = previous;
+    }
+  }
+  return in == packed.size();
+}
+
+/**
+ * @brief Пустая история
+ * @param budget - наибольший размер снимков в байтах
+ * @param tileSize - сторона плитки снимка
+ */
+History::History(std::size_t budget, int tileSize)
+    : limit(budget), tileSize(std::max(16, tileSize)) {}
+
+/**
+ * @brief Новое состояние после правки цепочки. Состояния для повтора
+ * отбрасываются; цепочка, совпадающая с текущей, состоянием не считается
+ * @param chain - цепочка после правки
+ */
+void History::record(const pipeline::Pipeline &chain) {
+  const std::uint64_t digest = chain.digest();
+  if (!states.empty() && states[current].digest == digest) return;
+  if (!states.empty()) states.resize(current + 1);
+  states.push_back({chain, digest, nullptr});
+  current = states.size() - 1;
+  evict();
+}
+
+/**
+ * @brief Снимок результата для состояния с этой цепочкой (ближайшего к
+ * текущему). Плитки, совпадающие с ближайшим снимком, не копируются
+ * @param chain - цепочка
+ * @param result - ее результат
+ * @return false, если такого состояния нет
+ */
+bool History::attach(const pipeline::Pipeline &chain,
+                     const ImageBuffer &result) {
+  if (result.isNull() || states.empty()) return false;
+  const std::uint64_t digest = chain.digest();
+  std::size_t index = states.size();
+  for (std::size_t d = 0; d < states.size() && index == states.size(); ++d) {
+    if (current >= d && states[current - d].digest == digest)
+      index = current - d;
+    else if (current + d < states.size() &&
+             states[current + d].digest == digest)
+      index = current + d;
+  }
+  if (index == states.size()) return false;
+  if (!states[index].snapshot) {
+    states[index].snapshot = encode(result, nearest(index));
+    evict();
+  }
+  return true;
+}
+
+/**
+ * @brief Шаг назад
+ * @param chain - цепочка предыдущего состояния
+ * @param result - его результат или пустой буфер, если снимок отброшен
+ * @return false, если отменять нечего
+ */
+bool History::undo(pipeline::Pipeline &chain, ImageBuffer &result) {
+  if (!canUndo()) return false;
+  --current;
+  restore(chain, result);
+  return true;
+}
+
+/**
+ * @brief Шаг вперед после отмены
+ * @param chain - цепочка следующего состояния
+ * @param result - его результат или пустой буфер, если снимок отброшен
+ * @return false, если повторять нечего
+ */
+bool History::redo(pipeline::Pipeline &chain, ImageBuffer &result) {
+  if (!canRedo()) return false;
+  ++current;
+  restore(chain, result);
+  return true;
+}
+
+bool History::canUndo() const { return current > 0; }
+
+bool History::canRedo() const { return current + 1 < states.size(); }
+
+/**
+ * @brief Число состояний
+ */
+std::size_t History::size() const { return states.size(); }
+
+/**
+ * @brief Номер текущего состояния
+ */
+std::size_t History::position() const { return current; }
+
+/**
+ * @brief Число состояний со снимком
+ */
+std::size_t History::snapshots() const {
+  std::size_t res = 0;
+  for (auto const &state : states) res += state.snapshot != nullptr;
+  return res;
+}
+
+/**
+ * @brief Смена бюджета памяти (лишние снимки сразу отбрасываются)
+ * @param bytes - бюджет в байтах
+ */
+void History::setBudget(std::size_t bytes) {
+  limit = bytes;
+  evict();
+}
+
+/**
+ * @brief Бюджет памяти в байтах
+ */
+std::size_t History::budget() const { return limit; }
+
+/**
+ * @brief Размер снимков в байтах (общие плитки и плитки, от которых
+ * отсчитаны разности, считаются один раз)
+ */
+std::size_t History::bytes() const { return used; }
+
+/**
+ * @brief Удаление всех состояний
+ */
+void History::clear() {
+  states.clear();
+  current = 0;
+  used = 0;
+}
+
+/**
+ * @brief Снимок изображения плитками (плитки сжимаются параллельно).
+ * Измененная плитка сжимается и сама по себе, и как побайтовая разность с
+ * плиткой предыдущего снимка; хранится более короткий вариант. Разность
+ * выигрывает у правок всего изображения (яркость, тон), где соседние байты
+ * различаются сильно, а прежние и новые - на одну и ту же величину
+ * @param image - изображение
+ * @param previous - снимок, с которым делятся совпадающие плитки и
+ * относительно которого сжимаются разности
+ */
+std::shared_ptr<const History::Snapshot> History::encode(
+    const ImageBuffer &image, const Snapshot *previous) const {
+  trace::Scope scope("history.encode");
+  const ImageBuffer source = image.format() == ImageBuffer::INDEXED8
+                                 ? image.convertTo(ImageBuffer::RGB32)
+                                 : image;
+  auto res = std::make_shared<Snapshot>();
+  res->width = source.width();
+  res->height = source.height();
+  res->format = source.format();
+  const int columns = (res->width + tileSize - 1) / tileSize;
+  const int rows = (res->height + tileSize - 1) / tileSize;
+  res->tiles.resize(std::size_t(columns) * rows);
+  if (previous && (previous->width != res->width ||
+                   previous->height != res->height ||
+                   previous->format != res->format))
+    previous = nullptr;
+  parallel::forRange(int(res->tiles.size()), [&](int begin, int end) {
+    std::vector<std::uint8_t> raw, reference, scratch;
+    for (int i = begin; i < end; ++i) {
+      gather(source,
+             tileRect(i, columns, tileSize, res->width, res->height), raw);
+      const std::uint64_t digest = hash::bytes(raw.data(), raw.size());
+      const std::shared_ptr<const Tile> base =
+          previous ? previous->tiles[i] : nullptr;
+      if (base && base->hash == digest) {
+        res->tiles[i] = base;
+        continue;
+      }
+      auto tile = std::make_shared<Tile>(
+          Tile{digest, compress(raw.data(), raw.size()), nullptr, 0});
+      reference.resize(raw.size());
+      if (base && base->depth < kMaxDepth &&
+          unpack(*base, reference, scratch)) {
+        for (std::size_t k = 0; k < raw.size(); ++k)
+          reference[k] = std::uint8_t(raw[k] - reference[k]);
+        if (packedSize(reference.data(), reference.size()) <
+            tile->packed.size()) {
+          tile->packed = compress(reference.data(), reference.size());
+          tile->base = base;
+          tile->depth = base->depth + 1;
+        }
+      }
+      res->tiles[i] = std::move(tile);
+    }
+  });
+  metrics::count("history.snapshots");
+  return res;
+}
+
+/**
+ * @brief Изображение из снимка (плитки распаковываются параллельно)
+ * @param snapshot - снимок
+ * @return пустой буфер, если хотя бы одна плитка повреждена
+ */
+ImageBuffer History::decode(const Snapshot &snapshot) const {
+  trace::Scope scope("history.decode");
+  ImageBuffer res(snapshot.width, snapshot.height, snapshot.format);
+  const int columns = (snapshot.width + tileSize - 1) / tileSize;
+  const int planes = res.planes(), bpp = res.bytesPerPixel();
+  std::atomic<bool> intact{true};
+  parallel::forRange(int(snapshot.tiles.size()), [&](int begin, int end) {
+    std::vector<std::uint8_t> raw, scratch;
+    for (int i = begin; i < end && intact; ++i) {
+      const QRect rect =
+          tileRect(i, columns, tileSize, snapshot.width, snapshot.height);
+      raw.resize(std::size_t(rect.width()) * rect.height() * bpp * planes);
+      if (unpack(*snapshot.tiles[i], raw, scratch))
+        scatter(raw, rect, res);
+      else
+        intact = false;
+    }
+  });
+  return intact ? res : ImageBuffer();
+}
+
+/**
+ * @brief Байты плитки: для плитки-разности сначала распаковываются плитки,
+ * от которых она отсчитана
+ * @param tile - плитка
+ * @param raw - буфер размера плитки
+ * @param scratch - рабочий буфер (переиспользуется между вызовами)
+ * @return false, если данные повреждены
+ */
+bool History::unpack(const Tile &tile, std::vector<std::uint8_t> &raw,
+                     std::vector<std::uint8_t> &scratch) {
+  const Tile *chain[kMaxDepth + 1];
+  int n = 0;
+  for (const Tile *t = &tile; t && n <= kMaxDepth; t = t->base.get())
+    chain[n++] = t;
+  if (chain[n - 1]->base ||
+      !decompress(chain[n - 1]->packed, raw.data(), raw.size()))
+    return false;
+  scratch.resize(raw.size());
+  for (int i = n - 2; i >= 0; --i) {
+    if (!decompress(chain[i]->packed, scratch.data(), scratch.size()))
+      return false;
+    for (std::size_t k = 0; k < raw.size(); ++k)
+      raw[k] = std::uint8_t(raw[k] + scratch[k]);
+  }
+  return true;
+}
+
+/**
+ * @brief Ближайший к состоянию снимок (при равном расстоянии - более
+ * ранний): с ним новый снимок делит неизменные плитки
+ * @param index - номер состояния
+ */
+const History::Snapshot *History::nearest(std::size_t index) const {
+  for (std::size_t d = 1; d < states.size(); ++d) {
+    if (index >= d && states[index - d].snapshot)
+      return states[index - d].snapshot.get();
+    if (index + d < states.size() && states[index + d].snapshot)
+      return states[index + d].snapshot.get();
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Цепочка и результат текущего состояния. Снимок, который не удалось
+ * распаковать, отбрасывается, как вытесненный: результат пересчитывается
+ */
+void History::restore(pipeline::Pipeline &chain, ImageBuffer &result) {
+  chain = states[current].chain;
+  result = states[current].snapshot ? decode(*states[current].snapshot)
+                                    : ImageBuffer();
+  if (result.isNull() && states[current].snapshot) {
+    states[current].snapshot.reset();
+    metrics::count("history.corrupt");
+    evict();
+  }
+}
+
+/**
+ * @brief Пересчет занятой памяти; пока она больше бюджета, отбрасываются
+ * снимки самых далеких от текущего состояний (текущий - последним)
+ */
+void History::evict() {
+  for (;;) {
+    std::set<const Tile *> unique;
+    used = 0;
+    for (auto const &state : states) {
+      if (!state.snapshot) continue;
+      for (auto const &tile : state.snapshot->tiles)
+        for (const Tile *t = tile.get(); t && unique.insert(t).second;
+             t = t->base.get())
+          used += t->packed.size();
+    }
+    if (used <= limit) return;
+    std::size_t victim = current, distance = 0;
+    for (std::size_t i = 0; i < states.size(); ++i) {
+      const std::size_t d = i > current ? i - current : current - i;
+      if (states[i].snapshot && d > distance) {
+        victim = i;
+        distance = d;
+      }
+    }
+    if (!states[victim].snapshot) return;
+    states[victim].snapshot.reset();
+    metrics::count("history.evictions");
+  }
+}
+}  // namespace history
+}  // namespace model
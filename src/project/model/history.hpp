@@ -0,0 +1,87 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "imagebuffer.hpp"
+#include "pipeline.hpp"
+
+namespace model {
+namespace history {
+std::vector<std::uint8_t> compress(const std::uint8_t *data, std::size_t size);
+bool decompress(const std::vector<std::uint8_t> &packed, std::uint8_t *data,
+                std::size_t size);
+
+/**
+ * @brief История правок для отмены и повтора: состояния - цепочки фильтров,
+ * к которым прикладывается снимок результата. Снимок хранится плитками:
+ * плитки, не изменившиеся относительно предыдущего снимка, общие, остальные
+ * сжаты - сами по себе или как разность с плиткой предыдущего снимка, если
+ * так короче (разности соседних байтов, упакованные блоками по числу
+ * значащих бит). При превышении бюджета памяти снимки самых далеких от
+ * текущего состояний отбрасываются - такое состояние, как и снимок,
+ * который не удалось распаковать, восстанавливается пересчетом цепочки
+ */
+class History {
+ public:
+  static constexpr std::size_t kDefaultBudget = std::size_t(256) << 20;
+
+  explicit History(std::size_t budget = kDefaultBudget, int tileSize = 128);
+
+  void record(const pipeline::Pipeline &chain);
+  bool attach(const pipeline::Pipeline &chain, const ImageBuffer &result);
+  bool undo(pipeline::Pipeline &chain, ImageBuffer &result);
+  bool redo(pipeline::Pipeline &chain, ImageBuffer &result);
+  bool canUndo() const;
+  bool canRedo() const;
+  std::size_t size() const;
+  std::size_t position() const;
+  std::size_t snapshots() const;
+  void setBudget(std::size_t bytes);
+  std::size_t budget() const;
+  std::size_t bytes() const;
+  void clear();
+
+ private:
+  struct Tile {
+    std::uint64_t hash;
+    std::vector<std::uint8_t> packed;
+    // плитка, к байтам которой прибавляются распакованные (нет - packed
+    // хранит саму плитку), и длина цепочки таких плиток
+    std::shared_ptr<const Tile> base;
+    int depth;
+  };
+  struct Snapshot {
+    int width;
+    int height;
+    ImageBuffer::Format format;
+    std::vector<std::shared_ptr<const Tile>> tiles;
+  };
+  struct State {
+    pipeline::Pipeline chain;
+    std::uint64_t digest;
+    std::shared_ptr<const Snapshot> snapshot;
+  };
+
+  std::shared_ptr<const Snapshot> encode(const ImageBuffer &image,
+                                         const Snapshot *previous) const;
+  ImageBuffer decode(const Snapshot &snapshot) const;
+  static bool unpack(const Tile &tile, std::vector<std::uint8_t> &raw,
+                     std::vector<std::uint8_t> &scratch);
+  const Snapshot *nearest(std::size_t index) const;
+  void restore(pipeline::Pipeline &chain, ImageBuffer &result);
+  void evict();
+
+  std::size_t limit;
+  int tileSize;
+  std::size_t used{0};
+  std::size_t current{0};
+  std::vector<State> states;
+};
+}  // namespace history
+}  // namespace model
+
+#endif
@@ -0,0 +1,381 @@
+#include "imagebuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace {
+// выравнивание строк и плоскостей под векторные загрузки
+constexpr qsizetype kAlign = 64;
+
+qsizetype alignUp(qsizetype value) {
+  return (value + kAlign - 1) / kAlign * kAlign;
+}
+}  // namespace
+
+namespace model {
+/**
+ * @brief Общие данные буфера. Пиксели лежат либо в собственной выровненной
+ * памяти, либо в разделяемом QImage (owner), в который писать нельзя
+ */
+struct ImageBuffer::Data {
+  int width = 0;
+  int height = 0;
+  Format format = INVALID;
+  int planes = 1;
+  qsizetype stride = 0;
+  qsizetype planeSize = 0;
+  std::unique_ptr<uchar, decltype(&std::free)> storage{nullptr, std::free};
+  uchar *bits = nullptr;
+  QImage owner;
+  QList<QRgb> colors;
+};
+
+/**
+ * @brief Новый буфер, заполненный нулями
+ * @param width - ширина
+ * @param height - высота
+ * @param format - формат пикселей
+ */
+ImageBuffer::ImageBuffer(int width, int height, Format format) {
+  if (width <= 0 || height <= 0 || format == INVALID) return;
+  area = QRect(0, 0, width, height);
+  d = std::make_shared<Data>();
+  d->width = width;
+  d->height = height;
+  d->format = format;
+  d->planes = format == PLANAR8 || format == PLANAR_FLOAT ? 3 : 1;
+  d->stride = alignUp(static_cast<qsizetype>(width) * bytesPerPixel());
+  d->planeSize = d->stride * height;
+  const qsizetype size = d->planeSize * d->planes;
+  d->storage.reset(static_cast<uchar *>(std::aligned_alloc(kAlign, size)));
+  if (!d->storage) throw std::bad_alloc();
+  d->bits = d->storage.get();
+  std::memset(d->bits, 0, size);
+}
+
+/**
+ * @brief Буфер, разделяющий пиксели с QImage без копирования. RGB32,
+ * Grayscale8 и Indexed8 используются как есть, остальные форматы один раз
+ * приводятся к RGB32 (монохромные - к Indexed8)
+ * @param image - изображение
+ */
+ImageBuffer ImageBuffer::fromImage(const QImage &image) {
+  ImageBuffer res;
+  if (image.isNull()) return res;
+  QImage owner = image;
+  Format format = RGB32;
+  switch (image.format()) {
+    case QImage::Format_RGB32:
+      break;
+    case QImage::Format_Grayscale8:
+      format = GRAY8;
+      break;
+    case QImage::Format_Indexed8:
+      format = INDEXED8;
+      break;
+    case QImage::Format_Mono:
+    case QImage::Format_MonoLSB:
+      owner = image.convertToFormat(QImage::Format_Indexed8);
+      format = INDEXED8;
+      break;
+    default:
+      owner = image.convertToFormat(QImage::Format_RGB32);
+  }
+  res.d = std::make_shared<Data>();
+  res.d->width = owner.width();
+  res.d->height = owner.height();
+  res.d->format = format;
+  res.d->stride = owner.bytesPerLine();
+  res.d->planeSize = res.d->stride * owner.height();
+  res.d->bits = const_cast<uchar *>(owner.constBits());
+  if (format == INDEXED8) res.d->colors = owner.colorTable();
+  res.d->owner = owner;
+  res.area = QRect(0, 0, owner.width(), owner.height());
+  return res;
+}
+
+bool ImageBuffer::isNull() const { return !d; }
+
+int ImageBuffer::width() const { return d ? area.width() : 0; }
+
+int ImageBuffer::height() const { return d ? area.height() : 0; }
+
+/**
+ * @brief Прямоугольник изображения (0, 0, ширина, высота)
+ */
+QRect ImageBuffer::rect() const { return QRect(0, 0, width(), height()); }
+
+ImageBuffer::Format ImageBuffer::format() const {
+  return d ? d->format : INVALID;
+}
+
+ImageBuffer::Layout ImageBuffer::layout() const {
+  return planes() > 1 ? PLANAR : INTERLEAVED;
+}
+
+/**
+ * @brief Количество плоскостей (3 для планарных форматов)
+ */
+int ImageBuffer::planes() const { return d ? d->planes : 0; }
+
+/**
+ * @brief Байт на пиксель в одной плоскости
+ */
+int ImageBuffer::bytesPerPixel() const {
+  switch (format()) {
+    case RGB32:
+    case PLANAR_FLOAT:
+      return 4;
+    case GRAY8:
+    case INDEXED8:
+    case PLANAR8:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Байт между началами соседних строк плоскости
+ */
+qsizetype ImageBuffer::stride(int) const { return d ? d->stride : 0; }
+
+/**
+ * @brief Палитра формата INDEXED8
+ */
+QList<QRgb> ImageBuffer::colorTable() const {
+  return d ? d->colors : QList<QRgb>();
+}
+
+/**
+ * @brief Начало плоскости только для чтения (без копирования)
+ * @param plane - номер плоскости
+ */
+const uchar *ImageBuffer::constBits(int plane) const {
+  if (!d) return nullptr;
+  return d->bits + plane * d->planeSize + area.y() * d->stride +
+         area.x() * bytesPerPixel();
+}
+
+/**
+ * @brief Строка плоскости только для чтения
+ * @param y - номер строки
+ * @param plane - номер плоскости
+ */
+const uchar *ImageBuffer::constLine(int y, int plane) const {
+  return constBits(plane) + y * stride(plane);
+}
+
+/**
+ * @brief Начало плоскости для записи; разделяемый буфер сначала копируется
+ * @param plane - номер плоскости
+ */
+uchar *ImageBuffer::bits(int plane) {
+  detach();
+  return const_cast<uchar *>(constBits(plane));
+}
+
+/**
+ * @brief Строка плоскости для записи
+ * @param y - номер строки
+ * @param plane - номер плоскости
+ */
+uchar *ImageBuffer::line(int y, int plane) {
+  return bits(plane) + y * stride(plane);
+}
+
+/**
+ * @brief Область изображения без копирования пикселей: результат ссылается
+ * на те же данные, запись в него копирует только саму область
+ * @param region - прямоугольник в координатах текущего буфера (обрезается
+ * по его границам)
+ * @return область или пустой буфер, если пересечения нет
+ */
+ImageBuffer ImageBuffer::view(const QRect &region) const {
+  QRect clipped = rect().intersected(region);
+  if (!d || clipped.isEmpty()) return ImageBuffer();
+  ImageBuffer res = *this;
+  res.area = QRect(area.x() + clipped.x(), area.y() + clipped.y(),
+                   clipped.width(), clipped.height());
+  return res;
+}
+
+/**
+ * @brief Проверка, что буфер - область другого буфера
+ */
+bool ImageBuffer::isView() const {
+  return d && area != QRect(0, 0, d->width, d->height);
+}
+
+/**
+ * @brief Проверка, что пиксели разделяются с другим объектом (и запись
+ * приведет к копированию): буфер или его QImage имеют других владельцев
+ */
+bool ImageBuffer::isShared() const {
+  return d && (d.use_count() > 1 ||
+               (!d->owner.isNull() && !d->owner.isDetached()));
+}
+
+/**
+ * @brief Копирование пикселей в собственный буфер, если они разделяются.
+ * QImage без других владельцев не копируется: запись идет в его пиксели
+ */
+void ImageBuffer::detach() {
+  if (!isShared()) {
+    if (d && !d->owner.isNull()) {
+      // Qt сам скопирует пиксели, если они только для чтения
+      d->bits = d->owner.bits();
+      d->stride = d->owner.bytesPerLine();
+      d->planeSize = d->stride * d->height;
+    }
+    return;
+  }
+  ImageBuffer copy(width(), height(), d->format);
+  const qsizetype bytes =
+      static_cast<qsizetype>(width()) * copy.bytesPerPixel();
+  for (int p = 0; p < d->planes; ++p)
+    for (int y = 0; y < height(); ++y)
+      std::memcpy(copy.d->bits + p * copy.d->planeSize + y * copy.d->stride,
+                  constLine(y, p), bytes);
+  copy.d->colors = d->colors;
+  *this = std::move(copy);
+}
+
+/**
+ * @brief Преобразование формата через RGB32. Тот же формат - копия
+ * указателя без копирования пикселей
+ * @param format - требуемый формат
+ */
+ImageBuffer ImageBuffer::convertTo(Format format) const {
+  if (!d || format == d->format) return *this;
+  if (format == INVALID) return ImageBuffer();
+  if (format == INDEXED8)
+    return fromImage(toImage().convertToFormat(QImage::Format_Indexed8));
+  const int w = width(), h = height();
+  ImageBuffer rgb = *this;
+  if (d->format != RGB32) {
+    rgb = ImageBuffer(w, h, RGB32);
+    for (int y = 0; y < h; ++y) {
+      auto dst = reinterpret_cast<QRgb *>(rgb.d->bits + y * rgb.d->stride);
+      for (int x = 0; x < w; ++x) {
+        if (d->format == GRAY8) {
+          int v = constLine(y)[x];
+          dst[x] = qRgb(v, v, v);
+        } else if (d->format == INDEXED8) {
+          int index = constLine(y)[x];
+          dst[x] = index < d->colors.size() ? d->colors[index] | 0xff000000u
+                                            : qRgb(0, 0, 0);
+        } else if (d->format == PLANAR8) {
+          dst[x] = qRgb(constLine(y, 0)[x], constLine(y, 1)[x],
+                        constLine(y, 2)[x]);
+        } else {
+          int c[3];
+          for (int p = 0; p < 3; ++p) {
+            float v = reinterpret_cast<const float *>(constLine(y, p))[x];
+            c[p] = static_cast<int>(std::lround(std::clamp(v, 0.0f, 255.0f)));
+          }
+          dst[x] = qRgb(c[0], c[1], c[2]);
+        }
+      }
+    }
+  }
+  if (format == RGB32) return rgb;
+  ImageBuffer res(w, h, format);
+  for (int y = 0; y < h; ++y) {
+    auto src = reinterpret_cast<const QRgb *>(rgb.constLine(y));
+    for (int x = 0; x < w; ++x) {
+      const int c[3] = {qRed(src[x]), qGreen(src[x]), qBlue(src[x])};
+      if (format == GRAY8) {
+        res.d->bits[y * res.d->stride + x] =
+            static_cast<uchar>(qGray(c[0], c[1], c[2]));
+        continue;
+      }
+      for (int p = 0; p < 3; ++p) {
+        uchar *row = res.d->bits + p * res.d->planeSize + y * res.d->stride;
+        if (format == PLANAR8)
+          row[x] = static_cast<uchar>(c[p]);
+        else
+          reinterpret_cast<float *>(row)[x] = static_cast<float>(c[p]);
+      }
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Уменьшенная копия (прокси для предпросмотра): вписывается в
+ * bound с сохранением пропорций, каждый пиксель - среднее своего
+ * прямоугольника исходных пикселей. Изображение не больше bound
+ * возвращается без копирования
+ * @param bound - наибольший размер
+ * @return RGB32
+ */
+ImageBuffer ImageBuffer::downscaled(const QSize &bound) const {
+  if (!d || bound.width() <= 0 || bound.height() <= 0) return ImageBuffer();
+  const int w = width(), h = height();
+  if (w <= bound.width() && h <= bound.height()) return convertTo(RGB32);
+  const double factor = std::min(double(bound.width()) / w,
+                                 double(bound.height()) / h);
+  const int dw = std::max(1, static_cast<int>(std::lround(w * factor)));
+  const int dh = std::max(1, static_cast<int>(std::lround(h * factor)));
+  ImageBuffer rgb = convertTo(RGB32);
+  ImageBuffer res(dw, dh, RGB32);
+  // границы прямоугольников: столбцы [cols[i], cols[i + 1])
+  std::vector<int> cols(dw + 1);
+  for (int dx = 0; dx <= dw; ++dx)
+    cols[dx] = static_cast<int>(qint64(dx) * w / dw);
+  std::vector<unsigned> sums(static_cast<std::size_t>(dw) * 3);
+  for (int dy = 0; dy < dh; ++dy) {
+    const int y0 = static_cast<int>(qint64(dy) * h / dh);
+    const int y1 = static_cast<int>(qint64(dy + 1) * h / dh);
+    std::fill(sums.begin(), sums.end(), 0u);
+    for (int y = y0; y < y1; ++y) {
+      auto src = reinterpret_cast<const QRgb *>(rgb.constLine(y));
+      for (int dx = 0; dx < dw; ++dx)
+        for (int x = cols[dx]; x < cols[dx + 1]; ++x) {
+          sums[dx * 3] += qRed(src[x]);
+          sums[dx * 3 + 1] += qGreen(src[x]);
+          sums[dx * 3 + 2] += qBlue(src[x]);
+        }
+    }
+    auto dst = reinterpret_cast<QRgb *>(res.d->bits + dy * res.d->stride);
+    for (int dx = 0; dx < dw; ++dx) {
+      const unsigned count = unsigned(y1 - y0) * (cols[dx + 1] - cols[dx]);
+      dst[dx] = qRgb((sums[dx * 3] + count / 2) / count,
+                     (sums[dx * 3 + 1] + count / 2) / count,
+                     (sums[dx * 3 + 2] + count / 2) / count);
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief QImage для отображения и сохранения. Для RGB32 и GRAY8 пиксели не
+ * копируются: QImage ссылается на буфер (только для чтения, Qt скопирует
+ * их сам при записи) и удерживает его, пока жив. Для области это
+ * обрезка без копирования
+ */
+QImage ImageBuffer::toImage() const {
+  if (!d) return QImage();
+  if (!d->owner.isNull() && !isView()) return d->owner;
+  if (d->format == PLANAR8 || d->format == PLANAR_FLOAT)
+    return convertTo(RGB32).toImage();
+  if (d->format == INDEXED8) {
+    QImage res(width(), height(), QImage::Format_Indexed8);
+    for (int y = 0; y < height(); ++y)
+      std::memcpy(res.scanLine(y), constLine(y), width());
+    res.setColorTable(d->colors);
+    return res;
+  }
+  auto keep = new std::shared_ptr<Data>(d);
+  return QImage(
+      constBits(), width(), height(), d->stride,
+      d->format == GRAY8 ? QImage::Format_Grayscale8 : QImage::Format_RGB32,
+      [](void *info) { delete static_cast<std::shared_ptr<Data> *>(info); },
+      keep);
+}
+}  // namespace model
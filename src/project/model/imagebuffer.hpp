@@ -0,0 +1,63 @@
+#ifndef IMAGEBUFFER_HPP
+#define IMAGEBUFFER_HPP
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <cstddef>
+#include <memory>
+
+namespace model {
+/**
+ * @brief Изображение с общим буфером и копированием при записи. Копия
+ * объекта - это копия указателя, пиксели копируются только при записи в
+ * буфер, которым владеет больше одного объекта. Буфер, полученный из
+ * QImage, разделяется с ним без копирования. Область (view) - окно в
+ * пикселях родителя без копирования
+ */
+class ImageBuffer {
+ public:
+  /**
+   * @brief Формат пикселей: RGB32 - 0xffRRGGBB, GRAY8 - байт яркости,
+   * INDEXED8 - индекс палитры, PLANAR8 и PLANAR_FLOAT - три плоскости
+   * R, G, B (байты или float 0..255)
+   */
+  enum Format { INVALID, RGB32, GRAY8, INDEXED8, PLANAR8, PLANAR_FLOAT };
+  enum Layout { INTERLEAVED, PLANAR };
+
+  ImageBuffer() = default;
+  ImageBuffer(int width, int height, Format format);
+  static ImageBuffer fromImage(const QImage &image);
+
+  bool isNull() const;
+  int width() const;
+  int height() const;
+  QRect rect() const;
+  Format format() const;
+  Layout layout() const;
+  int planes() const;
+  int bytesPerPixel() const;
+  qsizetype stride(int plane = 0) const;
+  QList<QRgb> colorTable() const;
+
+  const uchar *constBits(int plane = 0) const;
+  const uchar *constLine(int y, int plane = 0) const;
+  uchar *bits(int plane = 0);
+  uchar *line(int y, int plane = 0);
+
+  ImageBuffer view(const QRect &region) const;
+  bool isView() const;
+  bool isShared() const;
+  void detach();
+  ImageBuffer convertTo(Format format) const;
+  ImageBuffer downscaled(const QSize &bound) const;
+  QImage toImage() const;
+
+ private:
+  struct Data;
+  std::shared_ptr<Data> d;
+  QRect area;
+};
+}  // namespace model
+
+#endif
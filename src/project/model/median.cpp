@@ -0,0 +1,148 @@
+#include "median.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#include "channel.hpp"
+
+namespace model {
+namespace median {
+namespace {
+// корзин грубой гистограммы (старшие 4 бита), в каждой 16 точных
+constexpr int kCoarse = 16;
+constexpr int kFine = 256;
+// столбцов в полосе: точные гистограммы полосы - около 128 КБ
+constexpr int kTileColumns = 256;
+
+inline void add16(std::uint16_t *__restrict dst,
+                  const std::uint16_t *__restrict src) {
+  for (int i = 0; i < kCoarse; ++i) dst[i] += src[i];
+}
+
+inline void sub16(std::uint16_t *__restrict dst,
+                  const std::uint16_t *__restrict src) {
+  for (int i = 0; i < kCoarse; ++i) dst[i] -= src[i];
+}
+}  // namespace
+
+/**
+ * @brief Медиана окна (2 radius + 1)^2 по плоскости за O(1) на пиксель
+ * (Perreault, Hebert): у каждого столбца своя гистограмма окна по высоте,
+ * она сдвигается вниз на строку двумя изменениями. Гистограмма окна -
+ * сумма гистограмм столбцов - сдвигается вправо вычитанием и добавлением
+ * одного столбца. Гистограммы двухуровневые: грубая (16 корзин) ведется
+ * всегда, точная - только для корзины, где найдена медиана, и догоняет
+ * пропущенные сдвиги при обращении. Плоскость обрабатывается полосами по
+ * kTileColumns столбцов, чтобы гистограммы столбцов помещались в кеш.
+ * За краями плоскости повторяются крайние строки и столбцы
+ * @param src - плоскость rows x width
+ * @param width - ширина
+ * @param rows - число строк
+ * @param radius - радиус окна 0..kMaxRadius
+ * @param lo - первая строка результата
+ * @param hi - строка после последней строки результата
+ * @param dst - результат (hi - lo) x width
+ */
+void plane(const std::uint8_t *src, int width, int rows, int radius, int lo,
+           int hi, std::uint8_t *dst) {
+  if (width <= 0 || rows <= 0 || hi <= lo) return;
+  const int r = std::clamp(radius, 0, kMaxRadius);
+  const int n = 2 * r + 1;
+  const int half = n * n / 2;
+  auto line = [&](int y) {
+    return src + static_cast<std::size_t>(std::clamp(y, 0, rows - 1)) * width;
+  };
+  std::vector<std::uint16_t> fine, coarse;
+
+  for (int x0 = 0; x0 < width; x0 += kTileColumns) {
+    const int x1 = std::min(width, x0 + kTileColumns);
+    const int c0 = std::max(0, x0 - r);
+    const int cols = std::min(width, x1 + r) - c0;
+    // точные гистограммы по корзинам: корзина b всех столбцов подряд
+    fine.assign(static_cast<std::size_t>(cols) * kFine, 0);
+    coarse.assign(static_cast<std::size_t>(cols) * kCoarse, 0);
+    auto column = [&](int x) { return std::clamp(x, 0, width - 1) - c0; };
+    auto fineAt = [&](int col, int b) {
+      return &fine[(static_cast<std::size_t>(b) * cols + col) * kCoarse];
+    };
+    auto count = [&](int col, std::uint8_t v, int delta) {
+      fineAt(col, v >> 4)[v & 15] += delta;
+      coarse[col * kCoarse + (v >> 4)] += delta;
+    };
+    for (int dy = -r; dy <= r; ++dy) {
+      const std::uint8_t *p = line(lo + dy) + c0;
+      for (int col = 0; col < cols; ++col) count(col, p[col], 1);
+    }
+
+    for (int y = lo; y < hi; ++y) {
+      if (y > lo) {
+        const std::uint8_t *gone = line(y - r - 1) + c0;
+        const std::uint8_t *next = line(y + r) + c0;
+        for (int col = 0; col < cols; ++col) {
+          if (gone[col] == next[col]) continue;
+          count(col, gone[col], -1);
+          count(col, next[col], 1);
+        }
+      }
+
+      std::uint16_t kc[kCoarse] = {};
+      std::uint16_t kf[kCoarse][kCoarse] = {};
+      int last[kCoarse];
+      std::fill(last, last + kCoarse, INT_MIN / 2);
+      for (int dx = -r; dx <= r; ++dx)
+        add16(kc, &coarse[column(x0 + dx) * kCoarse]);
+
+      std::uint8_t *out = dst + static_cast<std::size_t>(y - lo) * width;
+      for (int x = x0; x < x1; ++x) {
+        if (x > x0) {
+          sub16(kc, &coarse[column(x - r - 1) * kCoarse]);
+          add16(kc, &coarse[column(x + r) * kCoarse]);
+        }
+        int sum = 0, b = 0;
+        for (; b < kCoarse - 1 && sum + kc[b] <= half; ++b) sum += kc[b];
+
+        // точная гистограмма корзины b догоняет окно в столбце x
+        std::uint16_t *bins = kf[b];
+        if (x - last[b] >= n) {
+          std::memset(bins, 0, sizeof(kf[b]));
+          for (int dx = -r; dx <= r; ++dx)
+            add16(bins, fineAt(column(x + dx), b));
+        } else {
+          for (int j = last[b] + 1; j <= x; ++j) {
+            sub16(bins, fineAt(column(j - r - 1), b));
+            add16(bins, fineAt(column(j + r), b));
+          }
+        }
+        last[b] = x;
+
+        int v = 0;
+        for (; v < kCoarse - 1 && sum + bins[v] <= half; ++v) sum += bins[v];
+        out[x] = std::uint8_t(b * kCoarse + v);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Медианный фильтр как оконный фильтр полосы: каналы считаются
+ * отдельно, серая полоса - одной плоскостью
+ * @param radius - радиус окна 1..kMaxRadius
+ */
+window::Filter filter(int radius) {
+  radius = std::clamp(radius, 1, kMaxRadius);
+  return [radius](const window::Strip &in, int lo, int hi, QRgb *out) {
+    const int channels = window::isGray(in) ? 1 : 3;
+    window::Plane source, planes[3];
+    for (int c = 0; c < channels; ++c) {
+      window::split(in, channels == 1 ? BLUE : c, source);
+      planes[c].resize(static_cast<std::size_t>(hi - lo) * in.width);
+      plane(source.data(), in.width, in.count, radius, lo - in.first,
+            hi - in.first, planes[c].data());
+    }
+    window::merge(planes, channels, in.width, hi - lo, out);
+  };
+}
+}  // namespace median
+}  // namespace model
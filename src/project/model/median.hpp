@@ -0,0 +1,18 @@
+#ifndef MEDIAN_HPP
+#define MEDIAN_HPP
+
+#include <cstdint>
+
+#include "window.hpp"
+
+namespace model {
+namespace median {
+constexpr int kMaxRadius = 15;
+
+void plane(const std::uint8_t *src, int width, int rows, int radius, int lo,
+           int hi, std::uint8_t *dst);
+window::Filter filter(int radius);
+}  // namespace median
+}  // namespace model
+
+#endif
@@ -0,0 +1,105 @@
+#include "metrics.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+#include "perthread.hpp"
+
+namespace {
+struct Timing {
+  double total = 0;
+  long long calls = 0;
+};
+
+// метрики одного потока: счетчики пишутся без общей блокировки и
+// складываются при отчете
+struct Values {
+  std::map<std::string, long long> counters;
+  std::map<std::string, Timing> timings;
+
+  void merge(const Values &other) {
+    for (auto const &[name, value] : other.counters) counters[name] += value;
+    for (auto const &[stage, timing] : other.timings) {
+      timings[stage].total += timing.total;
+      timings[stage].calls += timing.calls;
+    }
+  }
+};
+
+using Metrics = model::PerThread<Values>;
+
+/**
+ * @brief Сумма метрик всех потоков
+ */
+Values collect() {
+  Values res;
+  Metrics::forEach([&res](Values &values) { res.merge(values); });
+  return res;
+}
+}  // namespace
+
+namespace model {
+namespace metrics {
+
+/**
+ * @brief Увеличение счетчика
+ * @param name - имя счетчика (например, convolution.tiles)
+ * @param delta - приращение
+ */
+void count(const std::string &name, long long delta) {
+  Metrics::update([&](Values &values) { values.counters[name] += delta; });
+}
+
+/**
+ * @brief Учет времени этапа
+ * @param stage - имя этапа
+ * @param milliseconds - длительность
+ */
+void time(const std::string &stage, double milliseconds) {
+  Metrics::update([&](Values &values) {
+    auto &timing = values.timings[stage];
+    timing.total += milliseconds;
+    ++timing.calls;
+  });
+}
+
+/**
+ * @brief Значение счетчика (0, если его нет)
+ */
+long long counter(const std::string &name) {
+  long long res = 0;
+  Metrics::forEach([&](Values &values) {
+    auto found = values.counters.find(name);
+    if (found != values.counters.end()) res += found->second;
+  });
+  return res;
+}
+
+/**
+ * @brief Копия всех счетчиков
+ */
+std::map<std::string, long long> counters() { return collect().counters; }
+
+/**
+ * @brief Текстовый отчет: время по этапам и счетчики
+ */
+std::string report() {
+  const Values values = collect();
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(2);
+  for (auto const &[stage, timing] : values.timings)
+    out << stage << ": " << timing.total << " ms in " << timing.calls
+        << " calls\n";
+  for (auto const &[name, value] : values.counters)
+    out << name << ": " << value << "\n";
+  return out.str();
+}
+
+/**
+ * @brief Сброс всех метрик
+ */
+void reset() {
+  Metrics::forEach([](Values &values) { values = Values(); });
+}
+}  // namespace metrics
+}  // namespace model
@@ -0,0 +1,18 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <map>
+#include <string>
+
+namespace model {
+namespace metrics {
+void count(const std::string &name, long long delta = 1);
+void time(const std::string &stage, double milliseconds);
+long long counter(const std::string &name);
+std::map<std::string, long long> counters();
+std::string report();
+void reset();
+}  // namespace metrics
+}  // namespace model
+
+#endif
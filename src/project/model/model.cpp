@@ -1,6 +1,8 @@
 
 #include "model.hpp"
 
+#include "colormatrix.hpp"
+
 /**
  * @brief s
  *
@@ -139,38 +141,51 @@ void changeImg(QImage &img, std::vector<std::vector<float>> const &vectorImg) {
 using namespace model;
 
 /**
- * @brief - получение финального изображения и передача в контроллер
- * @param filter - ядро свертки
- * @return - результат работы свертки
+ * @brief - применение свертки к изображению движком цепочки (полосы,
+ * потоки, одноканальный режим для серых изображений)
+ * @param img - изображение, которое будет изменено
+ * @param filter - ядро свертки NxN
+ * @param lumaOnly - сворачивать только яркость Y (YCbCr), цвет не меняется
+ * @param roi - область (пустая - все изображение); края области читаются
+ * из соседних пикселей, остальное изображение не меняется
  */
 
-QPixmap convolution::getResultingImage(const std::vector<float> &filter) {
-  QImage img(model::programData.filename);
-  std::vector<std::vector<float>> vectorImage = imgToVectors(img);
-
-  s21::S21Matrix imgRED =
-      s21::S21Matrix(img.height(), img.width(), vectorImage[RED]);
-  s21::S21Matrix imgGREEN =
-      s21::S21Matrix(img.height(), img.width(), vectorImage[GREEN]);
-  s21::S21Matrix imgBLUE =
-      s21::S21Matrix(img.height(), img.width(), vectorImage[BLUE]);
-  s21::S21Matrix test = s21::S21Matrix(3, 3, filter);
-
-  s21::S21Matrix resRED = foldExp(imgRED, test);
-  s21::S21Matrix resGREEN = foldExp(imgGREEN, test);
-  s21::S21Matrix resBLUE = foldExp(imgBLUE, test);
-
-  vectorImage[RED] = unpack(resRED);
-  vectorImage[GREEN] = unpack(resGREEN);
-  vectorImage[BLUE] = unpack(resBLUE);
+void convolution::apply(QImage &img, const std::vector<float> &filter,
+                        bool lumaOnly, const QRect &roi) {
+  pipeline::Pipeline single;
+  single.push(
+      pipeline::Operation::convolution("convolution", filter, lumaOnly));
+  if (roi.isNull()) {
+    img = single.run(img);
+    return;
+  }
+  img = single.run(ImageBuffer::fromImage(img), roi).toImage();
+}
 
-  changeImg(img, vectorImage);
+/**
+ * @brief - получение финального изображения и сохранение в сеанс.
+ * Повторный запрос того же ядра для того же изображения берется из кеша
+ * сеанса
+ * @param data - сеанс (исходное изображение и результат)
+ * @param filter - ядро свертки
+ * @param lumaOnly - сворачивать только яркость Y
+ * @return - результат работы свертки
+ */
 
-  model::programData.resultingImage = QImage(img);
-  if (model::programData.resultingImage.isNull())
-    std::cerr << "error saving image\n";
+QPixmap convolution::getResultingImage(s21::ProgramData &data,
+                                       const std::vector<float> &filter,
+                                       bool lumaOnly) {
+  pipeline::Pipeline single;
+  single.push(
+      pipeline::Operation::convolution("convolution", filter, lumaOnly));
+  const cache::Key key{data.sourceHash, single.digest()};
+  if (!data.cache || !data.cache->find(key, data.resultingImage)) {
+    data.resultingImage = single.run(data.sourceImage);
+    if (data.cache) data.cache->insert(key, data.resultingImage);
+  }
+  if (data.resultingImage.isNull()) std::cerr << "error saving image\n";
 
-  return QPixmap::fromImage(img);
+  return QPixmap::fromImage(data.resultingImage.toImage());
 }
 
 /**
@@ -180,33 +195,9 @@ QPixmap convolution::getResultingImage(const std::vector<float> &filter) {
  */
 
 void simple::grayscale(QImage &img, char type) {
-  QColor color;
-  float r, g, b;
-  float c;
-
-  for (int x = 0; x < img.width(); ++x) {
-    for (int y = 0; y < img.height(); ++y) {
-      color = img.pixelColor(x, y);
-      color.getRgbF(&r, &g, &b);
-
-      switch (type) {
-        case AVERAGE:
-          c = r * 0.333f + g * 0.333f + b * 0.333f;
-          break;
-        case LUMA:
-          c = r * 0.299f + g * 0.587f +
-              b * 0.114f;  // немного отличается, видимо, из-за float
-          break;
-        case DISSAT:
-          c = (std::min(std::min(r, g), b) + std::max(std::max(r, g), b)) / 2;
-          break;
-        default:
-          c = r * 0.299f + g * 0.587f + b * 0.114f;
-      }
-      color.setRgbF(c, c, c);
-      img.setPixelColor(x, y, color);
-    }
-  }
+  pointop::Program program;
+  program.append(pointop::grayscale(type));
+  program.apply(img);
 }
 
 /**
@@ -215,38 +206,41 @@ void simple::grayscale(QImage &img, char type) {
  */
 
 void simple::negative(QImage &img) {
-  QColor color;
-  float r, g, b;
-
-  for (int x = 0; x < img.width(); ++x) {
-    for (int y = 0; y < img.height(); ++y) {
-      color = img.pixelColor(x, y);
-      color.getRgbF(&r, &g, &b);
-      color.setRgbF(1.0f - r, 1.0f - g, 1.0f - b);
-      img.setPixelColor(x, y, color);
-    }
-  }
+  pointop::Program program;
+  program.append(pointop::negative());
+  program.apply(img);
 }
 
 /**
- * @brief - базовый фильтр тонирование
+ * @brief - базовый фильтр тонирование (серый LUMA и тон за один проход)
  * @param img - исходное изображение
  * @param tone - цвет тонирования
  */
 
 void simple::toning(QImage &img, QColor tone) {
-  QColor color;
-  float r, g, b;
-  float rT, gT, bT;
+  pointop::Program program;
+  program.append(pointop::toning(tone));
+  program.apply(img);
+}
 
-  grayscale(img, LUMA);
-  tone.getRgbF(&rT, &gT, &bT);
-  for (int x = 0; x < img.width(); ++x) {
-    for (int y = 0; y < img.height(); ++y) {
-      color = img.pixelColor(x, y);
-      color.getRgbF(&r, &g, &b);
-      color.setRgbF(rT * r, gT * g, bT * b);
-      img.setPixelColor(x, y, color);
-    }
-  }
+/**
+ * @brief - базовый фильтр сепия
+ * @param img - исходное изображение
+ */
+
+void simple::sepia(QImage &img) {
+  pointop::Program program;
+  program.append(pointop::sepia());
+  program.apply(img);
+}
+
+/**
+ * @brief - пользовательская цветовая матрица (векторное ядро, строки
+ * делятся между потоками)
+ * @param img - исходное изображение
+ * @param matrix - матрица 3x4, значения каналов 0..255
+ */
+
+void simple::colorMatrix(QImage &img, const pointop::Matrix &matrix) {
+  colormatrix::apply(img, matrix);
 }
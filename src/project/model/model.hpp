@@ -5,16 +5,17 @@
 #include <QPixmap>
 #include <QString>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "cache.hpp"
+#include "channel.hpp"
+#include "history.hpp"
+#include "imagebuffer.hpp"
+#include "pipeline.hpp"
+#include "pointop.hpp"
 #include "s21_matrix.h"
-#define RED 0
-#define GREEN 1
-#define BLUE 2
-#define AVERAGE 'a'
-#define LUMA 'l'
-#define DISSAT 'd'
 
 s21::S21Matrix addDefaultValues(s21::S21Matrix image, int offset);
 s21::S21Matrix getFoldMatrix(s21::S21Matrix &build_matrix, int row_pxl_idx,
@@ -24,23 +25,44 @@ std::vector<std::vector<float>> imgToVectors(QImage const &img);
 void changeImg(QImage &img, std::vector<std::vector<float>> const &vectorImg);
 
 namespace s21 {
+/**
+ * @brief Состояние одного сеанса работы с изображением. Передается явно в
+ * вызовы контроллера и модели, общих изменяемых данных нет, поэтому
+ * независимые сеансы можно обрабатывать в разных потоках одновременно.
+ * Кеш результатов принадлежит сеансу (у сеансов предпросмотра, см.
+ * controller::proxy, его нет) и защищен мьютексом; sourceHash -
+ * хеш содержимого sourceImage, первая часть ключа кеша. history - правки
+ * цепочки для отмены и повтора со снимками результатов
+ */
 struct ProgramData {
-  static inline QImage resultingImage{nullptr};
-  static inline bool isValidImage{false};
-  static inline QString filename{};
+  model::ImageBuffer sourceImage{};
+  model::ImageBuffer resultingImage{};
+  bool isValidImage{false};
+  QString filename{};
+  model::pipeline::Pipeline chain{};
+  std::vector<float> custom{};
+  std::uint64_t sourceHash{0};
+  std::shared_ptr<model::cache::ResultCache> cache{
+      std::make_shared<model::cache::ResultCache>()};
+  model::history::History history{};
 };
 }  // namespace s21
 
 namespace model {
-static s21::ProgramData programData;
 namespace simple {
 void grayscale(QImage &img, char type);
 void negative(QImage &img);
 void toning(QImage &img, QColor tone);
+void sepia(QImage &img);
+void colorMatrix(QImage &img, const pointop::Matrix &matrix);
 }  // namespace simple
 
 namespace convolution {
-QPixmap getResultingImage(const std::vector<float> &filter);
+void apply(QImage &img, const std::vector<float> &filter,
+           bool lumaOnly = false, const QRect &roi = QRect());
+QPixmap getResultingImage(s21::ProgramData &data,
+                          const std::vector<float> &filter,
+                          bool lumaOnly = false);
 }  // namespace convolution
 
 namespace filter {
@@ -54,7 +76,6 @@ static const std::vector<float> gaussianBlur{1 / 16.0, 2 / 16.0, 1 / 16.0,
 static const std::vector<float> leplacianFilter{-1, -1, -1, -1, 8,
                                                 -1, -1, -1, -1};
 static const std::vector<float> sobelLeft{1, 0, -1, 2, 0, -2, 1, 0, -1};
-static std::vector<float> custom;
 }  // namespace filter
 
 }  // namespace model
@@ -0,0 +1,288 @@
+#include "morphology.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "cpu.hpp"
+#include "channel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MORPHOLOGY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+// строк в группе прохода по строкам: столбец группы - один вектор SSE2
+constexpr int kLanes = 16;
+
+// dst = min(a, b) или max(a, b) по байтам
+using Combine = void (*)(const std::uint8_t *, const std::uint8_t *,
+                         std::uint8_t *, std::size_t);
+
+template <bool kMax>
+void combineScalar(const std::uint8_t *a, const std::uint8_t *b,
+                   std::uint8_t *dst, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    dst[i] = kMax ? std::max(a[i], b[i]) : std::min(a[i], b[i]);
+}
+
+#ifdef MORPHOLOGY_X86
+template <bool kMax>
+__attribute__((target("sse2"))) void combineSse2(const std::uint8_t *a,
+                                                 const std::uint8_t *b,
+                                                 std::uint8_t *dst,
+                                                 std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i va =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const __m128i vb =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     kMax ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb));
+  }
+  combineScalar<kMax>(a + i, b + i, dst + i, count - i);
+}
+
+template <bool kMax>
+__attribute__((target("avx2"))) void combineAvx2(const std::uint8_t *a,
+                                                 const std::uint8_t *b,
+                                                 std::uint8_t *dst,
+                                                 std::size_t count) {
+  std::size_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        kMax ? _mm256_max_epu8(va, vb)
+                             : _mm256_min_epu8(va, vb));
+  }
+  combineSse2<kMax>(a + i, b + i, dst + i, count - i);
+}
+#endif
+
+model::cpu::Level kernelLevel() {
+  return model::cpu::pick({model::cpu::AVX2, model::cpu::SSE2});
+}
+
+Combine combineKernel(bool maximum) {
+#ifdef MORPHOLOGY_X86
+  if (kernelLevel() == model::cpu::AVX2)
+    return maximum ? combineAvx2<true> : combineAvx2<false>;
+  return maximum ? combineSse2<true> : combineSse2<false>;
+#else
+  return maximum ? combineScalar<true> : combineScalar<false>;
+#endif
+}
+
+/**
+ * @brief Минимум или максимум скользящего окна 2 r + 1 линий (van Herk,
+ * Gil-Werman): линии делятся на блоки по 2 r + 1, в каждом блоке
+ * накапливаются префиксы g слева и суффиксы h справа. Окно, начатое с
+ * линии i, захватывает конец одного блока и начало следующего, поэтому
+ * результат - combine(h[i], g[i + 2 r]): три операции на линию при любом r.
+ * Суффиксы не хранятся: результат считается на обратном проходе. Линия -
+ * bytes байт, все линии обрабатываются векторным ядром целиком
+ * @param lines - count + 2 r входных линий (края уже повторены)
+ * @param count - число линий результата
+ * @param r - радиус окна
+ * @param bytes - байт в линии
+ * @param combine - ядро минимума или максимума
+ * @param out - count линий результата
+ */
+void runs(const std::uint8_t *const *lines, int count, int r,
+          std::size_t bytes, Combine combine, std::uint8_t *const *out) {
+  const int n = count + 2 * r, block = 2 * r + 1;
+  std::vector<std::uint8_t> g(n * bytes), h(bytes);
+  for (int j = 0, at = 0; j < n; ++j, at = at + 1 == block ? 0 : at + 1) {
+    std::uint8_t *line = g.data() + j * bytes;
+    if (at == 0)
+      std::memcpy(line, lines[j], bytes);
+    else
+      combine(line - bytes, lines[j], line, bytes);
+  }
+  for (int j = n - 1, at = (n - 1) % block; j >= 0; --j, --at) {
+    if (j == n - 1 || at == block - 1)
+      std::memcpy(h.data(), lines[j], bytes);
+    else
+      combine(h.data(), lines[j], h.data(), bytes);
+    if (j < count)
+      combine(h.data(), g.data() + (j + 2 * r) * bytes, out[j], bytes);
+    if (at == 0) at = block;
+  }
+}
+
+#ifdef MORPHOLOGY_X86
+template <bool kMax>
+__attribute__((target("sse2"))) inline __m128i extreme(__m128i a, __m128i b) {
+  return kMax ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+}
+
+/**
+ * @brief То же для линий из kLanes байт (группа строк прохода по строкам):
+ * линия - один регистр SSE2, без вызова ядра на каждую линию
+ */
+template <bool kMax>
+__attribute__((target("sse2"))) void lanesSse2(
+    const std::uint8_t *const *lines, int count, int r,
+    std::uint8_t *const *out) {
+  const int n = count + 2 * r, block = 2 * r + 1;
+  std::vector<std::uint8_t> g(std::size_t(n) * kLanes);
+  auto prefix = [&g](int j) {
+    return reinterpret_cast<__m128i *>(g.data() + std::size_t(j) * kLanes);
+  };
+  __m128i acc = _mm_setzero_si128();
+  for (int j = 0, at = 0; j < n; ++j, at = at + 1 == block ? 0 : at + 1) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[j]));
+    acc = at == 0 ? v : extreme<kMax>(acc, v);
+    _mm_storeu_si128(prefix(j), acc);
+  }
+  for (int j = n - 1, at = (n - 1) % block; j >= 0; --j, --at) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[j]));
+    acc = j == n - 1 || at == block - 1 ? v : extreme<kMax>(acc, v);
+    if (j < count) {
+      const __m128i next = _mm_loadu_si128(prefix(j + 2 * r));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out[j]),
+                       extreme<kMax>(acc, next));
+    }
+    if (at == 0) at = block;
+  }
+}
+#endif
+
+/**
+ * @brief Проход по столбцам: окно 2 r + 1 строк, строки [lo, hi) по
+ * плоскости rows x width, за краями повторяются крайние строки
+ */
+void vertical(const std::uint8_t *src, int width, int rows, int r, int lo,
+              int hi, Combine combine, std::uint8_t *dst) {
+  std::vector<const std::uint8_t *> lines(hi - lo + 2 * r);
+  for (int j = 0; j < int(lines.size()); ++j)
+    lines[j] = src + std::size_t(std::clamp(lo - r + j, 0, rows - 1)) * width;
+  std::vector<std::uint8_t *> out(hi - lo);
+  for (int i = 0; i < hi - lo; ++i) out[i] = dst + std::size_t(i) * width;
+  runs(lines.data(), hi - lo, r, width, combine, out.data());
+}
+
+/**
+ * @brief Проход по строкам: окно 2 r + 1 столбцов, за краями повторяются
+ * крайние столбцы. Строки идут группами по kLanes: группа транспонируется
+ * так, что столбец становится линией из kLanes байт - одним регистром
+ */
+void horizontal(std::uint8_t *plane, int width, int count, int r,
+                bool maximum) {
+  if (r == 0) return;
+  std::vector<std::uint8_t> in(std::size_t(width) * kLanes),
+      res(std::size_t(width) * kLanes);
+  std::vector<const std::uint8_t *> lines(width + 2 * r);
+  for (int j = 0; j < int(lines.size()); ++j)
+    lines[j] = in.data() + std::clamp(j - r, 0, width - 1) * kLanes;
+  std::vector<std::uint8_t *> out(width);
+  for (int x = 0; x < width; ++x) out[x] = res.data() + x * kLanes;
+  for (int y0 = 0; y0 < count; y0 += kLanes) {
+    const int lanes = std::min(kLanes, count - y0);
+    for (int lane = 0; lane < kLanes; ++lane) {
+      // неполная группа дополняется последней строкой
+      const std::uint8_t *line =
+          plane + std::size_t(y0 + std::min(lane, lanes - 1)) * width;
+      for (int x = 0; x < width; ++x) in[x * kLanes + lane] = line[x];
+    }
+#ifdef MORPHOLOGY_X86
+    if (maximum)
+      lanesSse2<true>(lines.data(), width, r, out.data());
+    else
+      lanesSse2<false>(lines.data(), width, r, out.data());
+#else
+    runs(lines.data(), width, r, kLanes, combineKernel(maximum), out.data());
+#endif
+    for (int lane = 0; lane < lanes; ++lane) {
+      std::uint8_t *line = plane + std::size_t(y0 + lane) * width;
+      for (int x = 0; x < width; ++x) line[x] = res[x * kLanes + lane];
+    }
+  }
+}
+}  // namespace
+
+namespace model {
+namespace morphology {
+/**
+ * @brief Морфологическая операция над плоскостью с прямоугольным
+ * элементом (2 radiusX + 1) x (2 radiusY + 1) за постоянное на пиксель
+ * время при любом размере элемента: проход по столбцам, затем по строкам.
+ * Открытие и закрытие - две операции подряд, промежуточный результат
+ * считается на radiusY строк шире. За краями плоскости повторяются крайние
+ * строки и столбцы (для минимума и максимума это то же, что не учитывать
+ * пиксели за краем)
+ * @param src - плоскость rows x width
+ * @param width - ширина
+ * @param rows - число строк
+ * @param mode - операция
+ * @param radiusX - радиус элемента по горизонтали 0..kMaxRadius
+ * @param radiusY - радиус элемента по вертикали 0..kMaxRadius
+ * @param lo - первая строка результата
+ * @param hi - строка после последней строки результата
+ * @param dst - результат (hi - lo) x width
+ */
+void plane(const std::uint8_t *src, int width, int rows, Mode mode,
+           int radiusX, int radiusY, int lo, int hi, std::uint8_t *dst) {
+  if (width <= 0 || rows <= 0 || hi <= lo) return;
+  const int rx = std::clamp(radiusX, 0, kMaxRadius);
+  const int ry = std::clamp(radiusY, 0, kMaxRadius);
+  if (mode == OPEN || mode == CLOSE) {
+    const int a = std::max(0, lo - ry), b = std::min(rows, hi + ry);
+    std::vector<std::uint8_t> middle(std::size_t(b - a) * width);
+    plane(src, width, rows, mode == OPEN ? ERODE : DILATE, rx, ry, a, b,
+          middle.data());
+    plane(middle.data(), width, b - a, mode == OPEN ? DILATE : ERODE, rx, ry,
+          lo - a, hi - a, dst);
+    return;
+  }
+  vertical(src, width, rows, ry, lo, hi, combineKernel(mode == DILATE),
+           dst);
+  horizontal(dst, width, hi - lo, rx, mode == DILATE);
+}
+
+/**
+ * @brief Запас строк и столбцов для операции: у открытия и закрытия - два
+ * элемента
+ * @param mode - операция
+ * @param radiusX - радиус элемента по горизонтали
+ * @param radiusY - радиус элемента по вертикали
+ */
+int radius(Mode mode, int radiusX, int radiusY) {
+  const int r = std::clamp(std::max(radiusX, radiusY), 0, kMaxRadius);
+  return mode == OPEN || mode == CLOSE ? 2 * r : r;
+}
+
+/**
+ * @brief Морфологическая операция как оконный фильтр: каждый канал
+ * отдельно, у серой полосы - один
+ * @param mode - операция
+ * @param radiusX - радиус элемента по горизонтали 0..kMaxRadius
+ * @param radiusY - радиус элемента по вертикали 0..kMaxRadius
+ */
+window::Filter filter(Mode mode, int radiusX, int radiusY) {
+  return [=](const window::Strip &in, int lo, int hi, QRgb *out) {
+    const int channels = window::isGray(in) ? 1 : 3;
+    window::Plane source, planes[3];
+    for (int c = 0; c < channels; ++c) {
+      window::split(in, channels == 1 ? BLUE : c, source);
+      planes[c].resize(static_cast<std::size_t>(hi - lo) * in.width);
+      plane(source.data(), in.width, in.count, mode, radiusX, radiusY,
+            lo - in.first, hi - in.first, planes[c].data());
+    }
+    window::merge(planes, channels, in.width, hi - lo, out);
+  };
+}
+
+/**
+ * @brief Ядро минимума и максимума: avx2, sse2 (scalar вне x86)
+ */
+const char *kernelName() { return cpu::name(kernelLevel()); }
+}  // namespace morphology
+}  // namespace model
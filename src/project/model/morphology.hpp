@@ -0,0 +1,27 @@
+#ifndef MORPHOLOGY_HPP
+#define MORPHOLOGY_HPP
+
+#include <cstdint>
+
+#include "window.hpp"
+
+namespace model {
+namespace morphology {
+constexpr int kMaxRadius = 50;
+
+/**
+ * @brief Операция с прямоугольным структурным элементом: эрозия (минимум
+ * окна), дилатация (максимум), открытие (эрозия, затем дилатация) и
+ * закрытие (дилатация, затем эрозия)
+ */
+enum Mode { ERODE, DILATE, OPEN, CLOSE };
+
+void plane(const std::uint8_t *src, int width, int rows, Mode mode,
+           int radiusX, int radiusY, int lo, int hi, std::uint8_t *dst);
+int radius(Mode mode, int radiusX, int radiusY);
+window::Filter filter(Mode mode, int radiusX, int radiusY);
+const char *kernelName();
+}  // namespace morphology
+}  // namespace model
+
+#endif
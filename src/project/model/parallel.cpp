@@ -0,0 +1,51 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace model {
+namespace parallel {
+
+/**
+ * @brief Число рабочих потоков
+ * @param requested - запрошенное число (0 - по числу ядер)
+ */
+int threadsCount(int requested) {
+  if (requested > 0) return requested;
+  return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+/**
+ * @brief Параллельный цикл по [0, count): диапазон режется на куски, потоки
+ * забирают их по одному, пока куски не кончатся
+ * @param count - размер диапазона
+ * @param fn - тело цикла для куска [begin, end)
+ * @param threads - число потоков (0 - по числу ядер)
+ * @param grain - минимальный размер куска
+ */
+void forRange(int count, const std::function<void(int, int)> &fn, int threads,
+              int grain) {
+  if (count <= 0) return;
+  threads = threadsCount(threads);
+  // несколько кусков на поток, чтобы выровнять нагрузку
+  int chunk = std::max(std::max(1, grain), count / (4 * threads));
+  int chunks = (count + chunk - 1) / chunk;
+  threads = std::min(threads, chunks);
+  if (threads <= 1) {
+    fn(0, count);
+    return;
+  }
+  std::atomic<int> next{0};
+  auto worker = [&]() {
+    for (int i = next++; i < chunks; i = next++)
+      fn(i * chunk, std::min(count, (i + 1) * chunk));
+  };
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threads; ++i) workers.emplace_back(worker);
+  worker();
+  for (auto &t : workers) t.join();
+}
+}  // namespace parallel
+}  // namespace model
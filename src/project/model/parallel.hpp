@@ -0,0 +1,14 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <functional>
+
+namespace model {
+namespace parallel {
+int threadsCount(int requested = 0);
+void forRange(int count, const std::function<void(int, int)> &fn,
+              int threads = 0, int grain = 1);
+}  // namespace parallel
+}  // namespace model
+
+#endif
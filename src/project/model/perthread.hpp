@@ -0,0 +1,83 @@
+#ifndef PERTHREAD_HPP
+#define PERTHREAD_HPP
+
+#include <mutex>
+#include <set>
+
+namespace model {
+/**
+ * @brief Данные, которые каждый поток пишет в свою копию, без общей
+ * блокировки. Копию потока защищает свой мьютекс, его кроме владельца
+ * берет только чтение всех данных (forEach). При завершении потока копия
+ * сливается в итог завершившихся потоков (T::merge). Одна копия на тип T
+ * и поток
+ */
+template <typename T>
+class PerThread {
+ public:
+  /**
+   * @brief Изменение копии текущего потока
+   * @param fn - fn(T &)
+   */
+  template <typename Fn>
+  static void update(Fn &&fn) {
+    Local &local = current();
+    std::lock_guard<std::mutex> lock(local.mutex);
+    fn(local.data);
+  }
+
+  /**
+   * @brief Обход итога завершившихся потоков и копий работающих (для
+   * отчета и сброса); новые потоки на это время не регистрируются
+   * @param fn - fn(T &)
+   */
+  template <typename Fn>
+  static void forEach(Fn &&fn) {
+    Registry &all = registry();
+    std::lock_guard<std::mutex> lock(all.mutex);
+    fn(all.retired);
+    for (Local *local : all.live) {
+      std::lock_guard<std::mutex> own(local->mutex);
+      fn(local->data);
+    }
+  }
+
+ private:
+  struct Local;
+
+  struct Registry {
+    std::mutex mutex;
+    std::set<Local *> live;
+    T retired;
+  };
+
+  struct Local {
+    std::mutex mutex;
+    T data;
+
+    Local() {
+      Registry &all = registry();
+      std::lock_guard<std::mutex> lock(all.mutex);
+      all.live.insert(this);
+    }
+    ~Local() {
+      Registry &all = registry();
+      std::lock_guard<std::mutex> lock(all.mutex);
+      all.retired.merge(data);
+      all.live.erase(this);
+    }
+  };
+
+  static Registry &registry() {
+    static Registry all;
+    return all;
+  }
+
+  static Local &current() {
+    thread_local Local local;
+    return local;
+  }
+};
+}  // namespace model
+
+#endif
@@ -0,0 +1,651 @@
+#include "pipeline.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "bilateral.hpp"
+#include "gradient.hpp"
+#include "hash.hpp"
+#include "median.hpp"
+#include "metrics.hpp"
+#include "channel.hpp"
+#include "morphology.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+#include "ycbcr.hpp"
+
+namespace {
+using model::ImageBuffer;
+using model::pipeline::Operation;
+using model::pipeline::Stage;
+
+/**
+ * @brief Полоса строк изображения в памяти (строки [first, first + count)),
+ * gray - все пиксели заведомо серые
+ */
+struct Rows {
+  int first = 0;
+  int count = 0;
+  int width = 0;
+  std::vector<QRgb> px;
+  bool gray = false;
+
+  const QRgb *row(int y) const {
+    if (y < first || y >= first + count) return nullptr;
+    return px.data() + static_cast<std::size_t>(y - first) * width;
+  }
+  QRgb *row(int y) {
+    return px.data() + static_cast<std::size_t>(y - first) * width;
+  }
+};
+
+int toByte(float value) {
+  return static_cast<int>(std::lround(std::clamp(value, 0.0f, 255.0f)));
+}
+
+/**
+ * @brief Свертка полосы: строки [lo, hi) по строкам in, за краями
+ * изображения значения нулевые (как в addDefaultValues). Если полоса серая
+ * (R = G = B, см. window::isGray), считается одна плоскость вместо трех и
+ * результат дублируется в каналы. В режиме lumaOnly сворачивается только
+ * плоскость Y, Cb и Cr берутся из исходных пикселей полосы
+ */
+Rows convolve(Rows const &in, Stage const &stage, int lo, int hi) {
+  const int r = stage.radius;
+  const int n = 2 * r + 1;
+  const int width = in.width;
+  const int padded = width + 2 * r;
+  const int rows = hi - lo + 2 * r;
+
+  const bool gray = model::window::isGray(
+      {in.first, in.count, width, in.px.data(), 0, in.gray});
+  const bool luma = !gray && stage.lumaOnly;
+  const int channels = gray || luma ? 1 : 3;
+  model::metrics::count("convolution.tiles");
+  if (gray) model::metrics::count("convolution.single_channel_tiles");
+  if (luma) model::metrics::count("convolution.luma_tiles");
+
+  std::vector<float> planes[3];
+  for (int c = 0; c < channels; ++c)
+    planes[c].assign(static_cast<std::size_t>(rows) * padded, 0.0f);
+  for (int i = 0; i < rows; ++i) {
+    const QRgb *src = in.row(lo - r + i);
+    if (!src) continue;
+    std::size_t base = static_cast<std::size_t>(i) * padded + r;
+    if (gray) {
+      for (int x = 0; x < width; ++x) planes[0][base + x] = qBlue(src[x]);
+      continue;
+    }
+    if (luma) {
+      model::ycbcr::split(src, planes[0].data() + base, nullptr, nullptr,
+                          width);
+      continue;
+    }
+    for (int x = 0; x < width; ++x) {
+      planes[RED][base + x] = qRed(src[x]);
+      planes[GREEN][base + x] = qGreen(src[x]);
+      planes[BLUE][base + x] = qBlue(src[x]);
+    }
+  }
+
+  Rows out{lo, hi - lo, width, {}, gray};
+  out.px.resize(static_cast<std::size_t>(out.count) * width);
+  std::vector<float> acc[3];
+  for (int c = 0; c < channels; ++c) acc[c].resize(width);
+  std::vector<float> cb(luma ? width : 0), cr(luma ? width : 0);
+  for (int y = lo; y < hi; ++y) {
+    for (int c = 0; c < channels; ++c)
+      std::fill(acc[c].begin(), acc[c].end(), 0.0f);
+    for (int ky = 0; ky < n; ++ky) {
+      for (int kx = 0; kx < n; ++kx) {
+        float k = stage.kernel[ky * n + kx];
+        if (k == 0.0f) continue;
+        std::size_t base = static_cast<std::size_t>(y - lo + ky) * padded + kx;
+        for (int c = 0; c < channels; ++c) {
+          const float *src = planes[c].data() + base;
+          float *dst = acc[c].data();
+          for (int x = 0; x < width; ++x) dst[x] += k * src[x];
+        }
+      }
+    }
+    QRgb *dst = out.row(y);
+    if (gray) {
+      for (int x = 0; x < width; ++x) {
+        int v = toByte(acc[0][x]);
+        dst[x] = qRgb(v, v, v);
+      }
+      continue;
+    }
+    if (luma) {
+      model::ycbcr::split(in.row(y), nullptr, cb.data(), cr.data(), width);
+      model::ycbcr::merge(acc[0].data(), cb.data(), cr.data(), dst, width);
+      continue;
+    }
+    for (int x = 0; x < width; ++x)
+      dst[x] = qRgb(toByte(acc[RED][x]), toByte(acc[GREEN][x]),
+                    toByte(acc[BLUE][x]));
+  }
+  return out;
+}
+
+/**
+ * @brief Оконный фильтр полосы: строки [lo, hi) по строкам in, left -
+ * столбец изображения, с которого начинаются строки
+ */
+Rows windowed(Rows const &in, Stage const &stage, int lo, int hi, int left) {
+  Rows out{lo, hi - lo, in.width, {}};
+  out.px.resize(static_cast<std::size_t>(out.count) * in.width);
+  const model::window::Strip strip{in.first, in.count, in.width,
+                                   in.px.data(), left, in.gray};
+  stage.filter(strip, lo, hi, out.px.data());
+  return out;
+}
+
+/**
+ * @brief Слитые поточечные фильтры: таблицы и матрицы этапа уже
+ * скомпонованы, применяются за один проход
+ */
+void applyPoints(Rows &rows, Stage const &stage) {
+  stage.points.apply(rows.px.data(), rows.px.size());
+}
+
+/**
+ * @brief Переводит ли поточечный этап серые пиксели в серые: проверяется
+ * на всех 256 оттенках серого
+ */
+bool keepsGray(Stage const &stage) {
+  std::vector<QRgb> ramp(256);
+  for (int v = 0; v < 256; ++v) ramp[v] = qRgb(v, v, v);
+  stage.points.apply(ramp.data(), ramp.size());
+  return model::window::isGray({0, 1, 256, ramp.data()});
+}
+
+/**
+ * @brief Серое ли изображение по формату: GRAY8 или палитра из одних
+ * оттенков серого (пиксели не просматриваются)
+ */
+bool isGrayFormat(ImageBuffer const &image) {
+  if (image.format() == ImageBuffer::GRAY8) return true;
+  if (image.format() != ImageBuffer::INDEXED8) return false;
+  const QList<QRgb> table = image.colorTable();
+  return model::window::isGray(
+      {0, 1, static_cast<int>(table.size()), table.data()});
+}
+/**
+ * @brief Выполнение этапов в области region буфера RGB32: полосы строк
+ * области проходят все этапы подряд, свертки читают пиксели вокруг области
+ * (строки и столбцы на сумму радиусов ядер). gray - источник серый по
+ * формату: серые полосы не проверяются, пока этапы сохраняют серый цвет
+ * @return буфер размера области
+ */
+ImageBuffer execute(std::vector<Stage> const &stages, ImageBuffer const &src,
+                    QRect const &region, int tileRows, int threadsCount,
+                    bool gray) {
+  const int width = src.width();
+  const int height = src.height();
+
+  std::vector<int> after(stages.size(), 0);
+  for (int k = static_cast<int>(stages.size()) - 2; k >= 0; --k)
+    after[k] = after[k + 1] + stages[k + 1].radius;
+
+  // столбцы области с запасом на все ядра: ошибки у границы запаса за
+  // каждую свертку сдвигаются внутрь на ее радиус и до области не доходят
+  const int halo = after[0] + stages[0].radius;
+  const int x0 = region.x(), x1 = region.x() + region.width();
+  const int cx0 = std::max(0, x0 - halo);
+  const int cols = std::min(width, x1 + halo) - cx0;
+  const int top = region.y(), bottom = region.y() + region.height();
+
+  threadsCount = model::parallel::threadsCount(threadsCount);
+  if (tileRows <= 0) {
+    // полоса из трех float-плоскостей около 512 КБ
+    tileRows = std::clamp(43690 / std::max(1, cols), 8, 256);
+    int balanced =
+        (region.height() + 4 * threadsCount - 1) / (4 * threadsCount);
+    tileRows = std::max(1, std::min(tileRows, balanced));
+    // полоса не ниже запаса, иначе строки запаса широких окон считаются
+    // чаще строк самой полосы
+    tileRows = std::max(tileRows, std::min(halo, region.height()));
+  }
+  const int tiles = (region.height() + tileRows - 1) / tileRows;
+
+  std::vector<bool> grayPoints(stages.size(), false);
+  for (std::size_t k = 0; k < stages.size() && gray; ++k)
+    if (stages[k].kind == Operation::POINT)
+      grayPoints[k] = keepsGray(stages[k]);
+
+  ImageBuffer result(region.width(), region.height(), ImageBuffer::RGB32);
+  const uchar *srcBits = src.constBits();
+  uchar *dstBits = result.bits();
+  const qsizetype srcStride = src.stride();
+  const qsizetype dstStride = result.stride();
+
+  auto processTile = [&](int tile) {
+    const int y0 = top + tile * tileRows;
+    const int y1 = std::min(bottom, y0 + tileRows);
+    model::trace::Scope scope(
+        "tile", "rows " + std::to_string(y0) + "-" + std::to_string(y1 - 1));
+    int lo = std::max(0, y0 - after[0] - stages[0].radius);
+    int hi = std::min(height, y1 + after[0] + stages[0].radius);
+    Rows rows{lo, hi - lo, cols, {}, gray};
+    {
+      model::trace::Scope convert("convert");
+      rows.px.resize(static_cast<std::size_t>(rows.count) * cols);
+      for (int y = lo; y < hi; ++y) {
+        auto line =
+            reinterpret_cast<const QRgb *>(srcBits + y * srcStride) + cx0;
+        std::copy(line, line + cols, rows.row(y));
+      }
+    }
+    for (std::size_t k = 0; k < stages.size(); ++k) {
+      const Operation::Kind kind = stages[k].kind;
+      const char *stage = kind == Operation::POINT    ? "point"
+                          : kind == Operation::WINDOW ? "window"
+                                                      : "convolution";
+      auto begin = std::chrono::steady_clock::now();
+      {
+        model::trace::Scope scope(stage);
+        if (kind == Operation::POINT) {
+          applyPoints(rows, stages[k]);
+          rows.gray = rows.gray && grayPoints[k];
+        } else if (kind == Operation::WINDOW) {
+          rows = windowed(rows, stages[k], std::max(0, y0 - after[k]),
+                          std::min(height, y1 + after[k]), cx0);
+        } else {
+          rows = convolve(rows, stages[k], std::max(0, y0 - after[k]),
+                          std::min(height, y1 + after[k]));
+        }
+      }
+      model::metrics::time(stage, std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - begin)
+                                      .count());
+    }
+    model::trace::Scope pack("pack");
+    for (int y = y0; y < y1; ++y)
+      std::copy(rows.row(y) + (x0 - cx0), rows.row(y) + (x1 - cx0),
+                reinterpret_cast<QRgb *>(dstBits + (y - top) * dstStride));
+  };
+
+  model::parallel::forRange(
+      tiles,
+      [&](int begin, int end) {
+        for (int tile = begin; tile < end; ++tile) processTile(tile);
+      },
+      threadsCount);
+  return result;
+}
+}  // namespace
+
+namespace model {
+namespace pipeline {
+
+/**
+ * @brief Операция свертки
+ * @param name - имя для отображения
+ * @param kernel - квадратное ядро нечетного размера
+ * @param lumaOnly - сворачивать только яркость (YCbCr)
+ */
+Operation Operation::convolution(std::string name, std::vector<float> kernel,
+                                 bool lumaOnly) {
+  return Operation{CONVOLUTION, std::move(name), std::move(kernel), {},
+                   lumaOnly};
+}
+
+/**
+ * @brief Поточечная операция
+ * @param name - имя для отображения
+ * @param op - скомпилированная операция (таблицы, матрица или функция)
+ */
+Operation Operation::pointwise(std::string name, pointop::PointOp op) {
+  return Operation{POINT, std::move(name), {}, std::move(op)};
+}
+
+/**
+ * @brief Оконная операция
+ * @param name - имя для отображения
+ * @param radius - полуширина окна (запас строк и столбцов вокруг полосы)
+ * @param filter - фильтр полосы
+ * @param parameters - параметры фильтра, различающие результаты в кеше
+ */
+Operation Operation::windowed(std::string name, int radius,
+                              window::Filter filter,
+                              std::vector<float> parameters) {
+  Operation op{WINDOW, std::move(name), std::move(parameters), {}};
+  op.radius = radius;
+  op.filter = std::move(filter);
+  return op;
+}
+
+/**
+ * @brief Хеш операции с параметрами (ядро, режим яркости, таблицы и
+ * матрица поточечной операции) для ключей кеша результатов
+ */
+std::uint64_t Operation::digest() const {
+  std::uint64_t res = hash::bytes(name.data(), name.size());
+  res = hash::combine(res, kind);
+  res = hash::combine(res, lumaOnly);
+  res = hash::bytes(kernel.data(), kernel.size() * sizeof(float), res);
+  return hash::combine(res, point.digest());
+}
+
+/**
+ * @brief Негатив как поточечная операция (см. simple::negative)
+ */
+Operation negative() {
+  return Operation::pointwise("Negative", pointop::negative());
+}
+
+/**
+ * @brief Оттенки серого как поточечная операция (см. simple::grayscale)
+ * @param type - AVERAGE, LUMA или DISSAT
+ */
+Operation grayscale(char type) {
+  std::string name = type == AVERAGE  ? "Grayscale (average)"
+                     : type == DISSAT ? "Grayscale (dissat)"
+                                      : "Grayscale (luma)";
+  return Operation::pointwise(name, pointop::grayscale(type));
+}
+
+/**
+ * @brief Тонирование как поточечная операция (см. simple::toning)
+ * @param tone - цвет тонирования
+ */
+Operation toning(QColor tone) {
+  return Operation::pointwise("Toning", pointop::toning(tone));
+}
+
+/**
+ * @brief Оттенки серого с весами каналов как поточечная операция
+ * @param red - вес красного
+ * @param green - вес зеленого
+ * @param blue - вес синего
+ */
+Operation grayscale(float red, float green, float blue) {
+  return Operation::pointwise("Grayscale (weights)",
+                              pointop::grayscale(red, green, blue));
+}
+
+/**
+ * @brief Тонирование с силой как поточечная операция
+ * @param tone - цвет тонирования
+ * @param strength - сила 0..1
+ */
+Operation toning(QColor tone, float strength) {
+  return Operation::pointwise("Toning", pointop::toning(tone, strength));
+}
+
+/**
+ * @brief Яркость, контраст и гамма как поточечная операция (таблица)
+ * @param brightness - сдвиг -255..255
+ * @param contrast - наклон вокруг 128
+ * @param gamma - гамма
+ */
+Operation levels(float brightness, float contrast, float gamma) {
+  return Operation::pointwise(
+      "Levels", pointop::PointOp::lut(
+                    pointop::levels(brightness, contrast, gamma)));
+}
+
+/**
+ * @brief Настройки с ползунками как одна поточечная операция
+ * @param adjustment - параметры
+ */
+Operation adjustment(const pointop::Adjustment &adjustment) {
+  return Operation::pointwise("Adjust", pointop::adjustment(adjustment));
+}
+
+/**
+ * @brief Выравнивание гистограммы как поточечная операция. Таблица
+ * строится по гистограмме входа операции один раз, при добавлении в
+ * цепочку, поэтому цепочка по-прежнему считается полосами
+ * @param histogram - гистограмма входа операции
+ */
+Operation equalization(const histogram::Histogram &histogram) {
+  return Operation::pointwise(
+      "Equalize", pointop::PointOp::lut(histogram::equalization(histogram)));
+}
+
+/**
+ * @brief Автоуровни как поточечная операция (таблица по гистограмме входа)
+ * @param histogram - гистограмма входа операции
+ * @param clip - доля отсекаемых пикселей с каждой стороны
+ */
+Operation autoLevels(const histogram::Histogram &histogram, double clip) {
+  return Operation::pointwise(
+      "Auto levels",
+      pointop::PointOp::lut(histogram::autoLevels(histogram, clip)));
+}
+
+/**
+ * @brief Медианный фильтр (против импульсного шума) как оконная операция
+ * @param radius - радиус окна 1..median::kMaxRadius
+ */
+Operation median(int radius) {
+  radius = std::clamp(radius, 1, median::kMaxRadius);
+  return Operation::windowed("Median", radius, median::filter(radius),
+                             {float(radius)});
+}
+
+/**
+ * @brief Билатеральный фильтр (сглаживание без размытия краев) на
+ * билатеральной сетке как оконная операция
+ * @param sigmaSpatial - пространственная сигма, пиксели
+ * @param sigmaRange - сигма по яркости, единицы 0..255
+ */
+Operation bilateral(float sigmaSpatial, float sigmaRange) {
+  sigmaSpatial = std::clamp(sigmaSpatial, bilateral::kMinSpatial,
+                            bilateral::kMaxSpatial);
+  sigmaRange =
+      std::clamp(sigmaRange, bilateral::kMinRange, bilateral::kMaxRange);
+  return Operation::windowed("Bilateral", bilateral::radius(sigmaSpatial),
+                             bilateral::filter(sigmaSpatial, sigmaRange),
+                             {sigmaSpatial, sigmaRange});
+}
+
+/**
+ * @brief Морфологическая операция с прямоугольным элементом (2 radiusX +
+ * 1) x (2 radiusY + 1) как оконная операция
+ * @param mode - эрозия, дилатация, открытие или закрытие
+ * @param radiusX - радиус элемента по горизонтали 0..morphology::kMaxRadius
+ * @param radiusY - радиус элемента по вертикали 0..morphology::kMaxRadius
+ */
+Operation morphology(morphology::Mode mode, int radiusX, int radiusY) {
+  static const char *names[4] = {"Erode", "Dilate", "Open", "Close"};
+  radiusX = std::clamp(radiusX, 0, morphology::kMaxRadius);
+  radiusY = std::clamp(radiusY, 0, morphology::kMaxRadius);
+  return Operation::windowed(
+      names[mode], morphology::radius(mode, radiusX, radiusY),
+      morphology::filter(mode, radiusX, radiusY),
+      {float(mode), float(radiusX), float(radiusY)});
+}
+
+/**
+ * @brief Модуль градиента яркости (выделение краев) как оконная операция:
+ * производные по x и y одним проходом
+ * @param kernel - ядро Собеля или Превитта
+ * @param norm - L1 или L2
+ * @param orientation - цвет по направлению градиента
+ */
+Operation gradient(gradient::Kernel kernel, gradient::Norm norm,
+                   bool orientation) {
+  return Operation::windowed(
+      kernel == gradient::SOBEL ? "Sobel gradient" : "Prewitt gradient", 1,
+      gradient::filter(kernel, norm, orientation),
+      {float(kernel), float(norm), float(orientation)});
+}
+
+/**
+ * @brief Сепия как поточечная операция
+ */
+Operation sepia() { return Operation::pointwise("Sepia", pointop::sepia()); }
+
+/**
+ * @brief Пользовательская цветовая матрица как поточечная операция
+ * @param matrix - матрица 3x4
+ */
+Operation colorMatrix(const pointop::Matrix &matrix) {
+  return Operation::pointwise("Color Matrix",
+                              pointop::PointOp::matrix(matrix));
+}
+
+/**
+ * @brief Добавление операции в конец цепочки
+ */
+void Pipeline::push(Operation op) { ops.push_back(std::move(op)); }
+
+/**
+ * @brief Удаление последней операции
+ */
+void Pipeline::pop() {
+  if (!ops.empty()) ops.pop_back();
+}
+
+/**
+ * @brief Очистка цепочки
+ */
+void Pipeline::clear() { ops.clear(); }
+
+/**
+ * @brief Проверка на пустоту
+ */
+bool Pipeline::isEmpty() const { return ops.empty(); }
+
+/**
+ * @brief Список операций в порядке применения
+ */
+const std::vector<Operation> &Pipeline::operations() const { return ops; }
+
+/**
+ * @brief Хеш цепочки: операции по порядку
+ */
+std::uint64_t Pipeline::digest() const {
+  std::uint64_t res = hash::combine(0, ops.size());
+  for (auto const &op : ops) res = hash::combine(res, op.digest());
+  return res;
+}
+
+/**
+ * @brief Планирование: соседние поточечные операции сливаются в один этап,
+ * внутри этапа таблицы и матрицы компонуются (см. pointop::Program)
+ * @return этапы для выполнения
+ */
+std::vector<Stage> Pipeline::plan() const {
+  std::vector<Stage> stages;
+  for (auto const &op : ops) {
+    if (op.kind == Operation::POINT) {
+      if (stages.empty() || stages.back().kind != Operation::POINT)
+        stages.push_back(Stage{Operation::POINT, {}, 0, {}});
+      stages.back().points.append(op.point);
+    } else if (op.kind == Operation::WINDOW) {
+      stages.push_back(
+          Stage{Operation::WINDOW, {}, op.radius, {}, false, op.filter});
+    } else {
+      int n = static_cast<int>(std::lround(std::sqrt(op.kernel.size())));
+      stages.push_back(
+          Stage{Operation::CONVOLUTION, op.kernel, n / 2, {}, op.lumaOnly});
+    }
+  }
+  return stages;
+}
+
+/**
+ * @brief Выполнение цепочки. Полоса строк результата вычисляется со всеми
+ * этапами подряд: для сверток полоса заранее расширяется на сумму радиусов
+ * последующих ядер, поэтому результат совпадает с последовательным
+ * применением фильтров к целому изображению
+ * @param source - исходное изображение
+ * @param tileRows - высота полосы (0 - подобрать по ширине изображения)
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ * @return результат в формате RGB32; палитровое изображение, к которому
+ * применялись только поточечные фильтры, остается палитровым. Пустая
+ * цепочка возвращает источник как есть, в его исходном формате
+ */
+QImage Pipeline::run(const QImage &source, int tileRows,
+                     int threadsCount) const {
+  if (source.isNull() || ops.empty()) return source;
+  return run(ImageBuffer::fromImage(source), tileRows, threadsCount)
+      .toImage();
+}
+
+/**
+ * @brief Выполнение цепочки над буфером (см. run для QImage). Исходный
+ * буфер только читается, результат пишется в новый буфер без
+ * промежуточных QImage
+ * @param source - исходный буфер
+ * @param tileRows - высота полосы (0 - подобрать по ширине изображения)
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ * @return буфер RGB32 или INDEXED8 (только поточечные фильтры); для
+ * пустой цепочки - источник в исходном формате
+ */
+ImageBuffer Pipeline::run(const ImageBuffer &source, int tileRows,
+                          int threadsCount) const {
+  return run(source, source.rect(), tileRows, threadsCount);
+}
+
+/**
+ * @brief Выполнение цепочки только в прямоугольнике roi. Свертки читают
+ * пиксели вокруг области (строки и столбцы на сумму радиусов ядер), поэтому
+ * внутри области результат совпадает с обработкой целого изображения;
+ * вне области пиксели источника не меняются
+ * @param source - исходный буфер
+ * @param roi - область обработки (обрезается по границам изображения)
+ * @param tileRows - высота полосы (0 - подобрать по ширине области)
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ * @return буфер того же размера, что и источник; для пустой цепочки или
+ * области вне изображения - сам источник в исходном формате
+ */
+ImageBuffer Pipeline::run(const ImageBuffer &source, const QRect &roi,
+                          int tileRows, int threadsCount) const {
+  const QRect region = source.rect().intersected(roi);
+  if (source.isNull() || ops.empty() || region.isEmpty()) return source;
+  const bool whole = region == source.rect();
+  std::vector<Stage> stages = plan();
+  ImageBuffer src = source;
+  if (whole && src.format() == ImageBuffer::INDEXED8 &&
+      stages.front().kind == Operation::POINT) {
+    // ведущие поточечные фильтры палитрового изображения меняют только
+    // палитру, в RGB32 раскрываем только перед сверткой
+    trace::Scope scope("point", "palette");
+    QImage indexed = src.toImage();
+    stages.front().points.applyToPalette(indexed);
+    stages.erase(stages.begin());
+    src = ImageBuffer::fromImage(indexed);
+    if (stages.empty()) return src;
+  }
+  const bool gray = isGrayFormat(src);
+  src = src.convertTo(ImageBuffer::RGB32);
+  ImageBuffer part =
+      execute(stages, src, region, tileRows, threadsCount, gray);
+  if (whole) return part;
+  // вне области результат - это источник (копируется один раз)
+  ImageBuffer result = src;
+  const qsizetype bytes = static_cast<qsizetype>(region.width()) * 4;
+  for (int y = 0; y < region.height(); ++y)
+    std::memcpy(result.line(region.y() + y) + region.x() * 4,
+                part.constLine(y), bytes);
+  return result;
+}
+
+/**
+ * @brief Результат цепочки только для области roi, без копирования
+ * остального изображения (для отрисовки по плиткам)
+ * @param source - исходный буфер
+ * @param roi - область (обрезается по границам изображения)
+ * @param tileRows - высота полосы (0 - подобрать по ширине области)
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ * @return буфер RGB32 размера области
+ */
+ImageBuffer Pipeline::region(const ImageBuffer &source, const QRect &roi,
+                             int tileRows, int threadsCount) const {
+  const QRect area = source.rect().intersected(roi);
+  if (source.isNull() || area.isEmpty()) return ImageBuffer();
+  ImageBuffer src = source.convertTo(ImageBuffer::RGB32);
+  if (ops.empty()) return src.view(area);
+  return execute(plan(), src, area, tileRows, threadsCount,
+                 isGrayFormat(source));
+}
+
+}  // namespace pipeline
+}  // namespace model
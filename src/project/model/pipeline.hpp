@@ -0,0 +1,105 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <QColor>
+#include <QImage>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gradient.hpp"
+#include "histogram.hpp"
+#include "imagebuffer.hpp"
+#include "morphology.hpp"
+#include "pointop.hpp"
+#include "window.hpp"
+
+namespace model {
+namespace pipeline {
+/**
+ * @brief Одна операция цепочки: свертка NxN, поточечный или оконный
+ * (нелинейный) фильтр. Свертка с lumaOnly применяется только к яркости Y в
+ * YCbCr, цветоразностные каналы не меняются. У оконного фильтра kernel
+ * хранит его параметры (для хеша), radius - полуширину окна
+ */
+struct Operation {
+  enum Kind { CONVOLUTION, POINT, WINDOW };
+
+  Kind kind;
+  std::string name;
+  std::vector<float> kernel;
+  pointop::PointOp point;
+  bool lumaOnly = false;
+  int radius = 0;
+  window::Filter filter{};
+
+  static Operation convolution(std::string name, std::vector<float> kernel,
+                               bool lumaOnly = false);
+  static Operation pointwise(std::string name, pointop::PointOp op);
+  static Operation windowed(std::string name, int radius,
+                            window::Filter filter,
+                            std::vector<float> parameters);
+  std::uint64_t digest() const;
+};
+
+Operation negative();
+Operation grayscale(char type);
+Operation grayscale(float red, float green, float blue);
+Operation toning(QColor tone);
+Operation toning(QColor tone, float strength);
+Operation sepia();
+Operation colorMatrix(const pointop::Matrix &matrix);
+Operation levels(float brightness, float contrast, float gamma);
+Operation adjustment(const pointop::Adjustment &adjustment);
+Operation equalization(const histogram::Histogram &histogram);
+Operation autoLevels(const histogram::Histogram &histogram,
+                     double clip = 0.005);
+Operation median(int radius);
+Operation bilateral(float sigmaSpatial, float sigmaRange);
+Operation morphology(morphology::Mode mode, int radiusX, int radiusY);
+Operation gradient(gradient::Kernel kernel, gradient::Norm norm,
+                   bool orientation = false);
+
+/**
+ * @brief Этап плана: свертка, оконный фильтр или несколько слитых
+ * поточечных фильтров
+ */
+struct Stage {
+  Operation::Kind kind;
+  std::vector<float> kernel;
+  int radius;
+  pointop::Program points;
+  bool lumaOnly = false;
+  window::Filter filter{};
+};
+
+/**
+ * @brief Цепочка фильтров. Соседние поточечные операции сливаются в один
+ * проход, изображение обрабатывается полосами строк, которые проходят через
+ * все этапы подряд, без промежуточных изображений целиком
+ */
+class Pipeline {
+ public:
+  void push(Operation op);
+  void pop();
+  void clear();
+  bool isEmpty() const;
+  const std::vector<Operation> &operations() const;
+  std::vector<Stage> plan() const;
+  std::uint64_t digest() const;
+  QImage run(const QImage &source, int tileRows = 0,
+             int threadsCount = 0) const;
+  ImageBuffer run(const ImageBuffer &source, int tileRows = 0,
+                  int threadsCount = 0) const;
+  ImageBuffer run(const ImageBuffer &source, const QRect &roi,
+                  int tileRows = 0, int threadsCount = 0) const;
+  ImageBuffer region(const ImageBuffer &source, const QRect &roi,
+                     int tileRows = 0, int threadsCount = 0) const;
+
+ private:
+  std::vector<Operation> ops;
+};
+}  // namespace pipeline
+}  // namespace model
+
+#endif
@@ -0,0 +1,477 @@
+#include "pointop.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "colormatrix.hpp"
+#include "hash.hpp"
+#include "channel.hpp"
+#include "parallel.hpp"
+
+namespace {
+using model::pointop::Lut;
+using model::pointop::Matrix;
+
+// размер блока пикселей, который целиком лежит в L1 между этапами
+constexpr std::size_t kBlock = 256;
+
+std::uint8_t toByte(float value) {
+  return static_cast<std::uint8_t>(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+}
+
+/**
+ * @brief Композиция таблиц: сначала first, затем second
+ */
+Lut compose(Lut const &first, Lut const &second) {
+  Lut res;
+  for (int c = RED; c <= BLUE; ++c)
+    for (int v = 0; v < 256; ++v) res[c][v] = second[c][first[c][v]];
+  return res;
+}
+
+/**
+ * @brief Композиция матриц: сначала first, затем second
+ */
+Matrix multiply(Matrix const &first, Matrix const &second) {
+  Matrix res{};
+  for (int c = 0; c < 3; ++c) {
+    for (int j = 0; j < 4; ++j) {
+      float sum = j == 3 ? second.m[c][3] : 0.0f;
+      for (int k = 0; k < 3; ++k) sum += second.m[c][k] * first.m[k][j];
+      res.m[c][j] = sum;
+    }
+  }
+  return res;
+}
+
+/**
+ * @brief Проверка, что матрица не выводит значения за 0..255 ни для одного
+ * входа; только такие матрицы можно перемножать без промежуточного
+ * ограничения диапазона
+ */
+bool keepsRange(Matrix const &mat) {
+  for (int c = 0; c < 3; ++c) {
+    float lo = mat.m[c][3], hi = mat.m[c][3];
+    for (int k = 0; k < 3; ++k) {
+      lo += std::min(0.0f, mat.m[c][k]) * 255.0f;
+      hi += std::max(0.0f, mat.m[c][k]) * 255.0f;
+    }
+    if (lo < -0.5f || hi > 255.5f) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Таблица для каждого канала, на месте
+ */
+void applyLut(Lut const &table, QRgb *pixels, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    QRgb p = pixels[i];
+    pixels[i] = qRgb(table[RED][qRed(p)], table[GREEN][qGreen(p)],
+                     table[BLUE][qBlue(p)]);
+  }
+}
+}  // namespace
+
+namespace model {
+namespace pointop {
+
+/**
+ * @brief Тождественная таблица
+ */
+Lut identityLut() {
+  Lut res;
+  for (auto &channel : res)
+    for (int v = 0; v < 256; ++v) channel[v] = static_cast<std::uint8_t>(v);
+  return res;
+}
+
+/**
+ * @brief Тождественная матрица
+ */
+Matrix identityMatrix() {
+  return Matrix{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+}
+
+/**
+ * @brief Таблица яркости, контраста и гаммы (одна для всех каналов):
+ * v -> 255 * ((v - 128) * contrast + 128 + brightness) / 255) ^ (1 / gamma)
+ * @param brightness - сдвиг -255..255
+ * @param contrast - наклон вокруг 128 (1 - без изменений)
+ * @param gamma - гамма (1 - без изменений)
+ */
+Lut levels(float brightness, float contrast, float gamma) {
+  Lut res;
+  const float power = gamma > 0 ? 1.0f / gamma : 1.0f;
+  for (int v = 0; v < 256; ++v) {
+    float x = std::clamp((v - 128.0f) * contrast + 128.0f + brightness, 0.0f,
+                         255.0f);
+    if (power != 1.0f) x = 255.0f * std::pow(x / 255.0f, power);
+    res[RED][v] = res[GREEN][v] = res[BLUE][v] = toByte(x);
+  }
+  return res;
+}
+
+/**
+ * @brief Операция из таблиц
+ * @param table - таблица для каждого канала
+ */
+PointOp PointOp::lut(const Lut &table) {
+  PointOp op;
+  op.hasPre = true;
+  op.pre = table;
+  return op;
+}
+
+/**
+ * @brief Операция из цветовой матрицы
+ * @param matrix - матрица 3x4
+ */
+PointOp PointOp::matrix(const Matrix &matrix) {
+  PointOp op;
+  op.hasMatrix = true;
+  op.mat = matrix;
+  return op;
+}
+
+/**
+ * @brief Произвольная функция пикселя (не сливается с соседями)
+ * @param fn - функция
+ */
+PointOp PointOp::function(std::function<QRgb(QRgb)> fn) {
+  PointOp op;
+  op.fn = std::move(fn);
+  return op;
+}
+
+/**
+ * @brief Слияние со следующей операцией: таблицы композируются, таблица
+ * после матрицы становится ее post-таблицей, матрицы перемножаются, если
+ * первая не выходит за диапазон 0..255
+ * @param next - операция, применяемая после текущей
+ * @return true, если операции слиты в текущую
+ */
+bool PointOp::fuse(const PointOp &next) {
+  if (fn || next.fn) return false;
+  if (!next.hasPre && !next.hasMatrix) return true;
+  if (!hasMatrix) {
+    pre = next.hasPre ? (hasPre ? compose(pre, next.pre) : next.pre) : pre;
+    hasPre = hasPre || next.hasPre;
+    hasMatrix = next.hasMatrix;
+    mat = next.mat;
+    hasPost = next.hasPost;
+    post = next.post;
+    return true;
+  }
+  if (!next.hasMatrix) {
+    post = hasPost ? compose(post, next.pre) : next.pre;
+    hasPost = true;
+    return true;
+  }
+  if (hasPost || next.hasPre || !keepsRange(mat)) return false;
+  mat = multiply(mat, next.mat);
+  hasPost = next.hasPost;
+  post = next.post;
+  return true;
+}
+
+/**
+ * @brief Операция задана только таблицами
+ */
+bool PointOp::isLut() const { return !fn && !hasMatrix; }
+
+/**
+ * @brief Операция содержит матрицу
+ */
+bool PointOp::isMatrix() const { return !fn && hasMatrix; }
+
+/**
+ * @brief Операция задана функцией
+ */
+bool PointOp::isFunction() const { return static_cast<bool>(fn); }
+
+/**
+ * @brief Хеш параметров операции (таблицы и матрица) для ключей кеша
+ * @return 0 для операции-функции: ее параметры не видны, такую операцию
+ * различают по имени
+ */
+std::uint64_t PointOp::digest() const {
+  if (fn) return 0;
+  const std::uint64_t flags = hasPre | hasMatrix << 1 | hasPost << 2;
+  std::uint64_t res = hash::bytes(&flags, sizeof(flags));
+  if (hasPre) res = hash::bytes(pre.data(), sizeof(pre), res);
+  if (hasMatrix) res = hash::bytes(mat.m, sizeof(mat.m), res);
+  if (hasPost) res = hash::bytes(post.data(), sizeof(post), res);
+  return res;
+}
+
+/**
+ * @brief Применение к одному пикселю
+ * @param pixel - пиксель
+ * @return результат
+ */
+QRgb PointOp::apply(QRgb pixel) const {
+  apply(&pixel, 1);
+  return pixel;
+}
+
+/**
+ * @brief Применение к непрерывному ряду пикселей блоками: pre-таблица,
+ * матрица (векторное ядро colormatrix), post-таблица, пока блок в кэше
+ * @param pixels - пиксели, изменяются на месте
+ * @param count - количество пикселей
+ */
+void PointOp::apply(QRgb *pixels, std::size_t count) const {
+  if (fn) {
+    for (std::size_t i = 0; i < count; ++i) pixels[i] = fn(pixels[i]);
+    return;
+  }
+  if (!hasMatrix) {
+    applyLut(pre, pixels, count);
+    return;
+  }
+  for (std::size_t start = 0; start < count; start += kBlock) {
+    std::size_t n = std::min(kBlock, count - start);
+    QRgb *block = pixels + start;
+    if (hasPre) applyLut(pre, block, n);
+    colormatrix::transform(mat, block, block, n);
+    if (hasPost) applyLut(post, block, n);
+  }
+}
+
+/**
+ * @brief Добавление операции с попыткой слияния с последней
+ * @param op - операция
+ */
+void Program::append(const PointOp &op) {
+  if (ops.empty() || !ops.back().fuse(op)) ops.push_back(op);
+}
+
+/**
+ * @brief Проверка на пустоту
+ */
+bool Program::isEmpty() const { return ops.empty(); }
+
+/**
+ * @brief Количество операций после слияния
+ */
+std::size_t Program::size() const { return ops.size(); }
+
+/**
+ * @brief Применение к одному пикселю
+ */
+QRgb Program::apply(QRgb pixel) const {
+  for (auto const &op : ops) pixel = op.apply(pixel);
+  return pixel;
+}
+
+/**
+ * @brief Применение к ряду пикселей: блок проходит все операции, пока лежит
+ * в кэше
+ * @param pixels - пиксели, изменяются на месте
+ * @param count - количество
+ */
+void Program::apply(QRgb *pixels, std::size_t count) const {
+  for (std::size_t start = 0; start < count; start += kBlock) {
+    std::size_t n = std::min(kBlock, count - start);
+    for (auto const &op : ops) op.apply(pixels + start, n);
+  }
+}
+
+/**
+ * @brief Применение к изображению: у палитровых меняется только палитра,
+ * остальные приводятся к RGB32, строки делятся между потоками
+ * @param img - изображение
+ * @param threads - число потоков (0 - по числу ядер)
+ */
+void Program::apply(QImage &img, int threads) const {
+  if (applyToPalette(img)) return;
+  img = img.convertToFormat(QImage::Format_RGB32);
+  const int width = img.width();
+  uchar *bits = img.bits();
+  const qsizetype stride = img.bytesPerLine();
+  parallel::forRange(
+      img.height(),
+      [&](int begin, int end) {
+        for (int y = begin; y < end; ++y)
+          apply(reinterpret_cast<QRgb *>(bits + y * stride),
+                static_cast<std::size_t>(width));
+      },
+      threads, std::max(1, (1 << 16) / std::max(1, width)));
+}
+
+/**
+ * @brief Применение только к палитре (O(256) вместо O(пикселей)), индексы
+ * пикселей не меняются
+ * @param img - изображение
+ * @return true, если изображение палитровое и палитра изменена
+ */
+bool Program::applyToPalette(QImage &img) const {
+  if (!isIndexed(img)) return false;
+  auto table = img.colorTable();
+  apply(table.data(), static_cast<std::size_t>(table.size()));
+  img.setColorTable(table);
+  return true;
+}
+
+/**
+ * @brief Проверка, что изображение хранит индексы палитры
+ * @param img - изображение
+ */
+bool isIndexed(const QImage &img) {
+  auto format = img.format();
+  return img.colorCount() > 0 &&
+         (format == QImage::Format_Indexed8 || format == QImage::Format_Mono ||
+          format == QImage::Format_MonoLSB);
+}
+
+/**
+ * @brief Негатив: таблица 255 - v
+ */
+PointOp negative() {
+  Lut table;
+  for (auto &channel : table)
+    for (int v = 0; v < 256; ++v)
+      channel[v] = static_cast<std::uint8_t>(255 - v);
+  return PointOp::lut(table);
+}
+
+/**
+ * @brief Оттенки серого: AVERAGE и LUMA - матрицы, DISSAT - функция
+ * (min + max) / 2
+ * @param type - тип
+ */
+PointOp grayscale(char type) {
+  if (type == DISSAT) {
+    return PointOp::function([](QRgb p) {
+      int r = qRed(p), g = qGreen(p), b = qBlue(p);
+      int c = toByte((std::min(std::min(r, g), b) +
+                      std::max(std::max(r, g), b)) /
+                     2.0f);
+      return qRgb(c, c, c);
+    });
+  }
+  float w[3] = {0.299f, 0.587f, 0.114f};
+  if (type == AVERAGE) w[RED] = w[GREEN] = w[BLUE] = 0.333f;
+  Matrix mat{};
+  for (auto &row : mat.m) {
+    row[RED] = w[RED];
+    row[GREEN] = w[GREEN];
+    row[BLUE] = w[BLUE];
+  }
+  return PointOp::matrix(mat);
+}
+
+/**
+ * @brief Оттенки серого с весами каналов (нормируются к сумме 1, так что
+ * матрица не выходит за диапазон и сливается с соседними)
+ * @param red - вес красного
+ * @param green - вес зеленого
+ * @param blue - вес синего
+ */
+PointOp grayscale(float red, float green, float blue) {
+  const float sum = std::max(0.0f, red) + std::max(0.0f, green) +
+                    std::max(0.0f, blue);
+  if (sum <= 0) return PointOp::lut(identityLut());
+  const float w[3] = {std::max(0.0f, red) / sum, std::max(0.0f, green) / sum,
+                      std::max(0.0f, blue) / sum};
+  Matrix mat{};
+  for (auto &row : mat.m)
+    for (int c = RED; c <= BLUE; ++c) row[c] = w[c];
+  return PointOp::matrix(mat);
+}
+
+/**
+ * @brief Сепия (стандартная матрица)
+ */
+PointOp sepia() {
+  return PointOp::matrix(Matrix{{{0.393f, 0.769f, 0.189f, 0.0f},
+                                 {0.349f, 0.686f, 0.168f, 0.0f},
+                                 {0.272f, 0.534f, 0.131f, 0.0f}}});
+}
+
+/**
+ * @brief Тонирование: матрица LUMA и таблица умножения на цвет тона, один
+ * проход вместо двух
+ * @param tone - цвет
+ */
+PointOp toning(QColor tone) {
+  float t[3];
+  tone.getRgbF(&t[RED], &t[GREEN], &t[BLUE]);
+  Lut table;
+  for (int c = RED; c <= BLUE; ++c)
+    for (int v = 0; v < 256; ++v) table[c][v] = toByte(t[c] * v);
+  PointOp op = grayscale(LUMA);
+  op.fuse(PointOp::lut(table));
+  return op;
+}
+
+/**
+ * @brief Тонирование с силой: смесь исходного цвета и тонированного
+ * (1 - s) * rgb + s * tone * Y одной матрицей
+ * @param tone - цвет
+ * @param strength - сила 0..1
+ */
+PointOp toning(QColor tone, float strength) {
+  strength = std::clamp(strength, 0.0f, 1.0f);
+  float t[3];
+  tone.getRgbF(&t[RED], &t[GREEN], &t[BLUE]);
+  const float luma[3] = {0.299f, 0.587f, 0.114f};
+  Matrix mat{};
+  for (int c = RED; c <= BLUE; ++c)
+    for (int k = RED; k <= BLUE; ++k)
+      mat.m[c][k] = strength * t[c] * luma[k] + (c == k ? 1 - strength : 0);
+  return PointOp::matrix(mat);
+}
+
+/**
+ * @brief Настройки с ползунками одной операцией: матрицы обесцвечивания и
+ * тонирования перемножаются, таблица уровней становится post-таблицей.
+ * Смена яркости, контраста или гаммы пересобирает только таблицу 3x256
+ * @param adjustment - параметры
+ */
+PointOp adjustment(const Adjustment &adjustment) {
+  const float *w = adjustment.weights;
+  std::vector<PointOp> parts;
+  if (w[RED] > 0 || w[GREEN] > 0 || w[BLUE] > 0)
+    parts.push_back(grayscale(w[RED], w[GREEN], w[BLUE]));
+  if (adjustment.toning > 0)
+    parts.push_back(toning(adjustment.tone, adjustment.toning));
+  const Lut table = levels(adjustment.brightness, adjustment.contrast,
+                           adjustment.gamma);
+  if (parts.empty() || table != identityLut())
+    parts.push_back(PointOp::lut(table));
+  PointOp op = parts.front();
+  for (std::size_t i = 1; i < parts.size(); ++i) op.fuse(parts[i]);
+  return op;
+}
+
+/**
+ * @brief Применение к изображению в новый буфер RGB32 (строки делятся
+ * между потоками); исходный буфер не меняется
+ * @param op - операция
+ * @param image - изображение
+ * @param threads - число потоков (0 - по числу ядер)
+ */
+ImageBuffer apply(const PointOp &op, const ImageBuffer &image, int threads) {
+  const ImageBuffer source = image.convertTo(ImageBuffer::RGB32);
+  ImageBuffer res(source.width(), source.height(), ImageBuffer::RGB32);
+  if (res.isNull()) return res;
+  const int width = res.width();
+  uchar *bits = res.bits();
+  const qsizetype stride = res.stride();
+  parallel::forRange(
+      res.height(),
+      [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+          auto line = reinterpret_cast<QRgb *>(bits + y * stride);
+          std::memcpy(line, source.constLine(y), std::size_t(width) * 4);
+          op.apply(line, static_cast<std::size_t>(width));
+        }
+      },
+      threads, std::max(1, (1 << 16) / std::max(1, width)));
+  return res;
+}
+}  // namespace pointop
+}  // namespace model
@@ -0,0 +1,107 @@
+#ifndef POINTOP_HPP
+#define POINTOP_HPP
+
+#include <QColor>
+#include <QImage>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "imagebuffer.hpp"
+
+namespace model {
+namespace pointop {
+/**
+ * @brief Таблица 256 значений на каждый канал (индекс канала RED/GREEN/BLUE)
+ */
+using Lut = std::array<std::array<std::uint8_t, 256>, 3>;
+
+/**
+ * @brief Цветовая матрица 3x4: out[c] = m[c][0]*r + m[c][1]*g + m[c][2]*b +
+ * m[c][3], значения каналов в диапазоне 0..255
+ */
+struct Matrix {
+  float m[3][4];
+};
+
+/**
+ * @brief Параметры настроек с ползунками: оттенки серого с весами каналов
+ * (все веса 0 - без обесцвечивания), тонирование с силой 0..1, затем
+ * яркость (сдвиг -255..255), контраст (наклон вокруг 128) и гамма
+ */
+struct Adjustment {
+  float weights[3]{0, 0, 0};
+  QColor tone{255, 255, 255};
+  float toning{0};
+  float brightness{0};
+  float contrast{1};
+  float gamma{1};
+};
+
+Lut identityLut();
+Matrix identityMatrix();
+Lut levels(float brightness, float contrast, float gamma);
+
+/**
+ * @brief Скомпилированная поточечная операция вида post(M * pre(rgb)).
+ * Любая из трех частей может отсутствовать. Операции, которые не выражаются
+ * таблицами и матрицей, хранятся как функция пикселя
+ */
+class PointOp {
+ public:
+  static PointOp lut(const Lut &table);
+  static PointOp matrix(const Matrix &matrix);
+  static PointOp function(std::function<QRgb(QRgb)> fn);
+
+  bool fuse(const PointOp &next);
+  bool isLut() const;
+  bool isMatrix() const;
+  bool isFunction() const;
+  std::uint64_t digest() const;
+  QRgb apply(QRgb pixel) const;
+  void apply(QRgb *pixels, std::size_t count) const;
+
+ private:
+  bool hasPre{false};
+  bool hasMatrix{false};
+  bool hasPost{false};
+  Lut pre{};
+  Matrix mat{};
+  Lut post{};
+  std::function<QRgb(QRgb)> fn;
+};
+
+/**
+ * @brief Последовательность поточечных операций. При добавлении операция по
+ * возможности сливается с предыдущей, применяется все за один проход по
+ * строкам изображения
+ */
+class Program {
+ public:
+  void append(const PointOp &op);
+  bool isEmpty() const;
+  std::size_t size() const;
+  QRgb apply(QRgb pixel) const;
+  void apply(QRgb *pixels, std::size_t count) const;
+  void apply(QImage &img, int threads = 0) const;
+  bool applyToPalette(QImage &img) const;
+
+ private:
+  std::vector<PointOp> ops;
+};
+
+bool isIndexed(const QImage &img);
+PointOp negative();
+PointOp grayscale(char type);
+PointOp grayscale(float red, float green, float blue);
+PointOp toning(QColor tone);
+PointOp toning(QColor tone, float strength);
+PointOp sepia();
+PointOp adjustment(const Adjustment &adjustment);
+ImageBuffer apply(const PointOp &op, const ImageBuffer &image,
+                  int threads = 0);
+}  // namespace pointop
+}  // namespace model
+
+#endif
@@ -0,0 +1,170 @@
+#include "pyramid.hpp"
+
+#include <algorithm>
+
+#include "cpu.hpp"
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PYRAMID_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+// пикселей результата за итерацию векторного ядра
+constexpr std::size_t kStep = 4;
+
+using HalveKernel = void (*)(const QRgb *, const QRgb *, QRgb *,
+                             std::size_t);
+
+/**
+ * @brief Ряд уровня: каждый пиксель - среднее квадрата 2x2 из рядов a и b
+ * с округлением (сумма + 2) / 4 по каждому байту
+ */
+void halveScalar(const QRgb *a, const QRgb *b, QRgb *dst, std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const QRgb p[4] = {a[2 * i], a[2 * i + 1], b[2 * i], b[2 * i + 1]};
+    QRgb res = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      unsigned sum = 2;
+      for (QRgb v : p) sum += (v >> shift) & 0xff;
+      res |= (sum >> 2) << shift;
+    }
+    dst[i] = res;
+  }
+}
+
+#ifdef PYRAMID_X86
+__attribute__((target("avx2"))) void halveAvx2(const QRgb *a, const QRgb *b,
+                                               QRgb *dst,
+                                               std::size_t count) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i two = _mm256_set1_epi16(2);
+  for (std::size_t i = 0; i < count; i += kStep) {
+    __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + 2 * i));
+    __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + 2 * i));
+    // в каждой 128-битной половине 4 пикселя: lo - пиксели 0, 1, hi - 2, 3
+    __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(va, zero),
+                                  _mm256_unpacklo_epi8(vb, zero));
+    __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(va, zero),
+                                  _mm256_unpackhi_epi8(vb, zero));
+    // соседние пиксели ряда: сумма половин по 64 бита
+    lo = _mm256_add_epi16(lo,
+                          _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+    hi = _mm256_add_epi16(hi,
+                          _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m256i sum = _mm256_unpacklo_epi64(lo, hi);
+    sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+    __m256i packed = _mm256_packus_epi16(sum, sum);
+    packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm256_castsi256_si128(packed));
+  }
+}
+#endif
+
+model::cpu::Level kernelLevel() {
+  return model::cpu::pick({model::cpu::AVX2});
+}
+
+HalveKernel halveKernel() {
+#ifdef PYRAMID_X86
+  if (kernelLevel() == model::cpu::AVX2) return halveAvx2;
+#endif
+  return halveScalar;
+}
+}  // namespace
+
+namespace model {
+namespace pyramid {
+/**
+ * @brief Следующий уровень пирамиды: вдвое меньше по каждой стороне
+ * (нечетные последние ряд и столбец отбрасываются), пиксель - среднее
+ * квадрата 2x2. Ряды делятся между потоками
+ * @param src - уровень
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ * @return RGB32; пустой буфер, если уменьшать некуда
+ */
+ImageBuffer halve(const ImageBuffer &src, int threadsCount) {
+  if (src.width() < 2 || src.height() < 2) return ImageBuffer();
+  const ImageBuffer rgb = src.convertTo(ImageBuffer::RGB32);
+  const int w = rgb.width() / 2, h = rgb.height() / 2;
+  ImageBuffer res(w, h, ImageBuffer::RGB32);
+  uchar *bits = res.bits();
+  const qsizetype stride = res.stride();
+  const HalveKernel run = halveKernel();
+  const std::size_t body = w - w % kStep;
+  parallel::forRange(
+      h,
+      [&](int begin, int end) {
+        for (int y = begin; y < end; ++y) {
+          auto a = reinterpret_cast<const QRgb *>(rgb.constLine(2 * y));
+          auto b = reinterpret_cast<const QRgb *>(rgb.constLine(2 * y + 1));
+          auto dst = reinterpret_cast<QRgb *>(bits + y * stride);
+          if (body) run(a, b, dst, body);
+          halveScalar(a + 2 * body, b + 2 * body, dst + body, w - body);
+        }
+      },
+      threadsCount, 16);
+  return res;
+}
+
+/**
+ * @brief Пирамида (mip-уровни) для быстрого масштабирования: уровень 0 -
+ * само изображение (без копирования), каждый следующий вдвое меньше,
+ * пока меньшая сторона не станет меньше minSide
+ * @param src - изображение
+ * @param minSide - наименьшая сторона последнего уровня
+ * @param threadsCount - число потоков (0 - по числу ядер)
+ */
+std::vector<ImageBuffer> build(const ImageBuffer &src, int minSide,
+                               int threadsCount) {
+  std::vector<ImageBuffer> levels;
+  if (src.isNull()) return levels;
+  trace::Scope scope("pyramid");
+  levels.push_back(src);
+  while (std::min(levels.back().width(), levels.back().height()) / 2 >=
+         std::max(1, minSide)) {
+    levels.push_back(halve(levels.back(), threadsCount));
+    metrics::count("pyramid.levels");
+  }
+  return levels;
+}
+
+/**
+ * @brief Уровень для отображения в масштабе scale: самый маленький, который
+ * еще не меньше экранного размера
+ * @param scale - масштаб отображения уровня 0 (1 - пиксель в пиксель)
+ * @param widths - ширины уровней, начиная с уровня 0
+ */
+int levelFor(double scale, const std::vector<int> &widths) {
+  if (widths.empty() || scale <= 0) return 0;
+  const double width = widths.front() * scale;
+  int level = 0;
+  while (level + 1 < static_cast<int>(widths.size()) &&
+         widths[level + 1] >= width)
+    ++level;
+  return level;
+}
+
+/**
+ * @brief Уровень пирамиды для отображения в масштабе scale
+ * @param scale - масштаб отображения уровня 0 (1 - пиксель в пиксель)
+ * @param levels - пирамида
+ */
+int levelFor(double scale, const std::vector<ImageBuffer> &levels) {
+  std::vector<int> widths;
+  for (auto const &level : levels) widths.push_back(level.width());
+  return levelFor(scale, widths);
+}
+
+/**
+ * @brief Ядро уменьшения вдвое: avx2 или scalar
+ */
+const char *kernelName() { return cpu::name(kernelLevel()); }
+}  // namespace pyramid
+}  // namespace model
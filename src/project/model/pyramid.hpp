@@ -0,0 +1,19 @@
+#ifndef PYRAMID_HPP
+#define PYRAMID_HPP
+
+#include <vector>
+
+#include "imagebuffer.hpp"
+
+namespace model {
+namespace pyramid {
+ImageBuffer halve(const ImageBuffer &src, int threadsCount = 0);
+std::vector<ImageBuffer> build(const ImageBuffer &src, int minSide = 256,
+                               int threadsCount = 0);
+int levelFor(double scale, const std::vector<int> &widths);
+int levelFor(double scale, const std::vector<ImageBuffer> &levels);
+const char *kernelName();
+}  // namespace pyramid
+}  // namespace model
+
+#endif
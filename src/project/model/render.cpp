@@ -0,0 +1,331 @@
+#include "render.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "metrics.hpp"
+#include "parallel.hpp"
+#include "pyramid.hpp"
+#include "trace.hpp"
+
+namespace model {
+namespace render {
+/**
+ * @brief Одна отрисовка: цепочка, источник, очередь плиток и общий буфер
+ * результата, в который плитки пишутся по непересекающимся областям
+ */
+struct Renderer::Job {
+  std::uint64_t generation = 0;
+  pipeline::Pipeline chain;
+  ImageBuffer source;
+  QRect visible;
+  TileCallback onTile;
+  DoneCallback onDone;
+  // уровень черновика видимой области, еще не взятого потоком (0 - нет)
+  int level = 0;
+  bool drafting = false;
+  std::vector<QRect> pending;
+  int remaining = 0;
+  bool visibleDone = false;
+  bool cancelled = false;
+  ImageBuffer result;
+  uchar *bits = nullptr;
+  std::chrono::steady_clock::time_point begin;
+};
+
+namespace {
+double since(std::chrono::steady_clock::time_point begin) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - begin)
+      .count();
+}
+
+/**
+ * @brief Индекс следующей плитки: видимые раньше невидимых, внутри группы -
+ * ближайшие к центру видимой области
+ */
+std::size_t next(const std::vector<QRect> &pending, const QRect &visible) {
+  const QPoint center = visible.center();
+  std::size_t best = 0;
+  long long bestScore = 0;
+  for (std::size_t i = 0; i < pending.size(); ++i) {
+    const QPoint c = pending[i].center();
+    long long dx = c.x() - center.x(), dy = c.y() - center.y();
+    long long score = dx * dx + dy * dy;
+    if (!pending[i].intersects(visible)) score += 1LL << 62;
+    if (i == 0 || score < bestScore) {
+      best = i;
+      bestScore = score;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief Уровень пирамиды для масштаба показа: 0, если уменьшать не нужно
+ * @param size - размер изображения
+ * @param scale - масштаб показа (1 - пиксель в пиксель)
+ */
+int draftLevel(const QSize &size, double scale) {
+  std::vector<int> widths;
+  for (int w = size.width(), h = size.height(); w > 0 && h > 0;
+       w /= 2, h /= 2)
+    widths.push_back(w);
+  return pyramid::levelFor(scale, widths);
+}
+
+/**
+ * @brief Черновик видимой области: область (выровненная по шагу уровня)
+ * уменьшается до уровня level и обрабатывается цепочкой целиком
+ * @param chain - цепочка
+ * @param source - исходное изображение
+ * @param visible - видимая область
+ * @param level - уровень пирамиды
+ * @param area - покрытая черновиком часть изображения
+ * @return пиксели уровня или пустой буфер, если область слишком мала
+ */
+ImageBuffer draft(const pipeline::Pipeline &chain, const ImageBuffer &source,
+                  const QRect &visible, int level, QRect &area) {
+  const int step = 1 << level;
+  const QRect clipped = visible.intersected(source.rect());
+  const int left = clipped.left() / step * step;
+  const int top = clipped.top() / step * step;
+  ImageBuffer reduced = source.view(QRect(left, top,
+                                          clipped.right() + 1 - left,
+                                          clipped.bottom() + 1 - top));
+  for (int i = 0; i < level && !reduced.isNull(); ++i)
+    reduced = pyramid::halve(reduced);
+  if (reduced.isNull()) return ImageBuffer();
+  area = QRect(left, top, reduced.width() * step, reduced.height() * step);
+  return chain.region(reduced, reduced.rect());
+}
+}  // namespace
+
+/**
+ * @brief Пул фоновых потоков отрисовки
+ * @param workers - число потоков (0 - по числу ядер)
+ */
+Renderer::Renderer(int workers) {
+  const int count = parallel::threadsCount(workers);
+  for (int i = 0; i < count; ++i)
+    this->workers.emplace_back([this]() { work(); });
+}
+
+/**
+ * @brief Остановка: недоделанные плитки отбрасываются, потоки завершаются
+ */
+Renderer::~Renderer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    if (job) job->cancelled = true;
+  }
+  wake.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+/**
+ * @brief Запуск отрисовки; предыдущая отменяется
+ * @param chain - цепочка (копируется)
+ * @param source - исходное изображение
+ * @param visible - видимая область в координатах изображения
+ * @param scale - масштаб показа; при 0.5 и меньше сначала считается
+ * черновик видимой области на уровне пирамиды
+ * @param onTile - вызывается из фонового потока для каждой готовой плитки
+ * @param onDone - вызывается из фонового потока, когда готовы все плитки
+ * @param tileSize - сторона плитки
+ * @return номер отрисовки (для отбрасывания устаревших плиток)
+ */
+std::uint64_t Renderer::start(const pipeline::Pipeline &chain,
+                              const ImageBuffer &source, const QRect &visible,
+                              double scale, TileCallback onTile,
+                              DoneCallback onDone, int tileSize) {
+  auto fresh = std::make_shared<Job>();
+  fresh->chain = chain;
+  fresh->source = source.convertTo(ImageBuffer::RGB32);
+  fresh->visible = visible;
+  fresh->onTile = std::move(onTile);
+  fresh->onDone = std::move(onDone);
+  fresh->begin = std::chrono::steady_clock::now();
+  const int width = fresh->source.width(), height = fresh->source.height();
+  tileSize = std::max(16, tileSize);
+  for (int y = 0; y < height; y += tileSize)
+    for (int x = 0; x < width; x += tileSize)
+      fresh->pending.emplace_back(x, y, std::min(tileSize, width - x),
+                                 std::min(tileSize, height - y));
+  fresh->remaining = static_cast<int>(fresh->pending.size());
+  if (fresh->remaining > 0 && visible.intersects(fresh->source.rect()))
+    fresh->level = draftLevel(fresh->source.rect().size(), scale);
+  fresh->result = ImageBuffer(width, height, ImageBuffer::RGB32);
+  fresh->bits = fresh->result.bits();
+
+  std::uint64_t generation;
+  DoneCallback done;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job) job->cancelled = true;
+    generation = fresh->generation = ++counter;
+    job = fresh;
+    if (fresh->pending.empty()) done = fresh->onDone;
+  }
+  wake.notify_all();
+  if (done) done(generation);
+  return generation;
+}
+
+/**
+ * @brief Готовый результат (например, из кеша) как завершенная отрисовка:
+ * предыдущая отменяется, плитка на все изображение и завершение
+ * сообщаются сразу, в вызывающем потоке
+ * @param result - результат
+ * @param onTile - получает одну плитку на все изображение
+ * @param onDone - вызывается после нее
+ * @return номер отрисовки
+ */
+std::uint64_t Renderer::present(const ImageBuffer &result, TileCallback onTile,
+                                DoneCallback onDone) {
+  auto fresh = std::make_shared<Job>();
+  fresh->result = result.convertTo(ImageBuffer::RGB32);
+  fresh->visibleDone = true;
+  std::uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job) job->cancelled = true;
+    generation = fresh->generation = ++counter;
+    job = fresh;
+  }
+  if (onTile)
+    onTile(Tile{generation, fresh->result.rect(), fresh->result, true});
+  if (onDone) onDone(generation);
+  return generation;
+}
+
+/**
+ * @brief Смена видимой области (прокрутка, масштаб): оставшиеся плитки
+ * выбираются заново относительно нее
+ * @param visible - видимая область в координатах изображения
+ */
+void Renderer::setVisible(const QRect &visible) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (job) job->visible = visible;
+}
+
+/**
+ * @brief Отмена текущей отрисовки (посчитанные плитки остаются)
+ */
+void Renderer::cancel() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!job) return;
+  job->cancelled = true;
+  job->level = 0;
+  job->pending.clear();
+}
+
+/**
+ * @brief Ожидание, пока потоки не закончат все плитки текущей отрисовки
+ */
+void Renderer::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this]() {
+    return busy == 0 && (!job || job->pending.empty());
+  });
+}
+
+/**
+ * @brief Номер последней запущенной отрисовки
+ */
+std::uint64_t Renderer::generation() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return counter;
+}
+
+/**
+ * @brief Итог отрисовки: пустой буфер, пока готовы не все плитки
+ */
+ImageBuffer Renderer::result() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!job || job->cancelled || job->remaining > 0) return ImageBuffer();
+  return job->result;
+}
+
+/**
+ * @brief Цикл фонового потока: сначала черновик видимой области (все ядра,
+ * остальные потоки ждут, чтобы плитки полного разрешения пришли после
+ * него), затем лучшая плитка текущей отрисовки. Плитка считается одним
+ * потоком (параллельность - между плитками), копируется в общий результат
+ * и сообщается
+ */
+void Renderer::work() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [this]() {
+      return stopping ||
+             (job && (job->level > 0 ||
+                      (!job->drafting && !job->pending.empty())));
+    });
+    if (stopping) return;
+    std::shared_ptr<Job> current = job;
+    if (current->level > 0) {
+      const int level = current->level;
+      current->level = 0;
+      current->drafting = true;
+      ++busy;
+      lock.unlock();
+      QRect area;
+      ImageBuffer pixels;
+      {
+        trace::Scope scope("render", "draft");
+        pixels = draft(current->chain, current->source, current->visible,
+                       level, area);
+      }
+      if (!pixels.isNull() && current->onTile)
+        current->onTile(
+            Tile{current->generation, area, pixels, true, level});
+      lock.lock();
+      if (!pixels.isNull())
+        metrics::time("render.first_draft", since(current->begin));
+      current->drafting = false;
+      --busy;
+      wake.notify_all();
+      idle.notify_all();
+      continue;
+    }
+    const std::size_t index = next(current->pending, current->visible);
+    const QRect rect = current->pending[index];
+    const bool visible = rect.intersects(current->visible);
+    current->pending[index] = current->pending.back();
+    current->pending.pop_back();
+    ++busy;
+    lock.unlock();
+
+    ImageBuffer pixels;
+    {
+      trace::Scope scope("render", visible ? "visible" : "background");
+      pixels = current->chain.region(current->source, rect, 0, 1);
+    }
+    const qsizetype stride = current->result.stride();
+    for (int y = 0; y < rect.height(); ++y)
+      std::memcpy(current->bits + (rect.y() + y) * stride + rect.x() * 4,
+                  pixels.constLine(y), rect.width() * 4);
+    if (current->onTile)
+      current->onTile(Tile{current->generation, rect, pixels, visible});
+
+    lock.lock();
+    bool done = --current->remaining == 0 && !current->cancelled;
+    if (visible && !current->visibleDone) {
+      current->visibleDone = true;
+      metrics::time("render.first_visible_tile", since(current->begin));
+    }
+    if (done) {
+      metrics::time("render.total", since(current->begin));
+      lock.unlock();
+      if (current->onDone) current->onDone(current->generation);
+      lock.lock();
+    }
+    --busy;
+    idle.notify_all();
+  }
+}
+}  // namespace render
+}  // namespace model
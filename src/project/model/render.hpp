@@ -0,0 +1,78 @@
+#ifndef RENDER_HPP
+#define RENDER_HPP
+
+#include <QRect>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "imagebuffer.hpp"
+#include "pipeline.hpp"
+
+namespace model {
+namespace render {
+/**
+ * @brief Готовая плитка результата. Плитка уровня level > 0 - черновик:
+ * пиксели покрывают rect с шагом 2^level и не входят в итоговый результат
+ */
+struct Tile {
+  std::uint64_t generation;
+  QRect rect;
+  ImageBuffer pixels;
+  bool visible;
+  int level = 0;
+};
+
+/**
+ * @brief Фоновая отрисовка цепочки плитками. При уменьшенном показе сначала
+ * вся видимая область считается на уровне пирамиды, подходящем масштабу
+ * (одна черновая плитка), затем плитки полного разрешения: пересекающие
+ * видимую область (ближние к ее центру раньше), потом остальные. Новый
+ * запуск или смена видимой области меняют порядок оставшихся плиток,
+ * посчитанные не пересчитываются
+ */
+class Renderer {
+ public:
+  using TileCallback = std::function<void(const Tile &)>;
+  using DoneCallback = std::function<void(std::uint64_t)>;
+
+  explicit Renderer(int workers = 0);
+  ~Renderer();
+  Renderer(const Renderer &) = delete;
+  Renderer &operator=(const Renderer &) = delete;
+
+  std::uint64_t start(const pipeline::Pipeline &chain,
+                      const ImageBuffer &source, const QRect &visible,
+                      double scale, TileCallback onTile = {},
+                      DoneCallback onDone = {},
+                      int tileSize = 256);
+  std::uint64_t present(const ImageBuffer &result, TileCallback onTile = {},
+                        DoneCallback onDone = {});
+  void setVisible(const QRect &visible);
+  void cancel();
+  void wait();
+  std::uint64_t generation() const;
+  ImageBuffer result() const;
+
+ private:
+  struct Job;
+
+  void work();
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::shared_ptr<Job> job;
+  std::vector<std::thread> workers;
+  std::uint64_t counter = 0;
+  int busy = 0;
+  bool stopping = false;
+};
+}  // namespace render
+}  // namespace model
+
+#endif
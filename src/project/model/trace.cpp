@@ -0,0 +1,178 @@
+#include "trace.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <set>
+#include <vector>
+
+#include "perthread.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// ограничение на число событий, чтобы забытая включенная трассировка не
+// съедала память
+constexpr std::size_t kMaxEvents = 1 << 20;
+
+struct Event {
+  std::string name;
+  std::string args;
+  Clock::time_point begin;
+  Clock::time_point end;
+  int tid;
+};
+
+// события одного потока: пишутся без общей блокировки и собираются при
+// сохранении
+struct Events {
+  std::vector<Event> list;
+
+  void merge(const Events &other) {
+    list.insert(list.end(), other.list.begin(), other.list.end());
+  }
+};
+
+using Buffers = model::PerThread<Events>;
+
+std::atomic<bool> enabled{false};
+std::atomic<int> nextTid{0};
+std::atomic<std::size_t> recorded{0};
+std::atomic<Clock::rep> epoch{Clock::now().time_since_epoch().count()};
+
+/**
+ * @brief Короткий номер текущего потока (0 - первый записавший поток)
+ */
+int threadId() {
+  thread_local int tid = nextTid++;
+  return tid;
+}
+
+/**
+ * @brief Экранирование строки для JSON
+ */
+std::string escape(std::string const &str) {
+  std::string res;
+  res.reserve(str.size());
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      res += '\\';
+      res += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      res += ' ';
+    } else {
+      res += c;
+    }
+  }
+  return res;
+}
+
+double micros(Clock::time_point point) {
+  const Clock::time_point start{Clock::duration(epoch.load())};
+  return std::chrono::duration<double, std::micro>(point - start).count();
+}
+}  // namespace
+
+namespace model {
+namespace trace {
+
+/**
+ * @brief Включение/выключение записи событий
+ * @param on - true, чтобы начать запись
+ */
+void enable(bool on) { enabled = on; }
+
+/**
+ * @brief Проверка, ведется ли запись
+ */
+bool isEnabled() { return enabled; }
+
+/**
+ * @brief Очистка накопленных событий
+ */
+void clear() {
+  Buffers::forEach([](Events &events) { events.list.clear(); });
+  recorded = 0;
+  epoch = Clock::now().time_since_epoch().count();
+}
+
+/**
+ * @brief Количество накопленных событий
+ */
+std::size_t eventsCount() {
+  std::size_t res = 0;
+  Buffers::forEach([&res](Events &events) { res += events.list.size(); });
+  return res;
+}
+
+/**
+ * @brief Запись завершенного интервала в буфер текущего потока
+ * @param name - имя этапа (load, convert, convolution, pack, save ...)
+ * @param begin - время начала
+ * @param end - время окончания
+ * @param args - дополнительное описание (номер тайла, канал и т.д.)
+ */
+void record(const std::string &name, Clock::time_point begin,
+            Clock::time_point end, const std::string &args) {
+  if (!enabled || recorded++ >= kMaxEvents) return;
+  const int tid = threadId();
+  Buffers::update([&](Events &events) {
+    events.list.push_back({name, args, begin, end, tid});
+  });
+}
+
+/**
+ * @brief Сохранение событий в формате Chrome trace (chrome://tracing,
+ * ui.perfetto.dev)
+ * @param path - путь к json файлу
+ * @return true, если файл записан
+ */
+bool writeChromeJson(const std::string &path) {
+  std::ofstream out(path);
+  if (!out) return false;
+  Events events;
+  Buffers::forEach([&events](Events &buffer) { events.merge(buffer); });
+  std::set<int> threads;
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (auto const &e : events.list) {
+    threads.insert(e.tid);
+    out << (first ? "" : ",") << "\n{\"name\":\"" << escape(e.name)
+        << "\",\"cat\":\"photolab\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+        << ",\"ts\":" << micros(e.begin)
+        << ",\"dur\":" << micros(e.end) - micros(e.begin);
+    if (!e.args.empty())
+      out << ",\"args\":{\"detail\":\"" << escape(e.args) << "\"}";
+    out << "}";
+    first = false;
+  }
+  for (int tid : threads) {
+    out << (first ? "" : ",")
+        << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+        << ",\"args\":{\"name\":\""
+        << (tid == 0 ? std::string("main") : "worker-" + std::to_string(tid))
+        << "\"}}";
+    first = false;
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+/**
+ * @brief Начало интервала
+ * @param name - имя этапа
+ * @param args - дополнительное описание
+ */
+Scope::Scope(std::string name, std::string args)
+    : active(enabled),
+      name(std::move(name)),
+      args(std::move(args)),
+      begin(Clock::now()) {}
+
+/**
+ * @brief Окончание интервала и запись события
+ */
+Scope::~Scope() {
+  if (active) record(name, begin, Clock::now(), args);
+}
+}  // namespace trace
+}  // namespace model
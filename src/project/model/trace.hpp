@@ -0,0 +1,38 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <string>
+
+namespace model {
+namespace trace {
+void enable(bool on);
+bool isEnabled();
+void clear();
+std::size_t eventsCount();
+void record(const std::string &name, std::chrono::steady_clock::time_point begin,
+            std::chrono::steady_clock::time_point end,
+            const std::string &args = {});
+bool writeChromeJson(const std::string &path);
+
+/**
+ * @brief RAII-интервал: фиксирует начало в конструкторе и пишет событие с
+ * идентификатором потока в деструкторе (если трассировка включена)
+ */
+class Scope {
+ public:
+  explicit Scope(std::string name, std::string args = {});
+  ~Scope();
+  Scope(Scope const &) = delete;
+  Scope &operator=(Scope const &) = delete;
+
+ private:
+  bool active;
+  std::string name;
+  std::string args;
+  std::chrono::steady_clock::time_point begin;
+};
+}  // namespace trace
+}  // namespace model
+
+#endif
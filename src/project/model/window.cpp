@@ -0,0 +1,56 @@
+#include "window.hpp"
+
+#include "channel.hpp"
+
+namespace model {
+namespace window {
+/**
+ * @brief Все пиксели полосы серые (R = G = B): фильтр может считать одну
+ * плоскость вместо трех. Если это известно заранее (in.gray), пиксели не
+ * просматриваются, иначе проверка до первого цветного пикселя
+ * @param in - полоса
+ */
+bool isGray(const Strip &in) {
+  if (in.gray) return true;
+  const QRgb *end = in.px + static_cast<std::size_t>(in.count) * in.width;
+  return std::all_of(in.px, end, [](QRgb p) {
+    return ((p ^ (p >> 8)) & 0xffff) == 0;
+  });
+}
+
+/**
+ * @brief Один канал полосы в отдельную плоскость
+ * @param in - полоса
+ * @param channel - RED, GREEN или BLUE
+ * @param plane - плоскость count x width
+ */
+void split(const Strip &in, int channel, Plane &plane) {
+  const int shift = (BLUE - channel) * 8;
+  const std::size_t size = static_cast<std::size_t>(in.count) * in.width;
+  plane.resize(size);
+  for (std::size_t i = 0; i < size; ++i)
+    plane[i] = std::uint8_t(in.px[i] >> shift);
+}
+
+/**
+ * @brief Сборка пикселей из плоскостей результата: одна плоскость -
+ * серое изображение, три - каналы RED, GREEN, BLUE
+ * @param planes - плоскости rows x width
+ * @param channels - 1 или 3
+ * @param width - ширина
+ * @param rows - число строк
+ * @param out - пиксели результата
+ */
+void merge(const Plane *planes, int channels, int width, int rows,
+           QRgb *out) {
+  const std::size_t size = static_cast<std::size_t>(rows) * width;
+  if (channels == 1) {
+    for (std::size_t i = 0; i < size; ++i)
+      out[i] = qRgb(planes[0][i], planes[0][i], planes[0][i]);
+    return;
+  }
+  for (std::size_t i = 0; i < size; ++i)
+    out[i] = qRgb(planes[RED][i], planes[GREEN][i], planes[BLUE][i]);
+}
+}  // namespace window
+}  // namespace model
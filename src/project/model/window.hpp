@@ -0,0 +1,54 @@
+#ifndef WINDOW_HPP
+#define WINDOW_HPP
+
+#include <QImage>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace model {
+namespace window {
+/**
+ * @brief Полоса строк RGB32 для оконного фильтра: строки [first, first +
+ * count) шириной width, left - столбец изображения, с которого начинается
+ * полоса. За краями полосы - края изображения (или запас вокруг области,
+ * ошибки в котором до результата не доходят), поэтому крайние строки и
+ * столбцы повторяются. gray - все пиксели заведомо серые (известно по
+ * формату источника), проверять их не нужно
+ */
+struct Strip {
+  int first;
+  int count;
+  int width;
+  const QRgb *px;
+  int left = 0;
+  bool gray = false;
+
+  const QRgb *row(int y) const {
+    y = std::clamp(y, first, first + count - 1);
+    return px + static_cast<std::size_t>(y - first) * width;
+  }
+};
+
+/**
+ * @brief Оконный (нелинейный) фильтр: строки [lo, hi) результата по полосе
+ * in, out - hi - lo строк шириной in.width
+ */
+using Filter =
+    std::function<void(const Strip &in, int lo, int hi, QRgb *out)>;
+
+/**
+ * @brief Плоскость одного канала полосы: строки полосы подряд, без
+ * выравнивания (stride = width)
+ */
+using Plane = std::vector<std::uint8_t>;
+
+bool isGray(const Strip &in);
+void split(const Strip &in, int channel, Plane &plane);
+void merge(const Plane *planes, int channels, int width, int rows, QRgb *out);
+}  // namespace window
+}  // namespace model
+
+#endif
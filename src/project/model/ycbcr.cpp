@@ -0,0 +1,198 @@
+#include "ycbcr.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "cpu.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define YCBCR_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+// пикселей за итерацию векторного ядра; хвост дополняется до этого размера
+constexpr std::size_t kStep = 8;
+
+// BT.601, полный диапазон (как в JPEG), цветоразностные без смещения 128
+constexpr float kYr = 0.299f, kYg = 0.587f, kYb = 0.114f;
+constexpr float kCbr = -0.168736f, kCbg = -0.331264f, kCbb = 0.5f;
+constexpr float kCrr = 0.5f, kCrg = -0.418688f, kCrb = -0.081312f;
+constexpr float kRcr = 1.402f, kGcb = -0.344136f, kGcr = -0.714136f;
+constexpr float kBcb = 1.772f;
+
+using SplitKernel = void (*)(const QRgb *, float *, float *, float *,
+                             std::size_t);
+using MergeKernel = void (*)(const float *, const float *, const float *,
+                             QRgb *, std::size_t);
+
+int toByte(float value) {
+  return static_cast<int>(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+}
+
+/**
+ * @brief Скалярное разделение на плоскости Y, Cb, Cr (любая может быть
+ * nullptr)
+ */
+void splitScalar(const QRgb *src, float *y, float *cb, float *cr,
+                 std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    float r = qRed(src[i]), g = qGreen(src[i]), b = qBlue(src[i]);
+    if (y) y[i] = kYr * r + kYg * g + kYb * b;
+    if (cb) cb[i] = kCbr * r + kCbg * g + kCbb * b;
+    if (cr) cr[i] = kCrr * r + kCrg * g + kCrb * b;
+  }
+}
+
+/**
+ * @brief Скалярная сборка пикселей RGB32 из плоскостей
+ */
+void mergeScalar(const float *y, const float *cb, const float *cr, QRgb *dst,
+                 std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i)
+    dst[i] = qRgb(toByte(y[i] + kRcr * cr[i]),
+                  toByte(y[i] + kGcb * cb[i] + kGcr * cr[i]),
+                  toByte(y[i] + kBcb * cb[i]));
+}
+
+#ifdef YCBCR_X86
+__attribute__((target("avx2"))) inline __m256 mix(__m256 r, __m256 g,
+                                                  __m256 b, float kr,
+                                                  float kg, float kb) {
+  __m256 v = _mm256_mul_ps(_mm256_set1_ps(kr), r);
+  v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(kg), g));
+  return _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(kb), b));
+}
+
+__attribute__((target("avx2"))) inline __m256i pack(__m256 v) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 max = _mm256_set1_ps(255.0f);
+  v = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(v, zero), max),
+                    _mm256_set1_ps(0.5f));
+  return _mm256_cvttps_epi32(v);
+}
+
+/**
+ * @brief AVX2: 8 пикселей за итерацию, порядок операций как в скалярном
+ * ядре (без FMA), поэтому результаты совпадают
+ */
+__attribute__((target("avx2"))) void splitAvx2(const QRgb *src, float *y,
+                                               float *cb, float *cr,
+                                               std::size_t count) {
+  const __m256i mask = _mm256_set1_epi32(0xff);
+  for (std::size_t i = 0; i < count; i += kStep) {
+    __m256i p =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m256 r =
+        _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask));
+    __m256 g =
+        _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask));
+    __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(p, mask));
+    if (y) _mm256_storeu_ps(y + i, mix(r, g, b, kYr, kYg, kYb));
+    if (cb) _mm256_storeu_ps(cb + i, mix(r, g, b, kCbr, kCbg, kCbb));
+    if (cr) _mm256_storeu_ps(cr + i, mix(r, g, b, kCrr, kCrg, kCrb));
+  }
+}
+
+/**
+ * @brief AVX2: сборка 8 пикселей за итерацию
+ */
+__attribute__((target("avx2"))) void mergeAvx2(const float *y,
+                                               const float *cb,
+                                               const float *cr, QRgb *dst,
+                                               std::size_t count) {
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000u));
+  for (std::size_t i = 0; i < count; i += kStep) {
+    __m256 vy = _mm256_loadu_ps(y + i);
+    __m256 vcb = _mm256_loadu_ps(cb + i);
+    __m256 vcr = _mm256_loadu_ps(cr + i);
+    __m256 r = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_set1_ps(kRcr), vcr));
+    __m256 g = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_set1_ps(kGcb), vcb));
+    g = _mm256_add_ps(g, _mm256_mul_ps(_mm256_set1_ps(kGcr), vcr));
+    __m256 b = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_set1_ps(kBcb), vcb));
+    __m256i res = _mm256_or_si256(alpha, _mm256_slli_epi32(pack(r), 16));
+    res = _mm256_or_si256(res, _mm256_slli_epi32(pack(g), 8));
+    res = _mm256_or_si256(res, pack(b));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), res);
+  }
+}
+#endif
+
+model::cpu::Level kernelLevel() {
+  return model::cpu::pick({model::cpu::AVX2});
+}
+
+SplitKernel splitKernel() {
+#ifdef YCBCR_X86
+  if (kernelLevel() == model::cpu::AVX2) return splitAvx2;
+#endif
+  return splitScalar;
+}
+
+MergeKernel mergeKernel() {
+#ifdef YCBCR_X86
+  if (kernelLevel() == model::cpu::AVX2) return mergeAvx2;
+#endif
+  return mergeScalar;
+}
+}  // namespace
+
+namespace model {
+namespace ycbcr {
+
+/**
+ * @brief Перевод ряда пикселей RGB32 в плоскости Y, Cb, Cr (BT.601, полный
+ * диапазон). Ненужные плоскости можно не считать, передав nullptr
+ * @param src - пиксели
+ * @param y - яркость 0..255
+ * @param cb - синяя цветоразностная -127.5..127.5
+ * @param cr - красная цветоразностная -127.5..127.5
+ * @param count - количество пикселей
+ */
+void split(const QRgb *src, float *y, float *cb, float *cr,
+           std::size_t count) {
+  SplitKernel run = splitKernel();
+  std::size_t body = count - count % kStep;
+  if (body) run(src, y, cb, cr, body);
+  if (body == count) return;
+  const std::size_t rest = count - body;
+  QRgb tail[kStep] = {};
+  float planes[3][kStep];
+  std::memcpy(tail, src + body, rest * sizeof(QRgb));
+  run(tail, planes[0], planes[1], planes[2], kStep);
+  float *out[3] = {y, cb, cr};
+  for (int c = 0; c < 3; ++c)
+    if (out[c]) std::memcpy(out[c] + body, planes[c], rest * sizeof(float));
+}
+
+/**
+ * @brief Обратный перевод плоскостей в пиксели RGB32 с округлением и
+ * ограничением 0..255
+ * @param y - яркость
+ * @param cb - синяя цветоразностная
+ * @param cr - красная цветоразностная
+ * @param dst - результат
+ * @param count - количество пикселей
+ */
+void merge(const float *y, const float *cb, const float *cr, QRgb *dst,
+           std::size_t count) {
+  MergeKernel run = mergeKernel();
+  std::size_t body = count - count % kStep;
+  if (body) run(y, cb, cr, dst, body);
+  if (body == count) return;
+  const std::size_t rest = count - body;
+  float planes[3][kStep] = {};
+  const float *in[3] = {y, cb, cr};
+  for (int c = 0; c < 3; ++c)
+    std::memcpy(planes[c], in[c] + body, rest * sizeof(float));
+  QRgb tail[kStep];
+  run(planes[0], planes[1], planes[2], tail, kStep);
+  std::memcpy(dst + body, tail, rest * sizeof(QRgb));
+}
+
+/**
+ * @brief Ядро перевода в YCbCr и обратно: avx2 или scalar
+ */
+const char *kernelName() { return cpu::name(kernelLevel()); }
+}  // namespace ycbcr
+}  // namespace model
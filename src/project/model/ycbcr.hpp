@@ -0,0 +1,17 @@
+#ifndef YCBCR_HPP
+#define YCBCR_HPP
+
+#include <QImage>
+#include <cstddef>
+
+namespace model {
+namespace ycbcr {
+void split(const QRgb *src, float *y, float *cb, float *cr,
+           std::size_t count);
+void merge(const float *y, const float *cb, const float *cr, QRgb *dst,
+           std::size_t count);
+const char *kernelName();
+}  // namespace ycbcr
+}  // namespace model
+
+#endif
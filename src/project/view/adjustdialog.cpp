@@ -0,0 +1,87 @@
+#include "adjustdialog.h"
+
+#include <QColorDialog>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <cmath>
+
+namespace s21 {
+/**
+ * @brief окно с ползунками в нейтральном положении (операция тождественная)
+ *
+ * @param parent родитель
+ */
+AdjustDialog::AdjustDialog(QWidget *parent) : QDialog(parent) {
+  setWindowTitle(tr("Adjust"));
+  auto layout = new QFormLayout(this);
+  brightness = slider(-100, 100, 0);
+  contrast = slider(-100, 100, 0);
+  gamma = slider(10, 300, 100);
+  layout->addRow(tr("Brightness"), brightness);
+  layout->addRow(tr("Contrast"), contrast);
+  layout->addRow(tr("Gamma"), gamma);
+  const char *names[3] = {"Grayscale red", "Grayscale green",
+                          "Grayscale blue"};
+  for (int c = RED; c <= BLUE; ++c) {
+    weights[c] = slider(0, 100, 0);
+    layout->addRow(tr(names[c]), weights[c]);
+  }
+  toneButton = new QPushButton(tone.name(), this);
+  connect(toneButton, &QPushButton::clicked, this, &AdjustDialog::choose_tone);
+  toning = slider(0, 100, 0);
+  layout->addRow(tr("Tone"), toneButton);
+  layout->addRow(tr("Toning"), toning);
+  auto buttons = new QDialogButtonBox(
+      QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+  connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+  layout->addRow(buttons);
+}
+
+/**
+ * @brief текущие параметры: яркость в единицах 0..255, контраст от 1/4 до
+ * 4 (ползунок в логарифмической шкале), гамма от 0.1 до 3
+ *
+ * @return model::pointop::Adjustment
+ */
+model::pointop::Adjustment AdjustDialog::adjustment() const {
+  model::pointop::Adjustment res;
+  res.brightness = brightness->value() * 2.55f;
+  res.contrast = std::pow(2.0f, contrast->value() / 50.0f);
+  res.gamma = gamma->value() / 100.0f;
+  for (int c = RED; c <= BLUE; ++c)
+    res.weights[c] = weights[c]->value() / 100.0f;
+  res.tone = tone;
+  res.toning = toning->value() / 100.0f;
+  return res;
+}
+
+/**
+ * @brief горизонтальный ползунок, сообщающий о каждом движении
+ *
+ * @param minimum наименьшее значение
+ * @param maximum наибольшее значение
+ * @param value начальное значение
+ * @return QSlider*
+ */
+QSlider *AdjustDialog::slider(int minimum, int maximum, int value) {
+  auto res = new QSlider(Qt::Horizontal, this);
+  res->setRange(minimum, maximum);
+  res->setValue(value);
+  res->setMinimumWidth(240);
+  connect(res, &QSlider::valueChanged, this, &AdjustDialog::changed);
+  return res;
+}
+
+/**
+ * @brief выбор цвета тонирования
+ *
+ */
+void AdjustDialog::choose_tone() {
+  const QColor chosen = QColorDialog::getColor(tone, this);
+  if (!chosen.isValid()) return;
+  tone = chosen;
+  toneButton->setText(tone.name());
+  emit changed();
+}
+}  // namespace s21
@@ -0,0 +1,43 @@
+#ifndef ADJUSTDIALOG_H
+#define ADJUSTDIALOG_H
+
+#include <QColor>
+#include <QDialog>
+#include <QPushButton>
+#include <QSlider>
+
+#include "channel.hpp"
+#include "pointop.hpp"
+
+namespace s21 {
+/**
+ * @brief Окно настроек с ползунками: яркость, контраст, гамма, оттенки
+ * серого с весами каналов и сила тонирования. Каждое движение ползунка
+ * сообщается сигналом changed, параметры читаются через adjustment
+ */
+class AdjustDialog : public QDialog {
+  Q_OBJECT
+
+ public:
+  explicit AdjustDialog(QWidget *parent = nullptr);
+
+  model::pointop::Adjustment adjustment() const;
+
+ signals:
+  void changed();
+
+ private:
+  QSlider *slider(int minimum, int maximum, int value);
+  void choose_tone();
+
+  QSlider *brightness;
+  QSlider *contrast;
+  QSlider *gamma;
+  QSlider *weights[3];
+  QSlider *toning;
+  QPushButton *toneButton;
+  QColor tone{255, 160, 64};
+};
+}  // namespace s21
+
+#endif  // ADJUSTDIALOG_H
@@ -0,0 +1,186 @@
+#include "cli.h"
+
+#include <cstring>
+
+#include "diskcache.hpp"
+#include "histogram.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+
+namespace s21 {
+/**
+ * @brief проверяет, запрошен ли консольный режим (передан входной файл)
+ *
+ * @param argc количество аргументов
+ * @param argv аргументы
+ * @return true, если нужно работать без окна
+ */
+bool cli::isRequested(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i)
+    if (!std::strcmp(argv[i], "-i") || !std::strcmp(argv[i], "--input") ||
+        !std::strcmp(argv[i], "-h") || !std::strcmp(argv[i], "--help"))
+      return true;
+  return false;
+}
+
+namespace {
+/**
+ * @brief загружает входной файл, применяет цепочку и сохраняет результат
+ *
+ * @param parser разобранные аргументы
+ * @param output выходной файл
+ * @param roi область обработки (пустая - все изображение)
+ * @return true при успехе, иначе причина выводится в stderr
+ */
+bool render(const QCommandLineParser &parser, const QString &output,
+            const QRect &roi) {
+  ProgramData data;
+  data.filename = parser.value("input");
+  if (!controller::image_validation(data)) {
+    std::cerr << "Invalid image or filename.\n";
+    return false;
+  }
+  QString reason;
+  bool status{false};
+  QImage result = controller::process(data, parser.values("filter"), reason,
+                                      status, parser.isSet("luma-only"), roi);
+  if (!status) {
+    std::cerr << reason.toStdString() << "\n";
+    return false;
+  }
+  bool saved;
+  {
+    model::trace::Scope scope("save");
+    saved = result.save(output);
+  }
+  if (!saved) std::cerr << "Unable to save image.\n";
+  return saved;
+}
+
+/**
+ * @brief выводит сводку гистограммы сохраненного результата (в том виде,
+ * в каком он записан в файл)
+ *
+ * @param output выходной файл
+ * @return true при успехе
+ */
+bool printHistogram(const QString &output) {
+  const QImage result(output);
+  if (result.isNull()) {
+    std::cerr << "Unable to read result.\n";
+    return false;
+  }
+  std::cout << model::histogram::report(
+      model::histogram::compute(model::ImageBuffer::fromImage(result)));
+  return true;
+}
+}  // namespace
+
+/**
+ * @brief консольный режим: применяет цепочку фильтров к файлу и сохраняет
+ * результат
+ *
+ * @param app приложение
+ * @return int код возврата
+ */
+int cli::run(QCoreApplication &app) {
+  QCommandLineParser parser;
+  parser.setApplicationDescription("photolab command line mode");
+  parser.addHelpOption();
+  parser.addOptions({
+      {{"i", "input"}, "Input image.", "file"},
+      {{"o", "output"}, "Output image.", "file"},
+      {{"f", "filter"},
+       "Filter to apply, may be repeated to build a chain: emboss, sharpen, "
+       "box-blur, gaussian-blur, laplacian, prewitt, negative, "
+       "grayscale[:average|luma|dissat|r,g,b], toning:#rrggbb[,strength], "
+       "levels:brightness,contrast,gamma, sepia, median[:radius], "
+       "bilateral[:spatial,range], erode|dilate|open|close[:rx[,ry]], "
+       "gradient[:sobel|prewitt,l1|l2,orientation], "
+       "custom:k1,k2,..., "
+       "matrix:m11,...,m33[,offsets].",
+       "name[:argument]"},
+      {"luma-only",
+       "Apply convolution filters to luminance (Y of YCbCr) only."},
+      {"roi", "Filter only this region, pixels around it are read as halo.",
+       "x,y,width,height"},
+      {"trace", "Write Chrome trace JSON of the run.", "file"},
+      {"metrics", "Print stage metrics after the run."},
+      {"histogram", "Print histogram statistics of the result."},
+      {"cache-dir",
+       "Reuse results of earlier runs stored in this directory, keyed by "
+       "input file content and the filter chain.",
+       "dir"},
+      {"cache-limit",
+       "Size limit of the cache directory, 1024 by default. Requires "
+       "cache-dir.",
+       "megabytes"},
+  });
+  parser.process(app);
+
+  if (!parser.isSet("input") || !parser.isSet("output") ||
+      !parser.isSet("filter")) {
+    std::cerr << "input, output and filter are required\n";
+    return 1;
+  }
+  if (parser.isSet("trace")) model::trace::enable(true);
+
+  QString reason;
+  QRect roi;
+  if (parser.isSet("roi") &&
+      !controller::parseRect(parser.value("roi"), roi, reason)) {
+    std::cerr << reason.toStdString() << "\n";
+    return 1;
+  }
+  if (parser.isSet("cache-limit") && !parser.isSet("cache-dir")) {
+    std::cerr << "cache-limit requires cache-dir\n";
+    return 1;
+  }
+  std::unique_ptr<model::cache::DiskCache> cache;
+  std::uint64_t key{0};
+  const QString output = parser.value("output");
+  const std::string extension =
+      QFileInfo(output).suffix().toLower().toStdString();
+  if (parser.isSet("cache-dir")) {
+    std::uintmax_t limit = model::cache::DiskCache::kDefaultLimit;
+    if (parser.isSet("cache-limit")) {
+      bool ok{false};
+      const qulonglong megabytes = parser.value("cache-limit").toULongLong(&ok);
+      if (!ok) {
+        std::cerr << "Invalid cache limit.\n";
+        return 1;
+      }
+      limit = std::uintmax_t(megabytes) << 20;
+    }
+    model::pipeline::Pipeline pipeline;
+    if (!controller::makePipeline(parser.values("filter"), pipeline, reason,
+                                  parser.isSet("luma-only"))) {
+      std::cerr << reason.toStdString() << "\n";
+      return 1;
+    }
+    cache = std::make_unique<model::cache::DiskCache>(
+        parser.value("cache-dir").toStdString(), limit);
+    std::uint64_t content{0};
+    if (!cache->isValid() ||
+        !model::cache::hashFile(parser.value("input").toStdString(),
+                                content)) {
+      std::cerr << "Cache directory or input file is not accessible.\n";
+      return 1;
+    }
+    key = model::cache::DiskCache::key(content,
+                                       controller::describe(pipeline, roi));
+  }
+  const bool cached =
+      cache && cache->fetch(key, extension, output.toStdString());
+  if (!cached && !render(parser, output, roi)) return 1;
+  if (cache && !cached) cache->store(key, extension, output.toStdString());
+  if (parser.isSet("histogram") && !printHistogram(output)) return 1;
+  if (parser.isSet("metrics")) std::cout << model::metrics::report();
+  if (parser.isSet("trace") &&
+      !model::trace::writeChromeJson(parser.value("trace").toStdString())) {
+    std::cerr << "Unable to write trace.\n";
+    return 1;
+  }
+  return 0;
+}
+}  // namespace s21
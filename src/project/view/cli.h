@@ -0,0 +1,21 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QString>
+#include <iostream>
+#include <memory>
+
+#include "controller.hpp"
+#include "model.hpp"
+
+namespace s21 {
+namespace cli {
+bool isRequested(int argc, char *argv[]);
+int run(QCoreApplication &app);
+}  // namespace cli
+}  // namespace s21
+
+#endif  // CLI_H
@@ -0,0 +1,63 @@
+#include "histogramview.h"
+
+#include <algorithm>
+
+namespace s21 {
+/**
+ * @brief пустая гистограмма
+ *
+ * @param parent родитель
+ */
+HistogramView::HistogramView(QWidget *parent) : QWidget(parent) {
+  setMinimumSize(128, 64);
+}
+
+/**
+ * @brief показывает новую гистограмму
+ *
+ * @param histogram гистограмма
+ */
+void HistogramView::setHistogram(
+    const model::histogram::Histogram &histogram) {
+  current = histogram;
+  update();
+}
+
+QSize HistogramView::sizeHint() const { return QSize(256, 120); }
+
+/**
+ * @brief рисует гистограмму во всю ширину виджета
+ *
+ * @param event событие
+ */
+void HistogramView::paintEvent(QPaintEvent *event) {
+  Q_UNUSED(event);
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+  if (current.count == 0) return;
+  std::uint64_t top = 1;
+  for (auto const &bins : current.bins)
+    top = std::max(top, *std::max_element(bins.begin() + 1, bins.end() - 1));
+  const double sx = width() / 256.0;
+  const double sy = (height() - 1) / double(top);
+  auto curve = [&](const std::array<std::uint64_t, 256> &bins) {
+    QPainterPath path(QPointF(0, height()));
+    for (int v = 0; v < 256; ++v) {
+      const double y = height() - std::min(bins[v], top) * sy;
+      path.lineTo(v * sx, y);
+      path.lineTo((v + 1) * sx, y);
+    }
+    path.lineTo(width(), height());
+    return path;
+  };
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.fillPath(curve(current.bins[model::histogram::kLuma]),
+                   QColor(128, 128, 128, 96));
+  const QColor colors[3] = {QColor(220, 40, 40, 200), QColor(40, 180, 40, 200),
+                            QColor(40, 80, 220, 200)};
+  for (int c = RED; c <= BLUE; ++c) {
+    painter.setPen(colors[c]);
+    painter.drawPath(curve(current.bins[c]));
+  }
+}
+}  // namespace s21
@@ -0,0 +1,34 @@
+#ifndef HISTOGRAMVIEW_H
+#define HISTOGRAMVIEW_H
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QWidget>
+
+#include "channel.hpp"
+#include "histogram.hpp"
+
+namespace s21 {
+/**
+ * @brief Виджет гистограммы результата: яркость заливкой, каналы R, G, B
+ * линиями. Крайние корзины 0 и 255 не влияют на масштаб, чтобы обрезанные
+ * пиксели не сплющивали остальной график
+ */
+class HistogramView : public QWidget {
+  Q_OBJECT
+
+ public:
+  explicit HistogramView(QWidget *parent = nullptr);
+
+  void setHistogram(const model::histogram::Histogram &histogram);
+  QSize sizeHint() const override;
+
+ protected:
+  void paintEvent(QPaintEvent *event) override;
+
+ private:
+  model::histogram::Histogram current;
+};
+}  // namespace s21
+
+#endif  // HISTOGRAMVIEW_H
@@ -1,7 +1,12 @@
+#include "cli.h"
 #include "mainwindow.h"
 #include "model.hpp"
 
 int main(int argc, char *argv[]) {
+  if (s21::cli::isRequested(argc, argv)) {
+    QCoreApplication a(argc, argv);
+    return s21::cli::run(a);
+  }
   QApplication a(argc, argv);
   s21::MainWindow w;
   w.show();
@@ -1,8 +1,20 @@
 #include "mainwindow.h"
 
 #include "./ui_mainwindow.h"
+#include "bilateral.hpp"
+#include "gradient.hpp"
+#include "histogram.hpp"
+#include "median.hpp"
+#include "metrics.hpp"
+#include "pyramid.hpp"
+#include "trace.hpp"
 
 namespace s21 {
+namespace {
+// пауза после правки ядра до пересчета предпросмотра, мс
+constexpr int kPreviewDelay = 40;
+}  // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow) {
   ui->setupUi(this);
@@ -16,9 +28,36 @@ MainWindow::MainWindow(QWidget *parent)
           ui->graphicsViewLeft->verticalScrollBar(), SLOT(setValue(int)));
   connect(ui->graphicsViewLeft->verticalScrollBar(), SIGNAL(valueChanged(int)),
           ui->graphicsViewRight->verticalScrollBar(), SLOT(setValue(int)));
+  connect(ui->graphicsViewRight->horizontalScrollBar(),
+          &QScrollBar::valueChanged, this, &MainWindow::update_visible);
+  connect(ui->graphicsViewRight->verticalScrollBar(), &QScrollBar::valueChanged,
+          this, &MainWindow::update_visible);
+  ui->graphicsViewLeft->setScene(new QGraphicsScene(this));
+  ui->graphicsViewRight->setScene(new QGraphicsScene(this));
+  sourceItem = new TiledItem();
+  ui->graphicsViewLeft->scene()->addItem(sourceItem);
+  resultItem = new TiledItem();
+  ui->graphicsViewRight->scene()->addItem(resultItem);
+  previewItem = ui->graphicsViewRight->scene()->addPixmap(QPixmap());
+  previewItem->setZValue(1);
+  previewItem->setTransformationMode(Qt::SmoothTransformation);
+  previewItem->hide();
+  histogramView = new HistogramView(this);
+  auto dock = new QDockWidget(tr("Histogram"), this);
+  dock->setObjectName("histogramDock");
+  dock->setWidget(histogramView);
+  addDockWidget(Qt::RightDockWidgetArea, dock);
+  ui->menuFile->insertAction(ui->actionClose, dock->toggleViewAction());
 }
 
-MainWindow::~MainWindow() { delete ui; }
+MainWindow::~MainWindow() {
+  renderer.cancel();
+  renderer.wait();
+  previewRenderer.cancel();
+  previewRenderer.wait();
+  background.waitForDone();
+  delete ui;
+}
 
 /**
  * @brief триггер для действия Load
@@ -28,48 +67,280 @@ void MainWindow::on_actionLoad_triggered() {
   QString filename = QFileDialog::getOpenFileName(
       this, tr("Load Image"), QString(), tr("Images (*.bmp)"));
   if (filename.isEmpty()) return;
-  model::programData.filename = filename;
-  if (!controller::image_validation()) return;
-  QPixmap p(filename);
-  if (!ui->graphicsViewLeft->scene()) {
-    ui->graphicsViewLeft->setScene(new QGraphicsScene(this));
-  }
-  if (!ui->graphicsViewRight->scene()) {
-    ui->graphicsViewRight->setScene(new QGraphicsScene(this));
+  programData.filename = filename;
+  renderer.cancel();
+  generation = 0;
+  afterResult.clear();
+  if (!controller::image_validation(programData)) return;
+  const QImage image = programData.sourceImage.toImage();
+  ui->graphicsViewLeft->setSceneRect(image.rect());
+  ui->graphicsViewRight->setSceneRect(image.rect());
+  previewItem->hide();
+  sourceItem->setImage(image);
+  resultItem->setImage(image);
+  build_levels(sourceItem, programData.sourceImage);
+  build_levels(resultItem, programData.sourceImage);
+  update_histogram(programData.sourceImage);
+  ui->stackList->clear();
+}
+
+/**
+ * @brief добавляет фильтр в цепочку и показывает результат
+ *
+ * @param op операция
+ */
+void MainWindow::action_routine(model::pipeline::Operation &&op) {
+  if (!programData.isValidImage) {
+    QMessageBox::warning(this, tr("Error"), tr("Invalid image."));
+    return;
   }
-  ui->graphicsViewLeft->scene()->clear();
-  ui->graphicsViewRight->scene()->clear();
-  ui->graphicsViewLeft->setSceneRect(0, 0, p.width(), p.height());
-  ui->graphicsViewRight->setSceneRect(0, 0, p.width(), p.height());
-  ui->graphicsViewLeft->scene()->addPixmap(p);
-  ui->graphicsViewRight->scene()->addPixmap(p);
-  controller::tranferResultingImage(QImage(filename));
+  controller::chain::append(programData, std::move(op));
+  show_result(QString(), true);
 }
 
-void MainWindow::action_routine(const std::vector<float> &filter) {
-  QString reason;
-  bool status{true};
-  QPixmap qpm = controller::convolution(filter, reason, status);
+/**
+ * @brief запускает фоновую отрисовку цепочки и показывает список
+ * примененных фильтров. При уменьшенном показе первым приходит черновик
+ * видимой области на уровне пирамиды, затем плитки видимой области
+ * дорисовываются поверх прежнего результата по мере готовности
+ *
+ * @param reason причина ошибки
+ * @param status статус выполнения
+ */
+void MainWindow::show_result(const QString &reason, bool status) {
   if (!status) {
     QMessageBox::warning(this, tr("Error"), reason);
     return;
-  } else {
-    ui->graphicsViewRight->scene()->addPixmap(qpm);
   }
+  QString error;
+  generation = controller::chain::start(
+      programData, renderer, visible_rect(),
+      ui->graphicsViewRight->transform().m11(),
+      [this](const model::render::Tile &tile) {
+        QMetaObject::invokeMethod(
+            this, [this, tile]() { show_tile(tile); }, Qt::QueuedConnection);
+      },
+      [this](std::uint64_t done) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, done]() {
+              if (done == generation &&
+                  controller::chain::commit(programData, renderer, done)) {
+                build_levels(resultItem, programData.resultingImage);
+                update_histogram(programData.resultingImage);
+                if (!afterResult.empty()) {
+                  auto action = std::move(afterResult.front());
+                  afterResult.erase(afterResult.begin());
+                  action();
+                }
+              }
+            },
+            Qt::QueuedConnection);
+      },
+      error, status);
+  if (!status) {
+    QMessageBox::warning(this, tr("Error"), error);
+    return;
+  }
+  ui->stackList->clear();
+  ui->stackList->addItems(controller::chain::names(programData));
+}
+
+/**
+ * @brief видимая часть результата в координатах изображения (учитывает
+ * прокрутку и масштаб правого окна)
+ *
+ * @return QRect
+ */
+QRect MainWindow::visible_rect() const {
+  auto view = ui->graphicsViewRight;
+  return view->mapToScene(view->viewport()->rect())
+      .boundingRect()
+      .toAlignedRect();
+}
+
+/**
+ * @brief сообщает фоновой отрисовке новую видимую область, чтобы
+ * оставшиеся плитки считались начиная с нее. Во время настройки ползунками
+ * предпросмотр пересчитывается для новой области
+ *
+ */
+void MainWindow::update_visible() {
+  renderer.setVisible(visible_rect());
+  preview_adjustment();
+}
+
+/**
+ * @brief рисует готовую плитку в показанный результат (в потоке GUI).
+ * Черновик уменьшенного показа растягивается на свою область, плитки
+ * полного разрешения приходят после него. Плитки устаревших отрисовок
+ * отбрасываются
+ *
+ * @param tile плитка
+ */
+void MainWindow::show_tile(const model::render::Tile &tile) {
+  if (tile.generation != generation) return;
+  if (tile.level > 0)
+    resultItem->paintOver(QPixmap::fromImage(tile.pixels.toImage()),
+                          tile.rect);
+  else
+    resultItem->setTile(tile.rect.topLeft(), tile.pixels.toImage());
+}
+
+/**
+ * @brief сеанс предпросмотра: результат текущей цепочки, уменьшенный до
+ * размера правого окна (не дожидается фоновой отрисовки)
+ *
+ * @return ProgramData
+ */
+ProgramData MainWindow::preview_session() const {
+  return controller::proxy(programData,
+                           ui->graphicsViewRight->viewport()->size());
+}
+
+/**
+ * @brief показывает предпросмотр поверх результата, растянутым до размера
+ * изображения или его части
+ *
+ * @param qpm результат фильтра на прокси
+ * @param region часть изображения, которую покрывает прокси (пустая - все
+ * изображение)
+ */
+void MainWindow::show_preview(const QPixmap &qpm, const QRect &region) {
+  if (qpm.isNull() || resultItem->size().isEmpty()) return;
+  previewRegion =
+      region.isNull() ? QRect(QPoint(), resultItem->size()) : region;
+  previewItem->setPixmap(qpm);
+  previewItem->setPos(previewRegion.topLeft());
+  previewItem->setScale(double(previewRegion.width()) / qpm.width());
+  previewItem->show();
+}
+
+/**
+ * @brief убирает предпросмотр. Если фильтр принят, предпросмотр остается
+ * в результате до прихода плиток полного разрешения
+ *
+ * @param keep фильтр принят
+ */
+void MainWindow::hide_preview(bool keep) {
+  if (!previewItem->isVisible()) return;
+  previewItem->hide();
+  if (!keep) return;
+  resultItem->paintOver(previewItem->pixmap(), previewRegion);
+}
+
+/**
+ * @brief строит пирамиду изображения задачей фонового пула (уровни
+ * делятся между потоками) и передает ее элементу в потоке GUI. Окно
+ * построения не ждет: если содержимое элемента за это время изменилось,
+ * пирамида отбрасывается по номеру содержимого
+ *
+ * @param item элемент
+ * @param image изображение, показанное в элементе
+ */
+void MainWindow::build_levels(TiledItem *item,
+                              const model::ImageBuffer &image) {
+  const std::uint64_t revision = item->revision();
+  background.start([this, item, image, revision]() {
+    auto levels = model::pyramid::build(image);
+    std::vector<QImage> images;
+    for (std::size_t i = 1; i < levels.size(); ++i)
+      images.push_back(levels[i].toImage());
+    QMetaObject::invokeMethod(
+        this, [item, images, revision]() { item->setLevels(images, revision); },
+        Qt::QueuedConnection);
+  });
+}
+
+/**
+ * @brief считает гистограмму результата задачей фонового пула и
+ * показывает ее в потоке GUI. Окно предыдущий расчет не ждет: устаревший
+ * результат не считается, если еще не начат, и отбрасывается при показе
+ *
+ * @param image результат
+ */
+void MainWindow::update_histogram(const model::ImageBuffer &image) {
+  const std::uint64_t revision = ++histogramRevision;
+  background.start([this, image, revision]() {
+    if (revision != histogramRevision) return;
+    auto histogram = model::histogram::compute(image);
+    QMetaObject::invokeMethod(
+        this,
+        [this, histogram, revision]() {
+          if (revision == histogramRevision)
+            histogramView->setHistogram(histogram);
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+/**
+ * @brief выполняет действие над итогом текущей отрисовки, не блокируя
+ * окно: если итог уже готов - сразу, иначе после его принятия. Отложенные
+ * действия выполняются по одному на каждый принятый итог, так что каждое
+ * видит результат предыдущего
+ *
+ * @param action действие (в потоке GUI)
+ */
+void MainWindow::after_result(std::function<void()> action) {
+  if (afterResult.empty() &&
+      (!generation ||
+       controller::chain::commit(programData, renderer, generation))) {
+    action();
+    return;
+  }
+  afterResult.push_back(std::move(action));
 }
 
 /**
- * @brief триггер для действия Save
+ * @brief триггер для действия Save: полный результат сохраняется, когда
+ * фоновая отрисовка будет принята, окно ее не ждет
  *
  */
 void MainWindow::on_actionSave_triggered() {
   auto filename =
       QFileDialog::getSaveFileName(this, tr("Save Image"), "image.bmp");
-  if (!model::programData.isValidImage ||
-      !model::programData.resultingImage.save(filename)) {
-    QMessageBox::warning(this, tr("Error"), tr("Unable to save image."));
-    return;
-  }
+  if (filename.isEmpty()) return;
+  after_result([this, filename]() {
+    model::trace::Scope scope("save");
+    if (!programData.isValidImage ||
+        !programData.resultingImage.toImage().save(filename)) {
+      QMessageBox::warning(this, tr("Error"), tr("Unable to save image."));
+      return;
+    }
+  });
+}
+
+/**
+ * @brief триггер для действия Record Trace
+ *
+ * @param checked включена ли запись трассировки
+ */
+void MainWindow::on_actionRecord_Trace_toggled(bool checked) {
+  if (checked) model::trace::clear();
+  model::trace::enable(checked);
+}
+
+/**
+ * @brief триггер для действия Save Trace
+ *
+ */
+void MainWindow::on_actionSave_Trace_triggered() {
+  auto filename = QFileDialog::getSaveFileName(
+      this, tr("Save Trace"), "trace.json", tr("Chrome trace (*.json)"));
+  if (filename.isEmpty()) return;
+  if (!model::trace::writeChromeJson(filename.toStdString()))
+    QMessageBox::warning(this, tr("Error"), tr("Unable to save trace."));
+}
+
+/**
+ * @brief триггер для действия Stage Metrics: время этапов и счетчики
+ * (например, сколько полос свернуто в одноканальном режиме)
+ *
+ */
+void MainWindow::on_actionStage_Metrics_triggered() {
+  QMessageBox::information(this, tr("Stage Metrics"),
+                           QString::fromStdString(model::metrics::report()));
 }
 
 /**
@@ -78,12 +349,32 @@ void MainWindow::on_actionSave_triggered() {
  */
 void MainWindow::on_actionClose_triggered() { QApplication::exit(0); }
 
+/**
+ * @brief триггер для действия Undo: отменяет последнюю правку цепочки.
+ * Результат из истории показывается сразу, без пересчета
+ *
+ */
+void MainWindow::on_actionUndo_triggered() {
+  hide_preview(false);
+  if (controller::chain::undo(programData)) show_result(QString(), true);
+}
+
+/**
+ * @brief триггер для действия Redo: повторяет отмененную правку
+ *
+ */
+void MainWindow::on_actionRedo_triggered() {
+  hide_preview(false);
+  if (controller::chain::redo(programData)) show_result(QString(), true);
+}
+
 /**
  * @brief триггер для действия Emboss
  *
  */
 void MainWindow::on_actionEmboss_triggered() {
-  action_routine(model::filter::emboss);
+  action_routine(model::pipeline::Operation::convolution(
+      "Emboss", model::filter::emboss));
 }
 
 /**
@@ -91,7 +382,8 @@ void MainWindow::on_actionEmboss_triggered() {
  *
  */
 void MainWindow::on_actionSharpen_triggered() {
-  action_routine(model::filter::sharpen);
+  action_routine(model::pipeline::Operation::convolution(
+      "Sharpen", model::filter::sharpen));
 }
 
 /**
@@ -99,7 +391,8 @@ void MainWindow::on_actionSharpen_triggered() {
  *
  */
 void MainWindow::on_actionBox_Blur_triggered() {
-  action_routine(model::filter::boxBlur);
+  action_routine(model::pipeline::Operation::convolution(
+      "Box Blur", model::filter::boxBlur));
 }
 
 /**
@@ -107,7 +400,8 @@ void MainWindow::on_actionBox_Blur_triggered() {
  *
  */
 void MainWindow::on_actionGaussian_Blur_triggered() {
-  action_routine(model::filter::gaussianBlur);
+  action_routine(model::pipeline::Operation::convolution(
+      "Gaussian Blur", model::filter::gaussianBlur));
 }
 
 /**
@@ -115,47 +409,201 @@ void MainWindow::on_actionGaussian_Blur_triggered() {
  *
  */
 void MainWindow::on_actionLeplacian_Filter_triggered() {
-  action_routine(model::filter::leplacianFilter);
+  action_routine(model::pipeline::Operation::convolution(
+      "Leplacian Filter", model::filter::leplacianFilter));
 }
 
 /**
- * @brief триггер для действия Prewwit Filter
+ * @brief триггер для действия Prewwit Filter: модуль градиента Превитта
+ * (производные по x и y одним проходом)
  *
  */
 void MainWindow::on_actionPrewwit_Filter_triggered() {
-  action_routine(model::filter::sobelLeft);
+  action_routine(model::pipeline::gradient(model::gradient::PREWITT,
+                                           model::gradient::L2));
+}
+
+/**
+ * @brief триггер для действия Sobel Filter: модуль градиента Собеля
+ *
+ */
+void MainWindow::on_actionSobel_Filter_triggered() {
+  action_routine(model::pipeline::gradient(model::gradient::SOBEL,
+                                           model::gradient::L2));
+}
+
+/**
+ * @brief триггер для действия Edge Orientation: направление градиента
+ * Собеля цветом, его модуль - яркостью
+ *
+ */
+void MainWindow::on_actionEdge_Orientation_triggered() {
+  action_routine(model::pipeline::gradient(model::gradient::SOBEL,
+                                           model::gradient::L2, true));
+}
+
+/**
+ * @brief триггер для действия Median: медианный фильтр против импульсного
+ * шума, радиус окна выбирается в диалоге
+ *
+ */
+void MainWindow::on_actionMedian_triggered() {
+  bool ok{false};
+  const int radius =
+      QInputDialog::getInt(this, tr("Median"), tr("Window radius:"), 1, 1,
+                           model::median::kMaxRadius, 1, &ok);
+  if (ok) action_routine(model::pipeline::median(radius));
+}
+
+/**
+ * @brief морфологическая операция: радиусы прямоугольного элемента по
+ * горизонтали и вертикали выбираются в диалогах
+ *
+ * @param mode операция
+ * @param title заголовок диалогов
+ */
+void MainWindow::morphology_routine(model::morphology::Mode mode,
+                                    const QString &title) {
+  bool ok{false};
+  const int radiusX =
+      QInputDialog::getInt(this, title, tr("Horizontal radius:"), 1, 0,
+                           model::morphology::kMaxRadius, 1, &ok);
+  if (!ok) return;
+  const int radiusY =
+      QInputDialog::getInt(this, title, tr("Vertical radius:"), radiusX, 0,
+                           model::morphology::kMaxRadius, 1, &ok);
+  if (ok) action_routine(model::pipeline::morphology(mode, radiusX, radiusY));
+}
+
+/**
+ * @brief триггер для действия Erode: минимум по элементу (темное растет)
+ *
+ */
+void MainWindow::on_actionErode_triggered() {
+  morphology_routine(model::morphology::ERODE, tr("Erode"));
+}
+
+/**
+ * @brief триггер для действия Dilate: максимум по элементу (светлое растет)
+ *
+ */
+void MainWindow::on_actionDilate_triggered() {
+  morphology_routine(model::morphology::DILATE, tr("Dilate"));
+}
+
+/**
+ * @brief триггер для действия Open: убирает светлые детали меньше элемента
+ *
+ */
+void MainWindow::on_actionOpen_triggered() {
+  morphology_routine(model::morphology::OPEN, tr("Open"));
+}
+
+/**
+ * @brief триггер для действия Close: убирает темные детали меньше элемента
+ * (точки и пятна на странице документа)
+ *
+ */
+void MainWindow::on_actionClose_Morphology_triggered() {
+  morphology_routine(model::morphology::CLOSE, tr("Close"));
 }
 
 /**
- * @brief триггер для действия Custom Filter
+ * @brief триггер для действия Bilateral: сглаживание шума и кожи без
+ * размытия краев, сигмы выбираются в диалогах
+ *
+ */
+void MainWindow::on_actionBilateral_triggered() {
+  bool ok{false};
+  const double spatial = QInputDialog::getDouble(
+      this, tr("Bilateral"), tr("Spatial sigma, pixels:"), 8,
+      model::bilateral::kMinSpatial, model::bilateral::kMaxSpatial, 1, &ok);
+  if (!ok) return;
+  const double range = QInputDialog::getDouble(
+      this, tr("Bilateral"), tr("Range sigma, levels 0..255:"), 24,
+      model::bilateral::kMinRange, model::bilateral::kMaxRange, 1, &ok);
+  if (ok) action_routine(model::pipeline::bilateral(spatial, range));
+}
+
+/**
+ * @brief триггер для действия Custom Filter: ядро редактируется с живым
+ * предпросмотром. Каждая правка (после паузы kPreviewDelay) заново
+ * разбирает ядро и пересчитывает прокси в фоне, отменяя прежний расчет;
+ * если расчет не укладывается в кадр, прокси уменьшается
  *
  */
 void MainWindow::on_actionCustom_Filter_triggered() {
-  QPixmap qpixmap;
-  QString reason;
-  bool ok, status;
+  const QString hint =
+      tr("Enter NxN size comma separated array\n where 3 <= N <= 15\n\
+      Example: '-1,2,3,1,-2,3,1,2,-3'");
+  const QSize viewport = ui->graphicsViewRight->viewport()->size();
+  const ProgramData full = preview_session();
+  ProgramData preview = full;
+  QInputDialog dialog(this);
+  dialog.setWindowTitle(tr("Convolution matrix"));
+  dialog.setLabelText(hint);
+  dialog.setInputMode(QInputDialog::TextInput);
+  QTimer debounce;
+  debounce.setSingleShot(true);
+  debounce.setInterval(kPreviewDelay);
+  previewElapsed = 0;
+  auto render = [&]() {
+    const QSize bound = controller::previewBound(
+        viewport, preview.sourceImage.size(), previewElapsed,
+        controller::kFrameBudget);
+    const int width = preview.sourceImage.width();
+    if (std::abs(bound.width() - width) > width / 8 &&
+        (bound.width() < width || width < full.sourceImage.width()))
+      preview = controller::proxy(full, bound);
+    QString reason;
+    bool status{false};
+    const auto begin = std::chrono::steady_clock::now();
+    previewGeneration = controller::kernelPreview(
+        preview, previewRenderer, dialog.textValue(),
+        [this, begin](std::uint64_t done) {
+          const std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - begin;
+          QMetaObject::invokeMethod(
+              this,
+              [this, done, elapsed]() {
+                show_kernel_preview(done, elapsed.count());
+              },
+              Qt::QueuedConnection);
+        },
+        reason, status);
+    dialog.setLabelText(status ? hint : hint + "\n" + reason);
+  };
+  connect(&dialog, &QInputDialog::textValueChanged, &debounce,
+          qOverload<>(&QTimer::start));
+  connect(&debounce, &QTimer::timeout, this, render);
+  bool ok = dialog.exec() == QDialog::Accepted;
+  debounce.stop();
+  previewRenderer.cancel();
+  previewGeneration = 0;
 
-  QString text = QInputDialog::getText(
-      this, tr("Convolution matrix"),
-      tr("Enter NxN size comma separated integer array\n where N < 16\n\
-      Example: '-1,2,3,1,-2,3,1,2,-3'"),
-      QLineEdit::Normal, QString(""), &ok);
-  if (!ok) {
-    QMessageBox::warning(this, tr("Error"), tr("Parsing error."));
-    return;
-  } else if (text.isEmpty()) {
-    QMessageBox::warning(this, tr("Error"), tr("Empty input."));
-    return;
-  } else {
-    qpixmap = controller::convolution(text, reason, status);
-    if (!status) {
-      QMessageBox::warning(this, tr("Error"), reason);
-      return;
-    } else {
-      ui->graphicsViewRight->scene()->addPixmap(qpixmap);
-    }
+  QString reason;
+  std::vector<float> kernel;
+  if (ok && !controller::parseKernel(dialog.textValue(), kernel, reason)) {
+    QMessageBox::warning(this, tr("Error"), reason);
+    ok = false;
   }
-  ui->graphicsViewRight->scene()->addPixmap(qpixmap);
+  hide_preview(ok);
+  if (!ok) return;
+  action_routine(model::pipeline::Operation::convolution("Custom", kernel));
+}
+
+/**
+ * @brief показывает готовый предпросмотр ядра (в потоке GUI). Устаревшие
+ * расчеты отбрасываются
+ *
+ * @param done номер отрисовки предпросмотра
+ * @param elapsed время расчета в мс
+ */
+void MainWindow::show_kernel_preview(std::uint64_t done, double elapsed) {
+  if (done != previewGeneration) return;
+  previewElapsed = elapsed;
+  const model::ImageBuffer result = previewRenderer.result();
+  if (!result.isNull()) show_preview(QPixmap::fromImage(result.toImage()));
 }
 
 /**
@@ -163,16 +611,7 @@ void MainWindow::on_actionCustom_Filter_triggered() {
  *
  */
 void MainWindow::on_actionNegative_triggered() {
-  QString reason;
-  bool status{true};
-  QPixmap qpm = controller::simple<3>(
-      std::tuple<void (&)(QImage & img), QString &, bool &>{
-          model::simple::negative, reason, status});
-  if (!status) {
-    QMessageBox::warning(this, tr("Error"), reason);
-    return;
-  }
-  ui->graphicsViewRight->scene()->addPixmap(qpm);
+  action_routine(model::pipeline::negative());
 }
 
 /**
@@ -180,24 +619,30 @@ void MainWindow::on_actionNegative_triggered() {
  *
  */
 void MainWindow::on_actionGrayscale_triggered() {
-  QString reason;
-  bool status{true}, ok{false};
-  char type_short;
   const QStringList opts{"Average", "Luma", "Dissat"};
-  auto type = QInputDialog::getItem(this, "Grayscale", "Grayscale test", opts,
-                                    0, false, &ok);
+  ProgramData preview = preview_session();
+  QInputDialog dialog(this);
+  dialog.setWindowTitle("Grayscale");
+  dialog.setLabelText("Grayscale test");
+  dialog.setComboBoxItems(opts);
+  dialog.setComboBoxEditable(false);
+  auto show_type = [this, &preview](const QString &type) {
+    QString reason;
+    bool status{false};
+    char mode = type[0].toLower().toLatin1();
+    show_preview(controller::simple<4>(
+        preview, std::forward_as_tuple(model::simple::grayscale, mode, reason,
+                                       status)));
+  };
+  connect(&dialog, &QInputDialog::textValueChanged, this, show_type);
+  show_type(opts[0]);
+  bool ok = dialog.exec() == QDialog::Accepted;
+  hide_preview(ok);
   if (!ok) {
     return;
   }
-  type_short = type[0].toLower().toLatin1();
-  QPixmap qpm = controller::simple<4>(
-      std::tuple<void (&)(QImage &, char), char &, QString &, bool &>{
-          model::simple::grayscale, type_short, reason, status});
-  if (!status) {
-    QMessageBox::warning(this, tr("Error"), reason);
-    return;
-  }
-  ui->graphicsViewRight->scene()->addPixmap(qpm);
+  auto type = dialog.textValue();
+  action_routine(model::pipeline::grayscale(type[0].toLower().toLatin1()));
 }
 
 /**
@@ -205,19 +650,136 @@ void MainWindow::on_actionGrayscale_triggered() {
  *
  */
 void MainWindow::on_actionToning_triggered() {
+  ProgramData preview = preview_session();
+  QColorDialog dialog(this);
+  connect(&dialog, &QColorDialog::currentColorChanged, this,
+          [this, &preview](const QColor &tone) {
+            QString reason;
+            bool status{false};
+            show_preview(controller::simple<4>(
+                preview, std::forward_as_tuple(model::simple::toning, tone,
+                                               reason, status)));
+          });
+  bool ok = dialog.exec() == QDialog::Accepted;
+  QColor tone = dialog.selectedColor();
+  hide_preview(ok && tone.isValid());
+  if (!ok || !tone.isValid()) return;
+  action_routine(model::pipeline::toning(tone));
+}
+
+/**
+ * @brief триггер для действия Sepia
+ *
+ */
+void MainWindow::on_actionSepia_triggered() {
+  action_routine(model::pipeline::sepia());
+}
+
+/**
+ * @brief триггер для действия Color Matrix
+ *
+ */
+void MainWindow::on_actionColor_Matrix_triggered() {
   QString reason;
-  bool status{true};
-  QColor tone = QColorDialog::getColor();
-  if (!tone.isValid()) return;
-  QPixmap qpm = controller::simple<4>(
-      std::tuple<void (&)(QImage &, QColor), QColor &, QString &, bool &>{
-          model::simple::toning, tone, reason, status});
-  if (!status) {
+  bool ok;
+  model::pointop::Matrix matrix;
+
+  QString text = QInputDialog::getText(
+      this, tr("Color matrix"),
+      tr("Enter 3x3 or 3x4 comma separated matrix by rows R, G, B\n\
+      (4th column is an offset in 0..255)\n\
+      Example: '0.393,0.769,0.189,0.349,0.686,0.168,0.272,0.534,0.131'"),
+      QLineEdit::Normal, QString(""), &ok);
+  if (!ok || text.isEmpty()) return;
+  if (!controller::parseMatrix(text, matrix, reason)) {
     QMessageBox::warning(this, tr("Error"), reason);
     return;
-  } else {
-    ui->graphicsViewRight->scene()->addPixmap(qpm);
   }
+  action_routine(model::pipeline::colorMatrix(matrix));
+}
+
+/**
+ * @brief триггер для действия Adjust: ползунки яркости, контраста, гаммы,
+ * весов оттенков серого и силы тонирования. Каждое движение ползунка
+ * пересобирает таблицу и применяет ее только к видимой части результата
+ * размером с экран; принятые настройки добавляются в цепочку одной
+ * операцией. Окно открывается сразу: прокси строится из исходного
+ * изображения текущей цепочкой, не дожидаясь фоновой отрисовки
+ *
+ */
+void MainWindow::on_actionAdjust_triggered() {
+  if (!programData.isValidImage) {
+    QMessageBox::warning(this, tr("Error"), tr("Invalid image."));
+    return;
+  }
+  AdjustDialog dialog(this);
+  adjusting = &dialog;
+  adjustRegion = QRect();
+  connect(&dialog, &AdjustDialog::changed, this,
+          &MainWindow::preview_adjustment);
+  preview_adjustment();
+  const bool ok = dialog.exec() == QDialog::Accepted;
+  adjusting = nullptr;
+  adjustBase = ProgramData();
+  hide_preview(ok);
+  if (!ok) {
+    update_histogram(programData.resultingImage);
+    return;
+  }
+  action_routine(model::pipeline::adjustment(dialog.adjustment()));
+}
+
+/**
+ * @brief предпросмотр настроек с ползунками на видимой части результата.
+ * Прокси видимой части строится заново только при прокрутке или смене
+ * масштаба
+ *
+ */
+void MainWindow::preview_adjustment() {
+  if (!adjusting) return;
+  const QRect region =
+      visible_rect().intersected(QRect(QPoint(), resultItem->size()));
+  if (region.isEmpty()) return;
+  if (region != adjustRegion) {
+    adjustRegion = region;
+    adjustBase = controller::proxy(
+        programData, ui->graphicsViewRight->viewport()->size(), region);
+  }
+  QString reason;
+  bool status{false};
+  model::histogram::Histogram histogram;
+  QPixmap qpm = controller::adjust(adjustBase, adjusting->adjustment(),
+                                   reason, status, &histogram);
+  if (!status) return;
+  show_preview(qpm, adjustRegion);
+  ++histogramRevision;
+  histogramView->setHistogram(histogram);
+}
+
+/**
+ * @brief триггер для действия Equalize: таблица строится по гистограмме
+ * текущего результата и добавляется в цепочку. Если результат еще
+ * считается, фильтр добавляется после его готовности, окно не ждет
+ *
+ */
+void MainWindow::on_actionEqualize_triggered() {
+  after_result([this]() {
+    action_routine(
+        model::pipeline::equalization(controller::histogram(programData)));
+  });
+}
+
+/**
+ * @brief триггер для действия Auto Levels: каналы текущего результата
+ * растягиваются на весь диапазон (0.5% пикселей с каждой стороны
+ * отсекается). Как и Equalize, не ждет фоновой отрисовки
+ *
+ */
+void MainWindow::on_actionAuto_Levels_triggered() {
+  after_result([this]() {
+    action_routine(
+        model::pipeline::autoLevels(controller::histogram(programData)));
+  });
 }
 
 /**
@@ -285,4 +847,22 @@ void MainWindow::on_filterSharpenButton_clicked() {
  *
  */
 void MainWindow::on_saveButton_clicked() { on_actionSave_triggered(); }
+
+/**
+ * @brief триггер для кнопки Remove Last: убирает последний фильтр цепочки
+ *
+ */
+void MainWindow::on_undoButton_clicked() {
+  controller::chain::drop(programData);
+  show_result(QString(), true);
+}
+
+/**
+ * @brief триггер для кнопки Clear: сбрасывает цепочку к исходному изображению
+ *
+ */
+void MainWindow::on_clearButton_clicked() {
+  controller::chain::clear(programData);
+  show_result(QString(), true);
+}
 }  // namespace s21
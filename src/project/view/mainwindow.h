@@ -2,7 +2,9 @@
 #define MAINWINDOW_H
 
 #include <QApplication>
+#include <QDockWidget>
 #include <QFileDialog>
+#include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
 #include <QImage>
 #include <QInputDialog>
@@ -10,10 +12,21 @@
 #include <QMessageBox>
 #include <QScrollBar>
 #include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <vector>
 
+#include "adjustdialog.h"
 #include "controller.hpp"
+#include "histogramview.h"
 #include "model.hpp"
+#include "morphology.hpp"
+#include "render.hpp"
+#include "tileditem.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -33,23 +46,71 @@ class MainWindow : public QMainWindow {
  private:
   Ui::MainWindow *ui;
   QImage image;
+  ProgramData programData;
+  model::render::Renderer renderer;
+  TiledItem *sourceItem{nullptr};
+  TiledItem *resultItem{nullptr};
+  QGraphicsPixmapItem *previewItem{nullptr};
+  std::uint64_t generation{0};
+  model::render::Renderer previewRenderer;
+  std::uint64_t previewGeneration{0};
+  double previewElapsed{0};
+  QRect previewRegion;
+  AdjustDialog *adjusting{nullptr};
+  ProgramData adjustBase;
+  QRect adjustRegion;
+  HistogramView *histogramView{nullptr};
+  std::atomic<std::uint64_t> histogramRevision{0};
+  std::vector<std::function<void()>> afterResult;
+  QThreadPool background;
 
-  void action_routine(const std::vector<float> &filter);
+  void action_routine(model::pipeline::Operation &&op);
+  void morphology_routine(model::morphology::Mode mode, const QString &title);
+  void show_result(const QString &reason, bool status);
+  QRect visible_rect() const;
+  void update_visible();
+  void show_tile(const model::render::Tile &tile);
+  ProgramData preview_session() const;
+  void show_preview(const QPixmap &qpm, const QRect &region = QRect());
+  void hide_preview(bool keep);
+  void show_kernel_preview(std::uint64_t done, double elapsed);
+  void preview_adjustment();
+  void build_levels(TiledItem *item, const model::ImageBuffer &image);
+  void update_histogram(const model::ImageBuffer &image);
+  void after_result(std::function<void()> action);
 
  private slots:
   void on_actionLoad_triggered();
   void on_actionSave_triggered();
   void on_actionClose_triggered();
+  void on_actionUndo_triggered();
+  void on_actionRedo_triggered();
+  void on_actionRecord_Trace_toggled(bool checked);
+  void on_actionSave_Trace_triggered();
+  void on_actionStage_Metrics_triggered();
   void on_actionEmboss_triggered();
   void on_actionSharpen_triggered();
   void on_actionGaussian_Blur_triggered();
   void on_actionBox_Blur_triggered();
   void on_actionLeplacian_Filter_triggered();
   void on_actionPrewwit_Filter_triggered();
+  void on_actionSobel_Filter_triggered();
+  void on_actionEdge_Orientation_triggered();
   void on_actionCustom_Filter_triggered();
+  void on_actionMedian_triggered();
+  void on_actionBilateral_triggered();
+  void on_actionErode_triggered();
+  void on_actionDilate_triggered();
+  void on_actionOpen_triggered();
+  void on_actionClose_Morphology_triggered();
   void on_actionNegative_triggered();
   void on_actionGrayscale_triggered();
   void on_actionToning_triggered();
+  void on_actionSepia_triggered();
+  void on_actionColor_Matrix_triggered();
+  void on_actionAdjust_triggered();
+  void on_actionEqualize_triggered();
+  void on_actionAuto_Levels_triggered();
   void on_loadButton_clicked();
   void on_saveButton_clicked();
   void on_filterBoxBlurButton_clicked();
@@ -59,6 +120,8 @@ class MainWindow : public QMainWindow {
   void on_filterLeplicalButton_clicked();
   void on_filterPrewwitButton_clicked();
   void on_filterSharpenButton_clicked();
+  void on_undoButton_clicked();
+  void on_clearButton_clicked();
 };
 }  // namespace s21
 
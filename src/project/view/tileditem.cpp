@@ -0,0 +1,177 @@
+#include "tileditem.h"
+
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+
+#include "pyramid.hpp"
+
+namespace s21 {
+/**
+ * @brief пустой элемент
+ *
+ * @param tileSize сторона плитки
+ * @param parent родитель
+ */
+TiledItem::TiledItem(int tileSize, QGraphicsItem *parent)
+    : QGraphicsItem(parent), tileSize(std::max(16, tileSize)) {
+  setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+/**
+ * @brief показывает изображение целиком. Плитки создаются заново только
+ * при смене размера
+ *
+ * @param image изображение
+ */
+void TiledItem::setImage(const QImage &image) {
+  resize(image.size());
+  setTile(QPoint(0, 0), image);
+}
+
+/**
+ * @brief перерисовывает часть изображения в плитках, которые она задевает
+ *
+ * @param pos левый верхний угол части в координатах изображения
+ * @param image часть изображения
+ */
+void TiledItem::setTile(const QPoint &pos, const QImage &image) {
+  const QRect rect =
+      QRect(pos, image.size()).intersected(QRect(QPoint(), extent));
+  if (rect.isEmpty()) return;
+  ++changes;
+  levels.clear();
+  for (std::size_t i = 0; i < tiles.size(); ++i) {
+    const QRect target = tileRect(int(i));
+    const QRect part = target.intersected(rect);
+    if (part.isEmpty()) continue;
+    QPainter painter(&tiles[i]);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(part.topLeft() - target.topLeft(), image,
+                      part.translated(-pos));
+  }
+  update(rect);
+}
+
+/**
+ * @brief растягивает пиксмап (например, предпросмотр) на все изображение
+ * или на его часть
+ *
+ * @param pixmap пиксмап
+ * @param target часть изображения (пустая - все изображение)
+ */
+void TiledItem::paintOver(const QPixmap &pixmap, const QRect &target) {
+  const QRect area = target.isNull() ? QRect(QPoint(), extent) : target;
+  if (pixmap.isNull() || tiles.empty() || area.isEmpty()) return;
+  ++changes;
+  levels.clear();
+  const double sx = double(pixmap.width()) / area.width();
+  const double sy = double(pixmap.height()) / area.height();
+  for (std::size_t i = 0; i < tiles.size(); ++i) {
+    const QRect rect = tileRect(int(i));
+    const QRect part = rect.intersected(area);
+    if (part.isEmpty()) continue;
+    QPainter painter(&tiles[i]);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(QRectF(part.translated(-rect.topLeft())), pixmap,
+                       QRectF((part.x() - area.x()) * sx,
+                              (part.y() - area.y()) * sy, part.width() * sx,
+                              part.height() * sy));
+  }
+  update(area);
+}
+
+/**
+ * @brief уровни пирамиды для уменьшенного показа (начиная с первого,
+ * вдвое меньшего изображения). Уровни, построенные для устаревшего
+ * содержимого, отбрасываются
+ *
+ * @param images уровни
+ * @param revision номер содержимого, по которому они построены
+ */
+void TiledItem::setLevels(const std::vector<QImage> &images,
+                          std::uint64_t revision) {
+  if (revision != changes) return;
+  levels.clear();
+  for (auto const &image : images)
+    levels.push_back(QPixmap::fromImage(image));
+  update();
+}
+
+/**
+ * @brief номер содержимого: меняется при каждой перерисовке плиток
+ *
+ * @return std::uint64_t
+ */
+std::uint64_t TiledItem::revision() const { return changes; }
+
+/**
+ * @brief размер показанного изображения
+ *
+ * @return QSize
+ */
+QSize TiledItem::size() const { return extent; }
+
+QRectF TiledItem::boundingRect() const {
+  return QRectF(QPointF(), QSizeF(extent));
+}
+
+/**
+ * @brief рисует только плитки, попадающие в перерисовываемую область. При
+ * уменьшении - уровень пирамиды, выбранный model::pyramid::levelFor
+ * (самый маленький, который еще не меньше экранного размера), чтобы Qt не
+ * уменьшал полное изображение на каждой перерисовке
+ */
+void TiledItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                      QWidget *) {
+  const QRect exposed = option->exposedRect.toAlignedRect();
+  const double scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+      painter->worldTransform());
+  std::vector<int> widths{extent.width()};
+  for (auto const &level : levels) widths.push_back(level.width());
+  const int index = model::pyramid::levelFor(scale, widths);
+  if (index > 0) {
+    const QPixmap *level = &levels[index - 1];
+    const double ratio = double(level->width()) / extent.width();
+    const QRectF source(exposed.x() * ratio, exposed.y() * ratio,
+                        exposed.width() * ratio, exposed.height() * ratio);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawPixmap(QRectF(exposed), *level, source);
+    return;
+  }
+  for (std::size_t i = 0; i < tiles.size(); ++i) {
+    const QRect target = tileRect(int(i));
+    if (target.intersects(exposed))
+      painter->drawPixmap(target.topLeft(), tiles[i]);
+  }
+}
+
+/**
+ * @brief создает набор плиток под размер изображения
+ *
+ * @param size размер изображения
+ */
+void TiledItem::resize(const QSize &size) {
+  if (size == extent) return;
+  prepareGeometryChange();
+  extent = size;
+  levels.clear();
+  columns = (size.width() + tileSize - 1) / tileSize;
+  const int rows = (size.height() + tileSize - 1) / tileSize;
+  tiles.clear();
+  for (int i = 0; i < columns * rows; ++i)
+    tiles.emplace_back(tileRect(i).size());
+}
+
+/**
+ * @brief область плитки в координатах изображения (крайние плитки
+ * обрезаны по его границе)
+ *
+ * @param index номер плитки по строкам
+ * @return QRect
+ */
+QRect TiledItem::tileRect(int index) const {
+  const int x = index % columns * tileSize, y = index / columns * tileSize;
+  return QRect(x, y, std::min(tileSize, extent.width() - x),
+               std::min(tileSize, extent.height() - y));
+}
+}  // namespace s21
@@ -0,0 +1,48 @@
+#ifndef TILEDITEM_H
+#define TILEDITEM_H
+
+#include <QGraphicsItem>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <cstdint>
+#include <vector>
+
+namespace s21 {
+/**
+ * @brief Элемент сцены, показывающий изображение сеткой плиток. Плитки -
+ * постоянный набор пиксмапов (текстур), созданный один раз под размер
+ * изображения: новые результаты перерисовываются в них по мере готовности,
+ * без создания полноразмерного QPixmap на каждый запуск. При уменьшении
+ * рисуется подходящий уровень пирамиды (mip), если он построен для
+ * текущего содержимого
+ */
+class TiledItem : public QGraphicsItem {
+ public:
+  explicit TiledItem(int tileSize = 256, QGraphicsItem *parent = nullptr);
+
+  void setImage(const QImage &image);
+  void setTile(const QPoint &pos, const QImage &image);
+  void paintOver(const QPixmap &pixmap, const QRect &target = QRect());
+  void setLevels(const std::vector<QImage> &images, std::uint64_t revision);
+  std::uint64_t revision() const;
+  QSize size() const;
+
+  QRectF boundingRect() const override;
+  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+             QWidget *widget = nullptr) override;
+
+ private:
+  void resize(const QSize &size);
+  QRect tileRect(int index) const;
+
+  int tileSize;
+  int columns{0};
+  QSize extent{0, 0};
+  std::vector<QPixmap> tiles;
+  std::vector<QPixmap> levels;
+  std::uint64_t changes{0};
+};
+}  // namespace s21
+
+#endif  // TILEDITEM_H
@@ -0,0 +1,220 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../controller/controller.hpp"
+#include "../model/bilateral.hpp"
+#include "../model/cache.hpp"
+#include "../model/diskcache.hpp"
+#include "../model/gradient.hpp"
+#include "../model/hash.hpp"
+#include "../model/histogram.hpp"
+#include "../model/history.hpp"
+#include "../model/model.hpp"
+#include "../model/morphology.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/pointop.hpp"
+#include "../model/window.hpp"
+
+namespace {
+// Наименьшее время из нескольких повторов, в секундах
+double measure(const std::function<void()> &body, int repeats = 5) {
+  double best = 1e30;
+  for (int i = 0; i < repeats; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    std::chrono::duration<double> took =
+        std::chrono::steady_clock::now() - start;
+    if (took.count() < best) best = took.count();
+  }
+  return best;
+}
+
+void report(const char *name, double seconds, double bytes) {
+  std::printf("%-28s %10.3f ms %10.2f GB/s\n", name, seconds * 1e3,
+              bytes / seconds / 1e9);
+}
+}  // namespace
+
+// Замеры, не входящие в тесты: пропускная способность хеширования для
+// ключей кешей против времени самой обработки
+int main() {
+  const int side = 2048;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> dist(0, 255);
+  QImage img(side, side, QImage::Format_RGB32);
+  for (int y = 0; y < side; ++y)
+    for (int x = 0; x < side; ++x)
+      img.setPixel(x, y, qRgb(dist(gen), dist(gen), dist(gen)));
+  auto source = model::ImageBuffer::fromImage(img);
+  const double bytes = double(side) * side * 4;
+
+  std::uint64_t sink = 0;
+  const double raw = measure([&] {
+    sink ^= model::hash::bytes(source.constBits(), std::size_t(bytes));
+  });
+  report("hash::bytes", raw, bytes);
+  const double image = measure([&] { sink ^= model::hash::image(source); });
+  report("hash::image", image, bytes);
+  const double histogram = measure([&] {
+    sink ^= model::histogram::compute(source).bins[RED][7];
+  });
+  report("histogram::compute", histogram, bytes);
+  std::vector<std::uint16_t> samples(std::size_t(side) * side * 2);
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    samples[i] = std::uint16_t(source.constBits()[i] * 257 + i % 7);
+  const double wide = measure([&] {
+    sink ^= model::histogram::compute16(samples.data(), samples.size())[7];
+  });
+  report("histogram::compute16", wide, bytes);
+
+  const std::string file = "benchmark_hash.bin";
+  {
+    std::ofstream out(file, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(source.constBits()),
+              std::streamsize(bytes));
+  }
+  const double disk = measure([&] {
+    std::uint64_t digest = 0;
+    model::cache::hashFile(file, digest);
+    sink ^= digest;
+  });
+  report("cache::hashFile", disk, bytes);
+  std::remove(file.c_str());
+
+  model::pipeline::Pipeline pipeline;
+  QString reason;
+  controller::makePipeline({"gaussian-blur"}, pipeline, reason);
+  const double blur = measure([&] { pipeline.run(source); }, 3);
+  report("gaussian-blur", blur, bytes);
+  // медиана: время почти не зависит от радиуса
+  for (int radius : {1, 5, 15}) {
+    model::pipeline::Pipeline median;
+    median.push(model::pipeline::median(radius));
+    const double took = measure([&] { median.run(source); }, 2);
+    const std::string name = "median r=" + std::to_string(radius);
+    report(name.c_str(), took, bytes);
+  }
+  // градиент: одна свертка против модуля из двух производных за проход
+  {
+    model::pipeline::Pipeline single, fused;
+    controller::makePipeline({"prewitt"}, single, reason);
+    fused.push(model::pipeline::gradient(model::gradient::SOBEL,
+                                         model::gradient::L2));
+    report("prewitt convolution", measure([&] { single.run(source); }, 3),
+           bytes);
+    report("sobel gradient L2", measure([&] { fused.run(source); }, 3),
+           bytes);
+    const int width = 1920, height = 1080;
+    std::vector<std::uint8_t> frame(width * height), magnitude(frame.size());
+    for (auto &v : frame) v = std::uint8_t(dist(gen));
+    for (auto norm : {model::gradient::L1, model::gradient::L2}) {
+      const double took = measure([&] {
+        model::gradient::plane(frame.data(), width, height,
+                               model::gradient::SOBEL, norm, 0, height,
+                               magnitude.data());
+      });
+      const std::string name =
+          std::string("gradient frame ") +
+          (norm == model::gradient::L1 ? "L1 " : "L2 ") +
+          model::gradient::kernelName();
+      report(name.c_str(), took, frame.size());
+    }
+  }
+  // морфология: время не зависит от размера элемента
+  for (int radius : {1, 10, 50}) {
+    model::pipeline::Pipeline erode;
+    erode.push(
+        model::pipeline::morphology(model::morphology::ERODE, radius, radius));
+    const double took = measure([&] { erode.run(source); }, 3);
+    const std::string name = std::string("erode r=") + std::to_string(radius) +
+                             " " + model::morphology::kernelName();
+    report(name.c_str(), took, bytes);
+  }
+  // билатеральный фильтр: сетка почти не зависит от пространственной
+  // сигмы, перебор окна растет с ее квадратом (перебор - на квадрате 256)
+  for (float spatial : {4.0f, 16.0f, 64.0f}) {
+    model::pipeline::Pipeline bilateral;
+    bilateral.push(model::pipeline::bilateral(spatial, 24));
+    const double took = measure([&] { bilateral.run(source); }, 2);
+    const std::string name =
+        "bilateral grid s=" + std::to_string(int(spatial));
+    report(name.c_str(), took, bytes);
+  }
+  {
+    const int crop = 256;
+    const model::ImageBuffer part =
+        source.view(QRect(0, 0, crop, crop)).convertTo(
+            model::ImageBuffer::RGB32);
+    std::vector<QRgb> out(crop * crop);
+    const model::window::Strip strip{
+        0, crop, crop, reinterpret_cast<const QRgb *>(part.constBits())};
+    for (float spatial : {4.0f, 16.0f}) {
+      const std::string suffix = " s=" + std::to_string(int(spatial));
+      auto grid = model::bilateral::filter(spatial, 24);
+      auto exact = model::bilateral::reference(spatial, 24);
+      const double fast =
+          measure([&] { grid(strip, 0, crop, out.data()); }, 2);
+      const double slow =
+          measure([&] { exact(strip, 0, crop, out.data()); }, 1);
+      report(("bilateral 256 grid" + suffix).c_str(), fast, crop * crop * 4.0);
+      report(("bilateral 256 exact" + suffix).c_str(), slow,
+             crop * crop * 4.0);
+    }
+  }
+  std::printf("image hash is %.1f%% of one blur (%llx)\n",
+              image / blur * 100, static_cast<unsigned long long>(sink));
+
+  // история: снимок после фильтра, затем правка четверти изображения
+  model::ImageBuffer blurred = pipeline.run(source);
+  model::ImageBuffer edited = blurred.view(blurred.rect()).convertTo(
+      model::ImageBuffer::RGB32);
+  for (int y = 0; y < side / 2; ++y)
+    for (int x = 0; x < side / 2 * 4; ++x) edited.line(y)[x] ^= 0x55;
+  model::pipeline::Pipeline second = pipeline;
+  second.push(model::pipeline::negative());
+  std::size_t first = 0, step = 0;
+  const double encode = measure([&] {
+    model::history::History history;
+    history.record(pipeline);
+    history.attach(pipeline, blurred);
+    first = history.bytes();
+    history.record(second);
+    history.attach(second, edited);
+    step = history.bytes() - first;
+  });
+  report("history snapshot x2", encode, bytes * 2);
+  model::history::History history;
+  history.record(pipeline);
+  history.attach(pipeline, blurred);
+  history.record(second);
+  history.attach(second, edited);
+  model::pipeline::Pipeline restored;
+  model::ImageBuffer result;
+  const double undo = measure([&] {
+    history.undo(restored, result);
+    history.redo(restored, result);
+  });
+  report("history undo+redo", undo, bytes * 2);
+  std::printf("snapshot %.1f MB, quarter edit %.1f MB of %.1f MB\n",
+              first / 1e6, step / 1e6, bytes / 1e6);
+
+  // ползунки: сборка таблицы и проход по прокси размером с экран
+  const model::ImageBuffer screen =
+      source.view(QRect(0, 0, 1920, 1080)).convertTo(
+          model::ImageBuffer::RGB32);
+  model::pointop::Adjustment settings;
+  settings.weights[0] = settings.weights[1] = settings.weights[2] = 1;
+  settings.toning = 0.3f;
+  settings.gamma = 1.2f;
+  const double tick = measure([&] {
+    settings.brightness += 1;
+    model::pointop::apply(model::pointop::adjustment(settings), screen);
+  });
+  report("adjust tick 1920x1080", tick, 1920.0 * 1080 * 4);
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/bilateral.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/window.hpp"
+
+class bilateralFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // плавный фон, ступенька и шум
+    std::mt19937 gen(48);
+    std::normal_distribution<float> noise(0, 8);
+    img = QImage(96, 80, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x) {
+        const float base = (x < 48 ? 60 : 190) + y / 4.0f;
+        auto value = [&](float shift) {
+          return std::clamp(int(base + shift + noise(gen)), 0, 255);
+        };
+        img.setPixel(x, y, qRgb(value(10), value(0), value(-20)));
+      }
+  }
+
+  // Фильтр над изображением целиком одной полосой
+  static QImage apply(const model::window::Filter &filter,
+                      const QImage &image) {
+    const QImage source = image.convertToFormat(QImage::Format_RGB32);
+    std::vector<QRgb> px(image.width() * image.height());
+    for (int y = 0; y < image.height(); ++y)
+      for (int x = 0; x < image.width(); ++x)
+        px[y * image.width() + x] = source.pixel(x, y);
+    std::vector<QRgb> out(px.size());
+    const model::window::Strip strip{0, image.height(), image.width(),
+                                     px.data()};
+    filter(strip, 0, image.height(), out.data());
+    QImage res(image.width(), image.height(), QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y)
+      for (int x = 0; x < image.width(); ++x)
+        res.setPixel(x, y, out[y * image.width() + x]);
+    return res;
+  }
+
+  // Среднеквадратичное отклонение зеленого канала в прямоугольнике
+  static double spread(const QImage &image, const QRect &rect) {
+    double sum = 0, squares = 0;
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+      for (int x = rect.left(); x <= rect.right(); ++x) {
+        const double v = qGreen(image.pixel(x, y));
+        sum += v;
+        squares += v * v;
+      }
+    const double n = double(rect.width()) * rect.height();
+    return std::sqrt(squares / n - sum * sum / n / n);
+  }
+
+  QImage img;
+};
+
+// Сетка близка к точному фильтру перебором окна
+TEST_F(bilateralFixture, gridApproximatesReference) {
+  for (float spatial : {3.0f, 6.0f}) {
+    const QImage grid = apply(model::bilateral::filter(spatial, 20), img);
+    const QImage exact = apply(model::bilateral::reference(spatial, 20), img);
+    double total = 0;
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        total += std::abs(qGreen(grid.pixel(x, y)) - qGreen(exact.pixel(x, y)));
+    EXPECT_LT(total / (img.width() * img.height()), 2.0) << spatial;
+  }
+}
+
+// Шум по обе стороны ступеньки сглаживается, а сама ступенька - нет
+TEST_F(bilateralFixture, smoothsWithoutBlurringEdges) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::bilateral(4, 24));
+  const QImage result = chain.run(img);
+  const QRect dark(8, 36, 32, 8), light(56, 36, 32, 8);
+  EXPECT_LT(spread(result, dark), spread(img, dark) / 2);
+  EXPECT_LT(spread(result, light), spread(img, light) / 2);
+  for (int y = 0; y < img.height(); ++y) {
+    EXPECT_LT(qGreen(result.pixel(46, y)), 100);
+    EXPECT_GT(qGreen(result.pixel(49, y)), 160);
+  }
+}
+
+// Операция цепочки применяет ту же сетку, что и фильтр напрямую
+TEST_F(bilateralFixture, pipelineUsesGrid) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::bilateral(3, 16));
+  EXPECT_TRUE(chain.run(img) == apply(model::bilateral::filter(3, 16), img));
+}
+
+// Обе сигмы из командной строки входят в хеш и задают радиус окна
+TEST_F(bilateralFixture, makeOperation) {
+  model::pipeline::Operation op;
+  QString reason;
+  ASSERT_TRUE(controller::makeOperation("bilateral", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::bilateral(8, 24).digest());
+  ASSERT_TRUE(controller::makeOperation("bilateral:16,30", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::bilateral(16, 30).digest());
+  EXPECT_NE(op.digest(), model::pipeline::bilateral(16, 31).digest());
+  EXPECT_EQ(op.radius, model::bilateral::radius(16));
+  EXPECT_FALSE(controller::makeOperation("bilateral:1,30", op, reason));
+  EXPECT_FALSE(controller::makeOperation("bilateral:8,200", op, reason));
+  EXPECT_FALSE(controller::makeOperation("bilateral:8", op, reason));
+}
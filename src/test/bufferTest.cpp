@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include "../model/imagebuffer.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/pyramid.hpp"
+
+class bufferFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    img = QImage(19, 11, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(x * 13 % 256, y * 23 % 256, (x + y) * 7));
+  }
+
+  QImage img;
+};
+
+// Копия буфера и буфер из QImage не копируют пиксели
+TEST_F(bufferFixture, copiesShareBits) {
+  auto buffer = model::ImageBuffer::fromImage(img);
+  EXPECT_EQ(buffer.constBits(), img.constBits());
+  EXPECT_EQ(buffer.format(), model::ImageBuffer::RGB32);
+  EXPECT_EQ(buffer.stride(), img.bytesPerLine());
+
+  model::ImageBuffer copy = buffer;
+  EXPECT_EQ(copy.constBits(), buffer.constBits());
+  EXPECT_TRUE(copy.isShared());
+  EXPECT_TRUE(copy.toImage() == img);
+}
+
+// Запись копирует только разделяемый буфер
+TEST_F(bufferFixture, writeDetaches) {
+  model::ImageBuffer own(19, 11, model::ImageBuffer::RGB32);
+  EXPECT_FALSE(own.isShared());
+  EXPECT_EQ(own.stride() % 64, 0);
+  const uchar *before = own.constBits();
+  own.line(3)[0] = 7;
+  EXPECT_EQ(own.constBits(), before);
+
+  model::ImageBuffer copy = own;
+  reinterpret_cast<QRgb *>(copy.line(0))[0] = qRgb(1, 2, 3);
+  EXPECT_NE(copy.constBits(), own.constBits());
+  EXPECT_EQ(reinterpret_cast<const QRgb *>(own.constLine(0))[0], 0u);
+
+  auto wrapped = model::ImageBuffer::fromImage(img);
+  reinterpret_cast<QRgb *>(wrapped.line(0))[0] = qRgb(9, 9, 9);
+  EXPECT_EQ(img.pixel(0, 0), qRgb(0, 0, 0));
+  EXPECT_EQ(wrapped.toImage().pixel(0, 0), qRgb(9, 9, 9));
+
+  // QImage без других владельцев не разделяется: запись без копирования
+  auto sole = model::ImageBuffer::fromImage(img.copy());
+  EXPECT_FALSE(sole.isShared());
+  before = sole.constBits();
+  reinterpret_cast<QRgb *>(sole.line(0))[0] = qRgb(9, 9, 9);
+  EXPECT_EQ(sole.constBits(), before);
+  EXPECT_EQ(sole.toImage().pixel(0, 0), qRgb(9, 9, 9));
+  QImage held = sole.toImage();
+  EXPECT_TRUE(sole.isShared());
+  sole.line(0)[0] = 0;
+  EXPECT_EQ(held.pixel(0, 0), qRgb(9, 9, 9));
+}
+
+// Область разделяет пиксели с родителем, запись копирует только ее
+TEST_F(bufferFixture, viewSharesParent) {
+  auto buffer = model::ImageBuffer::fromImage(img);
+  auto view = buffer.view(QRect(4, 3, 8, 5));
+  EXPECT_TRUE(view.isView());
+  EXPECT_EQ(view.width(), 8);
+  EXPECT_EQ(view.constLine(0), buffer.constLine(3) + 4 * 4);
+  EXPECT_TRUE(view.toImage() == img.copy(QRect(4, 3, 8, 5)));
+  EXPECT_EQ(buffer.view(QRect(15, 8, 10, 10)).rect(), QRect(0, 0, 4, 3));
+  EXPECT_TRUE(buffer.view(QRect(40, 0, 2, 2)).isNull());
+
+  reinterpret_cast<QRgb *>(view.line(0))[0] = qRgb(1, 2, 3);
+  EXPECT_FALSE(view.isView());
+  EXPECT_EQ(view.width(), 8);
+  EXPECT_EQ(view.toImage().pixel(0, 0), qRgb(1, 2, 3));
+  EXPECT_EQ(view.toImage().pixel(1, 0), img.pixel(5, 3));
+  EXPECT_TRUE(buffer.toImage() == img);
+}
+
+// Планарные форматы переводятся в RGB32 без потерь
+TEST_F(bufferFixture, planarRoundTrip) {
+  auto buffer = model::ImageBuffer::fromImage(img);
+  for (auto format :
+       {model::ImageBuffer::PLANAR8, model::ImageBuffer::PLANAR_FLOAT}) {
+    auto planar = buffer.convertTo(format);
+    EXPECT_EQ(planar.layout(), model::ImageBuffer::PLANAR);
+    EXPECT_EQ(planar.planes(), 3);
+    EXPECT_TRUE(planar.toImage() == img);
+  }
+  auto planes = buffer.convertTo(model::ImageBuffer::PLANAR_FLOAT);
+  auto green = reinterpret_cast<const float *>(planes.constLine(4, GREEN));
+  EXPECT_FLOAT_EQ(green[5], float(qGreen(img.pixel(5, 4))));
+}
+
+// Цепочка над буфером не меняет исходный буфер
+TEST_F(bufferFixture, pipelineKeepsSource) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::negative());
+  chain.push(model::pipeline::Operation::convolution("Sharpen",
+                                                     model::filter::sharpen));
+  auto result = chain.run(source);
+  EXPECT_TRUE(source.toImage() == img);
+  EXPECT_TRUE(result.toImage() == chain.run(img));
+}
+
+// Уменьшение усредняет прямоугольники и сохраняет пропорции
+TEST_F(bufferFixture, downscaledAverages) {
+  auto buffer = model::ImageBuffer::fromImage(img);
+  EXPECT_EQ(buffer.downscaled(QSize(40, 40)).constBits(), buffer.constBits());
+  auto half = buffer.downscaled(QSize(9, 9));
+  ASSERT_EQ(half.width(), 9);
+  EXPECT_EQ(half.height(), 5);
+  // пиксель (1, 1) - среднее блока x 2..3, y 2..3 (11 / 5 = 2.2)
+  int sum = 0;
+  for (int y = 2; y < 4; ++y)
+    for (int x = 2; x < 4; ++x) sum += qRed(img.pixel(x, y));
+  EXPECT_EQ(qRed(half.toImage().pixel(1, 1)), (sum + 2) / 4);
+  EXPECT_TRUE(buffer.downscaled(QSize(0, 5)).isNull());
+}
+
+// Уровень пирамиды - среднее 2x2 с округлением, векторное ядро и хвост
+// дают то же, что прямой расчет
+TEST_F(bufferFixture, pyramidHalves) {
+  QImage wide(75, 23, QImage::Format_RGB32);
+  for (int y = 0; y < wide.height(); ++y)
+    for (int x = 0; x < wide.width(); ++x)
+      wide.setPixel(x, y, qRgb(x * 29 % 256, y * 41 % 256, (x * y) % 256));
+  auto half = model::pyramid::halve(model::ImageBuffer::fromImage(wide), 3);
+  ASSERT_EQ(half.width(), 37);
+  ASSERT_EQ(half.height(), 11);
+  QImage res = half.toImage();
+  for (int y = 0; y < half.height(); ++y)
+    for (int x = 0; x < half.width(); ++x) {
+      QRgb p[4] = {wide.pixel(2 * x, 2 * y), wide.pixel(2 * x + 1, 2 * y),
+                   wide.pixel(2 * x, 2 * y + 1),
+                   wide.pixel(2 * x + 1, 2 * y + 1)};
+      int r = 2, g = 2, b = 2;
+      for (QRgb v : p) r += qRed(v), g += qGreen(v), b += qBlue(v);
+      ASSERT_EQ(res.pixel(x, y), qRgb(r / 4, g / 4, b / 4)) << x << "," << y;
+    }
+}
+
+// Уровни уменьшаются вдвое до наименьшей стороны, выбор уровня по масштабу
+TEST_F(bufferFixture, pyramidLevels) {
+  model::ImageBuffer big(1000, 600, model::ImageBuffer::RGB32);
+  auto levels = model::pyramid::build(big, 64);
+  ASSERT_EQ(levels.size(), 4u);
+  EXPECT_EQ(levels[0].constBits(), big.constBits());
+  EXPECT_EQ(levels[3].width(), 125);
+  EXPECT_EQ(levels[3].height(), 75);
+  EXPECT_EQ(model::pyramid::levelFor(1.0, levels), 0);
+  EXPECT_EQ(model::pyramid::levelFor(0.5, levels), 1);
+  EXPECT_EQ(model::pyramid::levelFor(0.3, levels), 1);
+  EXPECT_EQ(model::pyramid::levelFor(0.01, levels), 3);
+  EXPECT_TRUE(model::pyramid::halve(model::ImageBuffer()).isNull());
+}
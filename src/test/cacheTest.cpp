@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "../controller/controller.hpp"
+#include "../model/cache.hpp"
+#include "../model/diskcache.hpp"
+#include "../model/hash.hpp"
+#include "../model/metrics.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/render.hpp"
+
+class cacheFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    img = QImage(40, 30, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(x * 6, y * 8, (x * y) % 256));
+  }
+
+  QImage img;
+};
+
+// Ключ зависит от содержимого и параметров, но не от выравнивания строк
+TEST_F(cacheFixture, keysFollowContent) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::ImageBuffer copy(40, 30, model::ImageBuffer::RGB32);
+  for (int y = 0; y < 30; ++y)
+    std::memcpy(copy.line(y), source.constLine(y), 40 * 4);
+  EXPECT_EQ(model::hash::image(source), model::hash::image(copy));
+  reinterpret_cast<QRgb *>(copy.line(29))[39] ^= 1;
+  EXPECT_NE(model::hash::image(source), model::hash::image(copy));
+  EXPECT_EQ(model::hash::image(source.view(QRect(3, 4, 10, 10))),
+            model::hash::image(source.view(QRect(3, 4, 10, 10)).convertTo(
+                model::ImageBuffer::PLANAR8).convertTo(
+                model::ImageBuffer::RGB32)));
+
+  using model::pipeline::toning;
+  EXPECT_EQ(toning(QColor(255, 0, 0)).digest(),
+            toning(QColor(255, 0, 0)).digest());
+  EXPECT_NE(toning(QColor(255, 0, 0)).digest(),
+            toning(QColor(254, 0, 0)).digest());
+  using model::pipeline::Operation;
+  Operation luma = Operation::convolution("Op", {1.0f}, true);
+  Operation window = luma;
+  window.kind = Operation::WINDOW;
+  window.lumaOnly = false;
+  EXPECT_NE(luma.digest(), window.digest());
+  model::pipeline::Pipeline a, b;
+  a.push(model::pipeline::negative());
+  a.push(model::pipeline::sepia());
+  b.push(model::pipeline::sepia());
+  b.push(model::pipeline::negative());
+  EXPECT_NE(a.digest(), b.digest());
+}
+
+// При превышении бюджета вытесняется давно не использованный результат
+TEST_F(cacheFixture, leastRecentlyUsedEvicted) {
+  auto source = model::ImageBuffer::fromImage(img);
+  const std::size_t size = model::cache::footprint(source);
+  model::cache::ResultCache cache(size * 2);
+  cache.insert({1, 1}, source);
+  cache.insert({1, 2}, source);
+  model::ImageBuffer found;
+  EXPECT_TRUE(cache.find({1, 1}, found));
+  EXPECT_EQ(found.constBits(), source.constBits());
+  cache.insert({1, 3}, source);
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(cache.bytes(), size * 2);
+  EXPECT_FALSE(cache.find({1, 2}, found));
+  EXPECT_TRUE(cache.find({1, 1}, found));
+  cache.setBudget(size - 1);
+  EXPECT_EQ(cache.size(), 0u);
+  cache.insert({1, 4}, source);
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+// Повторное переключение фильтров берется из кеша с тем же результатом
+TEST_F(cacheFixture, togglingFiltersHits) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  ASSERT_TRUE(controller::image_validation(data, img));
+  model::metrics::reset();
+  controller::convolution(data, model::filter::emboss, reason, status);
+  QImage emboss = data.resultingImage.toImage();
+  controller::convolution(data, model::filter::sharpen, reason, status);
+  controller::convolution(data, model::filter::emboss, reason, status);
+  EXPECT_TRUE(data.resultingImage.toImage() == emboss);
+  EXPECT_EQ(model::metrics::counter("cache.misses"), 2);
+  EXPECT_EQ(model::metrics::counter("cache.hits"), 1);
+
+  controller::process(data, {"negative", "sharpen"}, reason, status);
+  QImage chain = data.resultingImage.toImage();
+  controller::process(data, {"negative", "sharpen"}, reason, status);
+  EXPECT_TRUE(data.resultingImage.toImage() == chain);
+  EXPECT_EQ(model::metrics::counter("cache.hits"), 2);
+
+  // другое содержимое - другой ключ
+  s21::ProgramData other;
+  other.cache = data.cache;
+  QImage changed = img.copy(img.rect());
+  changed.setPixel(0, 0, qRgb(1, 2, 3));
+  ASSERT_TRUE(controller::image_validation(other, changed));
+  controller::convolution(other, model::filter::emboss, reason, status);
+  EXPECT_EQ(model::metrics::counter("cache.misses"), 4);
+}
+
+// Отрисовка уже посчитанной цепочки отдается из кеша сразу
+TEST_F(cacheFixture, renderPresentsCached) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  ASSERT_TRUE(controller::image_validation(data, img));
+  model::render::Renderer renderer(2);
+  controller::chain::append(data, model::pipeline::sepia());
+  auto first = controller::chain::start(data, renderer, img.rect(), 1.0, {},
+                                        {}, reason, status);
+  renderer.wait();
+  ASSERT_TRUE(controller::chain::commit(data, renderer, first));
+
+  int tiles = 0;
+  std::uint64_t done = 0;
+  auto second = controller::chain::start(
+      data, renderer, img.rect(), 1.0,
+      [&](const model::render::Tile &tile) {
+        ++tiles;
+        EXPECT_EQ(tile.rect, img.rect());
+      },
+      [&](std::uint64_t generation) { done = generation; }, reason, status);
+  EXPECT_EQ(tiles, 1);
+  EXPECT_EQ(done, second);
+  ASSERT_TRUE(controller::chain::commit(data, renderer, second));
+  EXPECT_TRUE(data.resultingImage.toImage() == data.chain.run(img));
+}
+
+// Кеш на диске: результат находится по ключу, лишние файлы удаляются
+TEST_F(cacheFixture, diskCacheStoresAndEvicts) {
+  namespace fs = std::filesystem;
+  const fs::path root = fs::temp_directory_path() / "photolab_disk_cache";
+  fs::remove_all(root);
+  const std::string input = (root.parent_path() / "photolab_in.bin").string();
+  {
+    std::ofstream out(input, std::ios::binary);
+    out << std::string(1000, 'a');
+  }
+  std::uint64_t first = 0, second = 0;
+  ASSERT_TRUE(model::cache::hashFile(input, first));
+  ASSERT_TRUE(model::cache::hashFile(input, second));
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first, model::hash::bytes(std::string(1000, 'a').data(), 1000));
+  EXPECT_FALSE(model::cache::hashFile((root / "missing").string(), second));
+
+  model::metrics::reset();
+  model::cache::DiskCache cache(root.string(), 2500);
+  ASSERT_TRUE(cache.isValid());
+  const std::string output = (root.parent_path() / "photolab_out.bin").string();
+  EXPECT_FALSE(cache.fetch(1, "png", output));
+  ASSERT_TRUE(cache.store(1, "png", input));
+  ASSERT_TRUE(cache.store(2, "png", input));
+  ASSERT_TRUE(cache.fetch(1, "png", output));
+  EXPECT_EQ(fs::file_size(output), 1000u);
+  // время изменения файла грубое, ключ 2 делается заведомо старше
+  fs::last_write_time(cache.path(2, "png"),
+                      fs::file_time_type::clock::now() - std::chrono::hours(1));
+  ASSERT_TRUE(cache.store(3, "png", input));
+  EXPECT_EQ(cache.bytes(), 2000u);
+  EXPECT_FALSE(fs::exists(cache.path(2, "png")));
+  EXPECT_TRUE(cache.fetch(1, "png", output));
+  EXPECT_FALSE(cache.fetch(1, "jpg", output));
+  EXPECT_EQ(model::metrics::counter("disk_cache.hits"), 2);
+  EXPECT_EQ(model::metrics::counter("disk_cache.misses"), 2);
+  EXPECT_EQ(model::metrics::counter("disk_cache.evictions"), 1);
+
+  // одинаковая цепочка описывается одинаково, область меняет описание
+  model::pipeline::Pipeline a, b;
+  QString reason;
+  ASSERT_TRUE(controller::makePipeline({"negative", "sharpen"}, a, reason));
+  ASSERT_TRUE(controller::makePipeline({"negative", "sharpen"}, b, reason));
+  EXPECT_FALSE(controller::makePipeline({"unknown"}, b, reason));
+  ASSERT_TRUE(controller::makePipeline({"negative", "sharpen"}, b, reason));
+  EXPECT_EQ(controller::describe(a), controller::describe(b));
+  EXPECT_NE(controller::describe(a),
+            controller::describe(a, QRect(0, 0, 5, 5)));
+  // ключ зависит от версии кеша, а не только от входа и цепочки
+  const std::uint64_t chain = controller::describe(a);
+  EXPECT_EQ(model::cache::DiskCache::key(first, chain),
+            model::cache::DiskCache::key(first, chain));
+  EXPECT_NE(model::cache::DiskCache::key(first, chain),
+            model::hash::combine(first, chain));
+  fs::remove_all(root);
+  fs::remove(input);
+  fs::remove(output);
+}
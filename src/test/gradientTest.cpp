@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/gradient.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+
+class gradientFixture : public ::testing::Test {
+ protected:
+  // Производные двумя свертками 3x3, края повторяются
+  static void naive(const std::vector<std::uint8_t> &src, int width,
+                    int rows, bool sobel, bool l2,
+                    std::vector<std::uint8_t> &magnitude,
+                    std::vector<std::uint8_t> &orientation) {
+    const int k = sobel ? 2 : 1;
+    const int kx[9] = {-1, 0, 1, -k, 0, k, -1, 0, 1};
+    const int ky[9] = {-1, -k, -1, 0, 0, 0, 1, k, 1};
+    magnitude.assign(src.size(), 0);
+    orientation.assign(src.size(), 0);
+    for (int y = 0; y < rows; ++y)
+      for (int x = 0; x < width; ++x) {
+        int gx = 0, gy = 0;
+        for (int i = 0; i < 9; ++i) {
+          const int v = src[std::clamp(y + i / 3 - 1, 0, rows - 1) * width +
+                            std::clamp(x + i % 3 - 1, 0, width - 1)];
+          gx += kx[i] * v;
+          gy += ky[i] * v;
+        }
+        const double m = l2 ? std::sqrt(double(gx * gx + gy * gy))
+                            : std::abs(gx) + std::abs(gy);
+        magnitude[y * width + x] = std::uint8_t(std::min(255L, std::lround(m)));
+        orientation[y * width + x] = std::uint8_t(
+            std::lround(std::atan2(gy, gx) * 128 / 3.14159265358979) & 255);
+      }
+  }
+};
+
+// Векторные ядра с хвостами совпадают со свертками для всех ядер и
+// модулей; направление - с точностью до единицы
+TEST_F(gradientFixture, planeMatchesConvolution) {
+  using model::gradient::Kernel;
+  using model::gradient::Norm;
+  std::mt19937 gen(7);
+  for (int width : {1, 7, 16, 37, 100}) {
+    const int rows = 13;
+    std::vector<std::uint8_t> src(width * rows);
+    for (auto &v : src) v = std::uint8_t(gen() % 2 ? gen() : gen() % 8);
+    for (int kernel = 0; kernel < 2; ++kernel)
+      for (int norm = 0; norm < 2; ++norm) {
+        std::vector<std::uint8_t> magnitude, orientation;
+        naive(src, width, rows, kernel == model::gradient::SOBEL,
+              norm == model::gradient::L2, magnitude, orientation);
+        std::vector<std::uint8_t> m(src.size()), o(src.size());
+        model::gradient::plane(src.data(), width, rows, Kernel(kernel),
+                               Norm(norm), 0, rows, m.data(), o.data());
+        ASSERT_EQ(m, magnitude) << width << " " << kernel << " " << norm;
+        for (std::size_t i = 0; i < o.size(); ++i)
+          ASSERT_LE(std::abs(std::int8_t(o[i] - orientation[i])), 1) << i;
+        std::vector<std::uint8_t> part(4 * width);
+        model::gradient::plane(src.data(), width, rows, Kernel(kernel),
+                               Norm(norm), 5, 9, part.data());
+        EXPECT_TRUE(std::equal(part.begin(), part.end(),
+                               magnitude.begin() + 5 * width));
+      }
+  }
+}
+
+// Вертикальный край: производная только по x, направление вдоль оси x
+TEST_F(gradientFixture, verticalEdge) {
+  QImage edge(40, 10, QImage::Format_Grayscale8);
+  for (int y = 0; y < edge.height(); ++y)
+    for (int x = 0; x < edge.width(); ++x)
+      edge.setPixel(x, y, x < 20 ? qRgb(10, 10, 10) : qRgb(40, 40, 40));
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::gradient(model::gradient::PREWITT,
+                                       model::gradient::L2));
+  const QImage magnitude = chain.run(edge);
+  for (int y = 0; y < edge.height(); ++y) {
+    EXPECT_EQ(qGreen(magnitude.pixel(5, y)), 0);
+    EXPECT_EQ(qGreen(magnitude.pixel(19, y)), 90);
+    EXPECT_EQ(qGreen(magnitude.pixel(20, y)), 90);
+  }
+  chain.clear();
+  chain.push(model::pipeline::gradient(model::gradient::SOBEL,
+                                       model::gradient::L1, true));
+  // направление 0 - красный, яркость - модуль
+  EXPECT_EQ(chain.run(edge).pixel(20, 5), qRgb(120, 0, 0));
+}
+
+// Ядро, модуль и вывод направления разбираются из командной строки
+TEST_F(gradientFixture, makeOperation) {
+  model::pipeline::Operation op;
+  QString reason;
+  ASSERT_TRUE(controller::makeOperation("gradient", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::gradient(model::gradient::SOBEL,
+                                                   model::gradient::L2)
+                             .digest());
+  ASSERT_TRUE(controller::makeOperation("gradient:prewitt,l1,orientation",
+                                        op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::gradient(model::gradient::PREWITT,
+                                                   model::gradient::L1, true)
+                             .digest());
+  EXPECT_NE(op.digest(), model::pipeline::gradient(model::gradient::PREWITT,
+                                                   model::gradient::L1)
+                             .digest());
+  EXPECT_FALSE(controller::makeOperation("gradient:scharr", op, reason));
+}
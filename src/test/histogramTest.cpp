@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/histogram.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/pointop.hpp"
+
+class histogramFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(46);
+    std::uniform_int_distribution<int> dist(0, 255);
+    img = QImage(301, 97, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(dist(gen), x % 256, y * 2));
+  }
+
+  // Подсчет по одному пикселю
+  static model::histogram::Histogram naive(const QImage &image) {
+    model::histogram::Histogram res;
+    for (int y = 0; y < image.height(); ++y)
+      for (int x = 0; x < image.width(); ++x) {
+        const QRgb p = image.pixel(x, y);
+        ++res.bins[RED][qRed(p)];
+        ++res.bins[GREEN][qGreen(p)];
+        ++res.bins[BLUE][qBlue(p)];
+        ++res.bins[model::histogram::kLuma]
+                  [(77 * qRed(p) + 150 * qGreen(p) + 29 * qBlue(p) + 128) >>
+                   8];
+        ++res.count;
+      }
+    return res;
+  }
+
+  QImage img;
+};
+
+// Параллельный подсчет совпадает с последовательным для всех форматов
+TEST_F(histogramFixture, computeMatchesNaive) {
+  auto source = model::ImageBuffer::fromImage(img);
+  const auto expected = naive(img);
+  EXPECT_TRUE(model::histogram::compute(source, 1) == expected);
+  EXPECT_TRUE(model::histogram::compute(source, 4) == expected);
+  EXPECT_TRUE(model::histogram::compute(source.view(QRect(3, 5, 40, 30))) ==
+              naive(img.copy(QRect(3, 5, 40, 30))));
+
+  QImage gray = img.convertToFormat(QImage::Format_Grayscale8);
+  EXPECT_TRUE(model::histogram::compute(model::ImageBuffer::fromImage(gray),
+                                        3) == naive(gray));
+  QImage indexed(50, 20, QImage::Format_Indexed8);
+  indexed.setColorTable({qRgb(10, 20, 30), qRgb(200, 0, 100)});
+  for (int y = 0; y < indexed.height(); ++y)
+    for (int x = 0; x < indexed.width(); ++x) indexed.setPixel(x, y, x % 3 % 2);
+  const auto palette =
+      model::histogram::compute(model::ImageBuffer::fromImage(indexed), 2);
+  EXPECT_TRUE(palette == naive(indexed));
+  EXPECT_EQ(palette.bins[RED][200], 340u);
+  EXPECT_EQ(model::histogram::compute(model::ImageBuffer()).count, 0u);
+}
+
+// 16-битные отсчеты, в том числе через границу кусков
+TEST_F(histogramFixture, compute16) {
+  std::mt19937 gen(16);
+  std::vector<std::uint16_t> samples(200003);
+  for (auto &s : samples) s = std::uint16_t(gen() % 4096 * 16);
+  std::vector<std::uint64_t> expected(65536, 0);
+  for (auto s : samples) ++expected[s];
+  EXPECT_EQ(model::histogram::compute16(samples.data(), samples.size(), 3),
+            expected);
+  EXPECT_EQ(model::histogram::compute16(nullptr, 0).size(), 65536u);
+}
+
+// Процентили и среднее
+TEST_F(histogramFixture, statistics) {
+  model::histogram::Histogram h;
+  h.bins[RED][10] = 1;
+  h.bins[RED][20] = 98;
+  h.bins[RED][250] = 1;
+  h.count = 100;
+  EXPECT_EQ(h.percentile(RED, 0), 10);
+  EXPECT_EQ(h.percentile(RED, 0.01), 10);
+  EXPECT_EQ(h.percentile(RED, 0.5), 20);
+  EXPECT_EQ(h.percentile(RED, 0.99), 20);
+  EXPECT_EQ(h.percentile(RED, 1), 250);
+  EXPECT_DOUBLE_EQ(h.mean(RED), (10 + 20 * 98 + 250) / 100.0);
+  EXPECT_NE(model::histogram::report(h).find("red: min 10"),
+            std::string::npos);
+}
+
+// Выравнивание растягивает распределение, автоуровни - диапазон; однотонные
+// каналы не меняются
+TEST_F(histogramFixture, equalizationAndAutoLevels) {
+  QImage dull(64, 64, QImage::Format_RGB32);
+  for (int y = 0; y < dull.height(); ++y)
+    for (int x = 0; x < dull.width(); ++x)
+      dull.setPixel(x, y, qRgb(100 + x / 2, 120 + (x + y) % 16, 77));
+  auto source = model::ImageBuffer::fromImage(dull);
+  const auto before = model::histogram::compute(source);
+
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::autoLevels(before, 0));
+  auto stretched = model::histogram::compute(chain.run(source));
+  EXPECT_EQ(stretched.percentile(RED, 0), 0);
+  EXPECT_EQ(stretched.percentile(RED, 1), 255);
+  EXPECT_EQ(stretched.percentile(GREEN, 0), 0);
+  EXPECT_EQ(stretched.percentile(GREEN, 1), 255);
+  EXPECT_EQ(stretched.bins[BLUE][77], stretched.count);
+
+  chain.clear();
+  chain.push(model::pipeline::equalization(before));
+  auto equalized = model::histogram::compute(chain.run(source));
+  EXPECT_EQ(equalized.percentile(RED, 0), 0);
+  EXPECT_EQ(equalized.percentile(RED, 1), 255);
+  // равномерный канал остается равномерным: медиана у середины
+  EXPECT_NEAR(equalized.percentile(RED, 0.5), 128, 8);
+  EXPECT_EQ(equalized.bins[BLUE][77], equalized.count);
+
+  const auto lut = model::histogram::equalization(before);
+  for (int c = RED; c <= BLUE; ++c)
+    for (int v = 1; v < 256; ++v) ASSERT_LE(lut[c][v - 1], lut[c][v]);
+  EXPECT_TRUE(model::histogram::equalization(model::histogram::Histogram()) ==
+              model::pointop::identityLut());
+}
+
+// Гистограмма сеанса - по текущему результату
+TEST_F(histogramFixture, sessionHistogram) {
+  s21::ProgramData data;
+  EXPECT_EQ(controller::histogram(data).count, 0u);
+  ASSERT_TRUE(controller::image_validation(data, img));
+  EXPECT_TRUE(controller::histogram(data) == naive(img));
+  QString reason;
+  bool status{false};
+  controller::chain::push(data, model::pipeline::negative(), reason, status);
+  ASSERT_TRUE(status);
+  const auto negative = controller::histogram(data);
+  EXPECT_EQ(negative.bins[GREEN][255], naive(img).bins[GREEN][0]);
+}
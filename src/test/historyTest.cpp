@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/history.hpp"
+#include "../model/metrics.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/render.hpp"
+
+class historyFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(43);
+    std::uniform_int_distribution<int> dist(0, 255);
+    img = QImage(300, 200, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(dist(gen), x % 256, y));
+  }
+
+  // Цепочка из n фильтров
+  static model::pipeline::Pipeline chain(int n) {
+    model::pipeline::Pipeline res;
+    for (int i = 0; i < n; ++i)
+      res.push(i % 2 ? model::pipeline::negative()
+                     : model::pipeline::sepia());
+    return res;
+  }
+
+  QImage img;
+};
+
+// Сжатие без потерь; плавные и однотонные данные сжимаются сильно
+TEST_F(historyFixture, codecRoundTrip) {
+  std::mt19937 gen(1);
+  std::vector<std::uint8_t> noise(100000), smooth(100000, 7);
+  for (auto &b : noise) b = std::uint8_t(gen());
+  for (std::size_t i = 0; i < smooth.size(); ++i)
+    smooth[i] = std::uint8_t(i / 3);
+  for (auto const *data : {&noise, &smooth}) {
+    auto packed = model::history::compress(data->data(), data->size());
+    std::vector<std::uint8_t> back(data->size());
+    ASSERT_TRUE(model::history::decompress(packed, back.data(), back.size()));
+    EXPECT_EQ(back, *data);
+    packed.pop_back();
+    EXPECT_FALSE(model::history::decompress(packed, back.data(), back.size()));
+  }
+  EXPECT_LT(model::history::compress(noise.data(), noise.size()).size(),
+            noise.size() * 104 / 100);
+  EXPECT_LT(model::history::compress(smooth.data(), smooth.size()).size(),
+            smooth.size() / 3);
+  EXPECT_TRUE(model::history::compress(nullptr, 0).empty());
+}
+
+// Отмена и повтор возвращают цепочки и результаты без потерь
+TEST_F(historyFixture, undoRedoRestores) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::history::History history;
+  for (int n = 0; n <= 3; ++n) {
+    history.record(chain(n));
+    ASSERT_TRUE(history.attach(chain(n), chain(n).run(source)));
+  }
+  EXPECT_FALSE(history.attach(chain(5), source));
+  EXPECT_EQ(history.size(), 4u);
+  EXPECT_FALSE(history.canRedo());
+
+  model::pipeline::Pipeline restored;
+  model::ImageBuffer result;
+  ASSERT_TRUE(history.undo(restored, result));
+  ASSERT_TRUE(history.undo(restored, result));
+  EXPECT_EQ(restored.digest(), chain(1).digest());
+  EXPECT_TRUE(result.toImage() == chain(1).run(img));
+  ASSERT_TRUE(history.redo(restored, result));
+  EXPECT_EQ(restored.digest(), chain(2).digest());
+  EXPECT_TRUE(result.toImage() == chain(2).run(img));
+
+  // новая правка после отмены отбрасывает повтор
+  history.record(chain(2));
+  EXPECT_EQ(history.size(), 4u);
+  model::pipeline::Pipeline other = chain(2);
+  other.push(model::pipeline::grayscale(LUMA));
+  history.record(other);
+  EXPECT_EQ(history.size(), 4u);
+  EXPECT_FALSE(history.canRedo());
+  EXPECT_EQ(history.snapshots(), 3u);
+  ASSERT_TRUE(history.undo(restored, result));
+  ASSERT_TRUE(history.undo(restored, result));
+  ASSERT_TRUE(history.undo(restored, result));
+  EXPECT_FALSE(history.undo(restored, result));
+  EXPECT_TRUE(restored.isEmpty());
+  EXPECT_TRUE(result.toImage() == img);
+}
+
+// Неизмененные плитки общие, бюджет отбрасывает дальние снимки
+TEST_F(historyFixture, tilesSharedWithinBudget) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::history::History history(model::history::History::kDefaultBudget,
+                                   64);
+  history.record(chain(0));
+  history.attach(chain(0), source);
+  const std::size_t one = history.bytes();
+  // правка одной плитки из 20
+  model::ImageBuffer edited = source;
+  edited.line(10)[10] ^= 0xff;
+  history.record(chain(1));
+  history.attach(chain(1), edited);
+  EXPECT_GT(history.bytes(), one);
+  EXPECT_LT(history.bytes(), one + one / 10);
+  model::pipeline::Pipeline restored;
+  model::ImageBuffer result;
+  history.undo(restored, result);
+  EXPECT_TRUE(result.toImage() == img);
+  history.redo(restored, result);
+  EXPECT_TRUE(result.toImage() == edited.toImage());
+
+  // правка всего изображения на одну величину хранится разностью с
+  // предыдущим снимком
+  model::ImageBuffer shifted = edited;
+  for (int y = 0; y < shifted.height(); ++y)
+    for (int x = 0; x < shifted.width(); ++x) ++shifted.line(y)[x * 4 + 2];
+  const std::size_t two = history.bytes();
+  model::pipeline::Pipeline shift = chain(1);
+  shift.push(model::pipeline::grayscale(LUMA));
+  history.record(shift);
+  history.attach(shift, shifted);
+  EXPECT_LT(history.bytes(), two + one / 10);
+  history.undo(restored, result);
+  history.redo(restored, result);
+  EXPECT_TRUE(result.toImage() == shifted.toImage());
+  history.undo(restored, result);
+
+  model::metrics::reset();
+  history.record(chain(2));
+  history.attach(chain(2), chain(2).run(source));
+  history.setBudget(history.bytes() - 1);
+  EXPECT_LE(history.bytes(), history.budget());
+  // плитка первого снимка - основа разности правленой плитки второго, так
+  // что отбрасывание первого памяти не освобождает: отбрасываются оба
+  EXPECT_EQ(history.snapshots(), 1u);
+  EXPECT_EQ(model::metrics::counter("history.evictions"), 2);
+  // состояние без снимка возвращает только цепочку
+  history.undo(restored, result);
+  history.undo(restored, result);
+  EXPECT_TRUE(restored.isEmpty());
+  EXPECT_TRUE(result.isNull());
+}
+
+// Отмена в сеансе: результат из истории показывается без пересчета
+TEST_F(historyFixture, sessionUndoPresentsSnapshot) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  EXPECT_FALSE(controller::chain::undo(data));
+  ASSERT_TRUE(controller::image_validation(data, img));
+  model::render::Renderer renderer(2);
+  auto apply = [&](model::pipeline::Operation &&op) {
+    controller::chain::append(data, std::move(op));
+    auto generation = controller::chain::start(data, renderer, img.rect(),
+                                               1.0, {}, {}, reason, status);
+    renderer.wait();
+    ASSERT_TRUE(controller::chain::commit(data, renderer, generation));
+  };
+  apply(model::pipeline::sepia());
+  const QImage sepia = data.resultingImage.toImage();
+  apply(model::pipeline::negative());
+  controller::chain::drop(data);
+  EXPECT_EQ(data.history.size(), 4u);
+
+  // снимки, а не кеш результатов
+  data.cache->clear();
+  ASSERT_TRUE(controller::chain::undo(data));
+  EXPECT_EQ(controller::chain::names(data).size(), 2);
+  ASSERT_TRUE(controller::chain::undo(data));
+  EXPECT_TRUE(data.resultingImage.toImage() == sepia);
+  int tiles = 0;
+  controller::chain::start(
+      data, renderer, img.rect(), 1.0,
+      [&](const model::render::Tile &) { ++tiles; }, {}, reason, status);
+  EXPECT_EQ(tiles, 1);
+  ASSERT_TRUE(controller::chain::undo(data));
+  EXPECT_TRUE(data.resultingImage.toImage() == img);
+  EXPECT_FALSE(controller::chain::undo(data));
+  ASSERT_TRUE(controller::chain::redo(data));
+  EXPECT_TRUE(data.resultingImage.toImage() == sepia);
+  renderer.wait();
+}
@@ -0,0 +1,12 @@
+#include <gtest/gtest.h>
+
+#include <QApplication>
+
+// Общая точка входа тестов: QPixmap и сцена требуют приложения Qt, окно
+// не нужно, поэтому платформа - offscreen
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication app(argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/median.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+
+class medianFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(47);
+    std::uniform_int_distribution<int> dist(0, 255);
+    img = QImage(71, 53, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(dist(gen), (x * 7 + y) % 256, dist(gen) / 8));
+  }
+
+  // Медиана сортировкой окна, края повторяются
+  static std::vector<std::uint8_t> naive(const std::vector<std::uint8_t> &src,
+                                         int width, int rows, int radius) {
+    std::vector<std::uint8_t> res(src.size()), window;
+    for (int y = 0; y < rows; ++y)
+      for (int x = 0; x < width; ++x) {
+        window.clear();
+        for (int dy = -radius; dy <= radius; ++dy)
+          for (int dx = -radius; dx <= radius; ++dx)
+            window.push_back(src[std::clamp(y + dy, 0, rows - 1) * width +
+                                 std::clamp(x + dx, 0, width - 1)]);
+        std::nth_element(window.begin(), window.begin() + window.size() / 2,
+                         window.end());
+        res[y * width + x] = window[window.size() / 2];
+      }
+    return res;
+  }
+
+  QImage img;
+};
+
+// Гистограммный алгоритм совпадает с сортировкой окна при любом радиусе и
+// любом диапазоне строк
+TEST_F(medianFixture, planeMatchesSort) {
+  std::mt19937 gen(5);
+  const int width = 40, rows = 37;
+  std::vector<std::uint8_t> src(width * rows);
+  for (auto &v : src) v = std::uint8_t(gen() % 3 ? gen() : gen() % 16 * 16);
+  for (int radius : {1, 2, 5, 15}) {
+    const auto expected = naive(src, width, rows, radius);
+    std::vector<std::uint8_t> all(src.size());
+    model::median::plane(src.data(), width, rows, radius, 0, rows, all.data());
+    ASSERT_EQ(all, expected) << "radius " << radius;
+    std::vector<std::uint8_t> part(5 * width);
+    model::median::plane(src.data(), width, rows, radius, 11, 16,
+                         part.data());
+    EXPECT_TRUE(std::equal(part.begin(), part.end(),
+                           expected.begin() + 11 * width))
+        << "radius " << radius;
+  }
+}
+
+// Импульсный шум на плавном изображении убирается окном 3x3
+TEST_F(medianFixture, removesSaltAndPepper) {
+  QImage clean(64, 48, QImage::Format_RGB32);
+  for (int y = 0; y < clean.height(); ++y)
+    for (int x = 0; x < clean.width(); ++x)
+      clean.setPixel(x, y, qRgb(100 + x / 8, 100 + x / 8, 100 + x / 8));
+  QImage noisy = clean;
+  std::mt19937 gen(9);
+  for (int i = 0; i < 100; ++i)
+    noisy.setPixel(1 + gen() % 62, 1 + gen() % 46,
+                   i % 2 ? qRgb(255, 255, 255) : qRgb(0, 0, 0));
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::median(1));
+  const QImage filtered = chain.run(noisy);
+  int wrong = 0;
+  for (int y = 0; y < clean.height(); ++y)
+    for (int x = 0; x < clean.width(); ++x)
+      wrong += std::abs(qRed(filtered.pixel(x, y)) - qRed(clean.pixel(x, y))) >
+               1;
+  EXPECT_LT(wrong, 5);
+}
+
+// Цветное изображение фильтруется по каналам: красный совпадает с
+// сортировкой окна
+TEST_F(medianFixture, pipelineFiltersChannels) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::median(3));
+  const QImage result = chain.run(img);
+
+  std::vector<std::uint8_t> red(img.width() * img.height());
+  for (int y = 0; y < img.height(); ++y)
+    for (int x = 0; x < img.width(); ++x)
+      red[y * img.width() + x] = qRed(img.pixel(x, y));
+  const auto expected = naive(red, img.width(), img.height(), 3);
+  for (int y = 0; y < img.height(); ++y)
+    for (int x = 0; x < img.width(); ++x)
+      ASSERT_EQ(qRed(result.pixel(x, y)), expected[y * img.width() + x]);
+}
+
+// Радиус из командной строки входит в хеш, дробный и больше 15 отклоняется
+TEST_F(medianFixture, makeOperation) {
+  model::pipeline::Operation op;
+  QString reason;
+  ASSERT_TRUE(controller::makeOperation("median", op, reason));
+  EXPECT_EQ(op.radius, 1);
+  ASSERT_TRUE(controller::makeOperation("median:15", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::median(15).digest());
+  EXPECT_NE(op.digest(), model::pipeline::median(14).digest());
+  EXPECT_FALSE(controller::makeOperation("median:16", op, reason));
+  EXPECT_FALSE(controller::makeOperation("median:1.5", op, reason));
+  EXPECT_FALSE(controller::makeOperation("median:x", op, reason));
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/model.hpp"
+#include "../model/morphology.hpp"
+#include "../model/pipeline.hpp"
+
+class morphologyFixture : public ::testing::Test {
+ protected:
+  // Минимум или максимум окна перебором, края повторяются
+  static std::vector<std::uint8_t> extreme(
+      const std::vector<std::uint8_t> &src, int width, int rows, int rx,
+      int ry, bool maximum) {
+    std::vector<std::uint8_t> res(src.size());
+    for (int y = 0; y < rows; ++y)
+      for (int x = 0; x < width; ++x) {
+        int v = maximum ? 0 : 255;
+        for (int dy = -ry; dy <= ry; ++dy)
+          for (int dx = -rx; dx <= rx; ++dx) {
+            const int p = src[std::clamp(y + dy, 0, rows - 1) * width +
+                              std::clamp(x + dx, 0, width - 1)];
+            v = maximum ? std::max(v, p) : std::min(v, p);
+          }
+        res[y * width + x] = std::uint8_t(v);
+      }
+    return res;
+  }
+};
+
+// Все операции совпадают с перебором окна при любых радиусах, в том числе
+// больше плоскости, и для любого диапазона строк
+TEST_F(morphologyFixture, planeMatchesNaive) {
+  using model::morphology::Mode;
+  std::mt19937 gen(3);
+  const int width = 45, rows = 39;
+  std::vector<std::uint8_t> src(width * rows);
+  for (auto &v : src) v = std::uint8_t(gen());
+  const std::pair<int, int> radii[] = {{1, 1}, {0, 3}, {4, 0}, {7, 2},
+                                       {30, 50}};
+  for (auto [rx, ry] : radii) {
+    const auto eroded = extreme(src, width, rows, rx, ry, false);
+    const auto dilated = extreme(src, width, rows, rx, ry, true);
+    const std::vector<std::uint8_t> expected[4] = {
+        eroded, dilated, extreme(eroded, width, rows, rx, ry, true),
+        extreme(dilated, width, rows, rx, ry, false)};
+    for (int mode = 0; mode < 4; ++mode) {
+      std::vector<std::uint8_t> all(src.size());
+      model::morphology::plane(src.data(), width, rows, Mode(mode), rx, ry, 0,
+                               rows, all.data());
+      ASSERT_EQ(all, expected[mode]) << mode << " " << rx << "x" << ry;
+      std::vector<std::uint8_t> part(17 * width);
+      model::morphology::plane(src.data(), width, rows, Mode(mode), rx, ry, 9,
+                               26, part.data());
+      EXPECT_TRUE(std::equal(part.begin(), part.end(),
+                             expected[mode].begin() + 9 * width))
+          << mode << " " << rx << "x" << ry;
+    }
+  }
+}
+
+// Закрытие убирает с белого листа темные точки меньше элемента и не
+// трогает штрихи шире него, открытие лист не меняет, дилатация утончает
+// штрихи
+TEST_F(morphologyFixture, cleansDocument) {
+  QImage page(60, 40, QImage::Format_RGB32);
+  page.fill(qRgb(255, 255, 255));
+  for (int y = 10; y < 30; ++y)
+    for (int x = 20; x < 26; ++x) page.setPixel(x, y, qRgb(0, 0, 0));
+  page.setPixel(5, 5, qRgb(0, 0, 0));
+  page.setPixel(50, 33, qRgb(0, 0, 0));
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::morphology(model::morphology::CLOSE, 1, 1));
+  const QImage closed = chain.run(page);
+  EXPECT_EQ(closed.pixel(5, 5), qRgb(255, 255, 255));
+  EXPECT_EQ(closed.pixel(50, 33), qRgb(255, 255, 255));
+  for (int y = 10; y < 30; ++y)
+    for (int x = 19; x < 27; ++x)
+      ASSERT_EQ(closed.pixel(x, y), page.pixel(x, y)) << x << "," << y;
+
+  chain.clear();
+  chain.push(model::pipeline::morphology(model::morphology::OPEN, 1, 1));
+  EXPECT_TRUE(chain.run(page) == page);
+  chain.clear();
+  chain.push(model::pipeline::morphology(model::morphology::DILATE, 1, 0));
+  const QImage thinner = chain.run(page);
+  EXPECT_EQ(thinner.pixel(20, 15), qRgb(255, 255, 255));
+  EXPECT_EQ(thinner.pixel(21, 15), qRgb(0, 0, 0));
+}
+
+// Режим задается именем операции, один радиус означает квадратное окно
+TEST_F(morphologyFixture, makeOperation) {
+  using model::morphology::Mode;
+  model::pipeline::Operation op;
+  QString reason;
+  ASSERT_TRUE(controller::makeOperation("erode", op, reason));
+  EXPECT_EQ(op.digest(),
+            model::pipeline::morphology(model::morphology::ERODE, 1, 1)
+                .digest());
+  ASSERT_TRUE(controller::makeOperation("close:4,2", op, reason));
+  EXPECT_EQ(op.digest(),
+            model::pipeline::morphology(model::morphology::CLOSE, 4, 2)
+                .digest());
+  EXPECT_EQ(op.radius, 8);
+  EXPECT_NE(op.digest(),
+            model::pipeline::morphology(model::morphology::OPEN, 4, 2)
+                .digest());
+  ASSERT_TRUE(controller::makeOperation("dilate:3", op, reason));
+  EXPECT_EQ(op.digest(),
+            model::pipeline::morphology(model::morphology::DILATE, 3, 3)
+                .digest());
+  EXPECT_FALSE(controller::makeOperation("open:51", op, reason));
+  EXPECT_FALSE(controller::makeOperation("open:1.5", op, reason));
+  EXPECT_FALSE(controller::makeOperation("open:1,2,3", op, reason));
+}
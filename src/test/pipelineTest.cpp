@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../model/gradient.hpp"
+#include "../model/metrics.hpp"
+#include "../model/model.hpp"
+#include "../model/morphology.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/ycbcr.hpp"
+
+class pipelineFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(21);
+    std::uniform_int_distribution<int> dist(0, 255);
+    img = QImage(37, 29, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(dist(gen), dist(gen), dist(gen)));
+  }
+
+  // Прямая свертка целого изображения с нулями за краями
+  static QImage reference(QImage const &src, std::vector<float> const &k) {
+    int n = int(std::sqrt(k.size())), r = n / 2;
+    QImage res(src.width(), src.height(), QImage::Format_RGB32);
+    for (int y = 0; y < src.height(); ++y) {
+      for (int x = 0; x < src.width(); ++x) {
+        float acc[3] = {0, 0, 0};
+        for (int ky = 0; ky < n; ++ky) {
+          for (int kx = 0; kx < n; ++kx) {
+            int sx = x + kx - r, sy = y + ky - r;
+            if (sx < 0 || sy < 0 || sx >= src.width() || sy >= src.height())
+              continue;
+            QRgb p = src.pixel(sx, sy);
+            acc[0] += k[ky * n + kx] * qRed(p);
+            acc[1] += k[ky * n + kx] * qGreen(p);
+            acc[2] += k[ky * n + kx] * qBlue(p);
+          }
+        }
+        int c[3];
+        for (int i = 0; i < 3; ++i)
+          c[i] = int(std::lround(std::clamp(acc[i], 0.0f, 255.0f)));
+        res.setPixel(x, y, qRgb(c[0], c[1], c[2]));
+      }
+    }
+    return res;
+  }
+
+  // Полосы, потоки и область совпадают с обработкой целиком
+  static void stripsAndRoi(const model::pipeline::Pipeline &chain,
+                           const model::ImageBuffer &source,
+                           const QRect &roi) {
+    const model::ImageBuffer whole = chain.run(source, 0, 1);
+    EXPECT_TRUE(chain.run(source, 4, 3).toImage() == whole.toImage());
+    EXPECT_TRUE(chain.run(source, 5, 2).toImage() == whole.toImage());
+    EXPECT_TRUE(chain.region(source, roi).toImage() ==
+                whole.view(roi).toImage());
+  }
+
+  QImage img;
+  std::vector<float> blur5 = std::vector<float>(25, 1 / 25.0f);
+};
+
+// Одна свертка совпадает с прямым вычислением
+TEST_F(pipelineFixture, singleConvolution) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::Operation::convolution("Sharpen",
+                                                     model::filter::sharpen));
+  EXPECT_TRUE(chain.run(img, 4, 3) == reference(img, model::filter::sharpen));
+}
+
+// Полосы и потоки не меняют результат цепочки
+TEST_F(pipelineFixture, tilesMatchWholeImage) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::Operation::convolution("Sharpen",
+                                                     model::filter::sharpen));
+  chain.push(model::pipeline::negative());
+  chain.push(model::pipeline::Operation::convolution("Blur", blur5));
+  chain.push(model::pipeline::grayscale(LUMA));
+  chain.push(model::pipeline::toning(QColor(255, 128, 0)));
+
+  // последовательное применение с промежуточными изображениями целиком
+  QImage sequential = img;
+  for (auto const &op : chain.operations()) {
+    model::pipeline::Pipeline single;
+    single.push(op);
+    sequential = single.run(sequential, sequential.height(), 1);
+  }
+  EXPECT_TRUE(chain.run(img, img.height(), 1) == sequential);
+  EXPECT_TRUE(chain.run(img, 1, 4) == sequential);
+  EXPECT_TRUE(chain.run(img, 5, 2) == sequential);
+}
+
+// Соседние поточечные операции сливаются в один этап
+TEST_F(pipelineFixture, fusesPointOperations) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::grayscale(AVERAGE));
+  chain.push(model::pipeline::negative());
+  chain.push(model::pipeline::Operation::convolution("Emboss",
+                                                     model::filter::emboss));
+  chain.push(model::pipeline::negative());
+  auto stages = chain.plan();
+  ASSERT_EQ(stages.size(), 3u);
+  // матрица серого и таблица негатива компонуются в одну операцию
+  EXPECT_EQ(stages[0].points.size(), 1u);
+  EXPECT_EQ(stages[1].radius, 1);
+  EXPECT_EQ(stages[2].points.size(), 1u);
+
+  model::pipeline::Pipeline twice;
+  twice.push(model::pipeline::negative());
+  twice.push(model::pipeline::negative());
+  EXPECT_TRUE(twice.run(img) == img);
+}
+
+// Поточечные фильтры палитрового изображения меняют только палитру
+TEST_F(pipelineFixture, indexedKeepsPalette) {
+  QImage indexed(10, 7, QImage::Format_Indexed8);
+  indexed.setColorTable({qRgb(0, 0, 0), qRgb(250, 10, 30), qRgb(7, 200, 90),
+                         qRgb(255, 255, 255)});
+  for (int y = 0; y < indexed.height(); ++y)
+    for (int x = 0; x < indexed.width(); ++x)
+      indexed.setPixel(x, y, (x * 3 + y) % 4);
+  QImage rgb = indexed.convertToFormat(QImage::Format_RGB32);
+
+  model::pipeline::Pipeline points;
+  points.push(model::pipeline::negative());
+  points.push(model::pipeline::toning(QColor(255, 128, 0)));
+  QImage result = points.run(indexed);
+  EXPECT_EQ(result.format(), QImage::Format_Indexed8);
+  EXPECT_TRUE(result == points.run(rgb));
+
+  points.push(model::pipeline::Operation::convolution("Sharpen",
+                                                      model::filter::sharpen));
+  result = points.run(indexed);
+  EXPECT_EQ(result.format(), QImage::Format_RGB32);
+  EXPECT_TRUE(result == points.run(rgb));
+
+  // пустая цепочка возвращает источник в исходном формате
+  EXPECT_EQ(model::pipeline::Pipeline().run(indexed).format(),
+            QImage::Format_Indexed8);
+
+  QImage simple = indexed;
+  model::simple::negative(simple);
+  EXPECT_EQ(simple.format(), QImage::Format_Indexed8);
+  EXPECT_EQ(simple.color(1), qRgb(5, 245, 225));
+}
+
+// Серое изображение сворачивается по одной плоскости, результат тот же
+TEST_F(pipelineFixture, grayUsesSingleChannel) {
+  QImage gray = img;
+  model::simple::grayscale(gray, LUMA);
+  model::metrics::reset();
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::Operation::convolution("Blur", blur5));
+  QImage result = chain.run(gray, 4, 2);
+  EXPECT_TRUE(result == reference(gray, blur5));
+  auto tiles = model::metrics::counter("convolution.tiles");
+  EXPECT_GT(tiles, 0);
+  EXPECT_EQ(model::metrics::counter("convolution.single_channel_tiles"), tiles);
+
+  model::metrics::reset();
+  chain.run(img, 4, 2);
+  EXPECT_EQ(model::metrics::counter("convolution.single_channel_tiles"), 0);
+
+  // серый по формату источник остается серым после негатива, но не после
+  // тонирования
+  const QImage gray8 = gray.convertToFormat(QImage::Format_Grayscale8);
+  model::pipeline::Pipeline negated;
+  negated.push(model::pipeline::negative());
+  negated.push(model::pipeline::Operation::convolution("Blur", blur5));
+  model::metrics::reset();
+  EXPECT_TRUE(negated.run(gray8, 4, 2) == negated.run(gray, gray.height(), 1));
+  EXPECT_EQ(model::metrics::counter("convolution.single_channel_tiles"),
+            model::metrics::counter("convolution.tiles"));
+  model::pipeline::Pipeline toned;
+  toned.push(model::pipeline::toning(QColor(255, 128, 0)));
+  toned.push(model::pipeline::Operation::convolution("Blur", blur5));
+  model::metrics::reset();
+  EXPECT_TRUE(toned.run(gray8, 4, 2) == toned.run(gray, gray.height(), 1));
+  EXPECT_EQ(model::metrics::counter("convolution.single_channel_tiles"), 0);
+}
+
+// Перевод в YCbCr и обратно не меняет пиксели больше чем на единицу
+TEST_F(pipelineFixture, ycbcrRoundTrip) {
+  const std::size_t n = 13;
+  auto src = reinterpret_cast<const QRgb *>(img.constScanLine(0));
+  std::vector<float> y(n), cb(n), cr(n);
+  std::vector<QRgb> back(n);
+  model::ycbcr::split(src, y.data(), cb.data(), cr.data(), n);
+  model::ycbcr::merge(y.data(), cb.data(), cr.data(), back.data(), n);
+  for (std::size_t i = 0; i < n; ++i) {
+    EXPECT_LE(std::abs(qRed(back[i]) - qRed(src[i])), 1);
+    EXPECT_LE(std::abs(qGreen(back[i]) - qGreen(src[i])), 1);
+    EXPECT_LE(std::abs(qBlue(back[i]) - qBlue(src[i])), 1);
+  }
+}
+
+// В режиме lumaOnly сворачивается только яркость, цвет сохраняется
+TEST_F(pipelineFixture, lumaOnlyKeepsChroma) {
+  std::mt19937 gen(32);
+  std::uniform_int_distribution<int> dist(64, 192);
+  QImage soft(img.width(), img.height(), QImage::Format_RGB32);
+  for (int y = 0; y < soft.height(); ++y)
+    for (int x = 0; x < soft.width(); ++x)
+      soft.setPixel(x, y, qRgb(dist(gen), dist(gen), dist(gen)));
+
+  model::metrics::reset();
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::Operation::convolution("Blur", blur5, true));
+  QImage result = chain.run(soft, 4, 2);
+  EXPECT_GT(model::metrics::counter("convolution.luma_tiles"), 0);
+  EXPECT_TRUE(result == chain.run(soft, soft.height(), 1));
+
+  auto luma = [](QRgb p) {
+    return 0.299f * qRed(p) + 0.587f * qGreen(p) + 0.114f * qBlue(p);
+  };
+  auto cb = [](QRgb p) {
+    return -0.168736f * qRed(p) - 0.331264f * qGreen(p) + 0.5f * qBlue(p);
+  };
+  for (int y = 2; y < soft.height() - 2; ++y) {
+    for (int x = 2; x < soft.width() - 2; ++x) {
+      float expected = 0;
+      for (int dy = -2; dy <= 2; ++dy)
+        for (int dx = -2; dx <= 2; ++dx)
+          expected += luma(soft.pixel(x + dx, y + dy)) / 25.0f;
+      EXPECT_NEAR(luma(result.pixel(x, y)), expected, 1.0f);
+      EXPECT_NEAR(cb(result.pixel(x, y)), cb(soft.pixel(x, y)), 1.0f);
+    }
+  }
+}
+
+// Область совпадает с обработкой целого изображения, остальное не меняется
+TEST_F(pipelineFixture, regionOfInterest) {
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::Operation::convolution("Sharpen",
+                                                     model::filter::sharpen));
+  chain.push(model::pipeline::negative());
+  chain.push(model::pipeline::Operation::convolution("Blur", blur5));
+  QImage whole = chain.run(img);
+  auto source = model::ImageBuffer::fromImage(img);
+  for (QRect roi : {QRect(5, 4, 13, 9), QRect(0, 20, 37, 9),
+                    QRect(30, 0, 20, 3)}) {
+    QImage part = chain.run(source, roi, 2, 3).toImage();
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        EXPECT_EQ(part.pixel(x, y), roi.contains(QRect(x, y, 1, 1))
+                                        ? whole.pixel(x, y)
+                                        : img.pixel(x, y));
+  }
+  EXPECT_TRUE(source.toImage() == img);
+}
+
+// Каждый оконный фильтр отдельно и вместе со свертками и поточечными
+// фильтрами не зависит от разбиения на полосы и области
+TEST_F(pipelineFixture, windowOperations) {
+  using namespace model::pipeline;
+  std::vector<Operation> ops = {median(3), bilateral(3, 16),
+                                gradient(model::gradient::SOBEL,
+                                         model::gradient::L2),
+                                gradient(model::gradient::PREWITT,
+                                         model::gradient::L1, true)};
+  for (int mode = 0; mode < 4; ++mode)
+    ops.push_back(morphology(model::morphology::Mode(mode), 5, 2));
+  auto source = model::ImageBuffer::fromImage(img);
+  for (const auto &op : ops) {
+    SCOPED_TRACE(op.name);
+    Pipeline chain;
+    chain.push(op);
+    stripsAndRoi(chain, source, QRect(9, 6, 20, 17));
+    chain.clear();
+    chain.push(Operation::convolution("Blur", blur5));
+    chain.push(op);
+    chain.push(negative());
+    chain.push(median(1));
+    stripsAndRoi(chain, source, QRect(0, 11, 37, 9));
+  }
+}
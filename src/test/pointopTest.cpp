@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "../model/colormatrix.hpp"
+#include "../model/model.hpp"
+#include "../model/pointop.hpp"
+
+class pointopFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    // длина не кратна ширине SIMD-регистра и размеру блока
+    pixels.resize(1003);
+    for (auto &p : pixels) p = qRgb(dist(gen), dist(gen), dist(gen));
+  }
+
+  // последовательное применение без слияния
+  static std::vector<QRgb> sequential(
+      std::vector<QRgb> px, std::vector<model::pointop::PointOp> ops) {
+    for (auto const &op : ops) op.apply(px.data(), px.size());
+    return px;
+  }
+
+  std::vector<QRgb> pixels;
+};
+
+// Цепочка таблиц и матрицы с таблицей сливаются в одну операцию без потерь
+TEST_F(pointopFixture, fusesLutsAndMatrix) {
+  using namespace model::pointop;
+  std::vector<PointOp> ops{negative(), grayscale(LUMA), negative(),
+                           toning(QColor(200, 100, 50))};
+  Program program;
+  for (auto const &op : ops) program.append(op);
+  EXPECT_EQ(program.size(), 2u);
+
+  std::vector<QRgb> fused = pixels;
+  program.apply(fused.data(), fused.size());
+  EXPECT_EQ(fused, sequential(pixels, ops));
+}
+
+// Тонирование за один проход совпадает с серым и умножением на тон
+TEST_F(pointopFixture, toningSinglePass) {
+  QColor tone(255, 128, 0);
+  float t[3];
+  tone.getRgbF(&t[RED], &t[GREEN], &t[BLUE]);
+  std::vector<QRgb> px = pixels;
+  model::pointop::toning(tone).apply(px.data(), px.size());
+  for (std::size_t i = 0; i < px.size(); ++i) {
+    QRgb gray = model::pointop::grayscale(LUMA).apply(pixels[i]);
+    int v = qRed(gray);
+    EXPECT_EQ(qRed(px[i]), int(t[RED] * v + 0.5f));
+    EXPECT_EQ(qGreen(px[i]), int(t[GREEN] * v + 0.5f));
+    EXPECT_EQ(qBlue(px[i]), int(t[BLUE] * v + 0.5f));
+  }
+}
+
+// Матрицы, не выходящие за диапазон, перемножаются; DISSAT не сливается
+TEST_F(pointopFixture, matrixAndFunctionFusion) {
+  using namespace model::pointop;
+  Program program;
+  program.append(grayscale(AVERAGE));
+  program.append(grayscale(LUMA));
+  EXPECT_EQ(program.size(), 1u);
+  // слитая матрица не округляет промежуточный результат до 8 бит, поэтому
+  // расходится с последовательным применением не больше чем на единицу
+  Matrix dim = identityMatrix();
+  dim.m[RED][RED] = 0.7f;
+  dim.m[GREEN][BLUE] = 0.2f;
+  dim.m[GREEN][GREEN] = 0.75f;
+  dim.m[BLUE][BLUE] = 0.9f;
+  dim.m[BLUE][3] = 10.0f;
+  const std::vector<std::vector<PointOp>> chains{
+      {grayscale(AVERAGE), grayscale(LUMA)},
+      {PointOp::matrix(dim), grayscale(LUMA)},
+      {PointOp::matrix(dim), PointOp::matrix(dim), PointOp::matrix(dim)}};
+  for (auto const &chain : chains) {
+    Program fusedChain;
+    for (auto const &op : chain) fusedChain.append(op);
+    ASSERT_EQ(fusedChain.size(), 1u);
+    std::vector<QRgb> fused = pixels;
+    fusedChain.apply(fused.data(), fused.size());
+    const std::vector<QRgb> expected = sequential(pixels, chain);
+    for (std::size_t i = 0; i < pixels.size(); ++i) {
+      ASSERT_NEAR(qRed(fused[i]), qRed(expected[i]), 1) << i;
+      ASSERT_NEAR(qGreen(fused[i]), qGreen(expected[i]), 1) << i;
+      ASSERT_NEAR(qBlue(fused[i]), qBlue(expected[i]), 1) << i;
+    }
+  }
+  program.append(grayscale(DISSAT));
+  program.append(negative());
+  EXPECT_EQ(program.size(), 3u);
+
+  Matrix boost = identityMatrix();
+  boost.m[RED][RED] = 2.0f;
+  Program clamped;
+  clamped.append(PointOp::matrix(boost));
+  clamped.append(PointOp::matrix(identityMatrix()));
+  EXPECT_EQ(clamped.size(), 2u);
+  EXPECT_EQ(qRed(clamped.apply(qRgb(200, 0, 0))), 255);
+}
+
+// Векторное ядро совпадает с поэлементным вычислением для любых длин
+TEST_F(pointopFixture, colorMatrixKernel) {
+  model::pointop::Matrix mat{{{0.5f, 0.25f, -0.75f, 40.0f},
+                              {-1.0f, 0.0f, 0.0f, 255.0f},
+                              {1.2f, 0.7f, 0.1f, -10.0f}}};
+  for (std::size_t n : {1u, 7u, 16u, 17u, 1003u}) {
+    std::vector<QRgb> out(n);
+    model::colormatrix::transform(mat, pixels.data(), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+      float in[3] = {float(qRed(pixels[i])), float(qGreen(pixels[i])),
+                     float(qBlue(pixels[i]))};
+      int expected[3];
+      for (int c = 0; c < 3; ++c) {
+        float v = mat.m[c][3];
+        v += mat.m[c][0] * in[0];
+        v += mat.m[c][1] * in[1];
+        v += mat.m[c][2] * in[2];
+        expected[c] = int(std::clamp(v, 0.0f, 255.0f) + 0.5f);
+      }
+      ASSERT_EQ(out[i], qRgb(expected[0], expected[1], expected[2]))
+          << model::colormatrix::kernelName() << " n=" << n << " i=" << i;
+    }
+  }
+}
+
+// Многопоточное применение к изображению не меняет результат
+TEST_F(pointopFixture, colorMatrixImage) {
+  QImage img(300, 400, QImage::Format_RGB32);
+  for (int y = 0; y < img.height(); ++y)
+    for (int x = 0; x < img.width(); ++x)
+      img.setPixel(x, y, pixels[(x * 31 + y) % pixels.size()]);
+  const model::pointop::Matrix gray{{{0.3f, 0.6f, 0.1f, 0.0f},
+                                     {0.3f, 0.6f, 0.1f, 0.0f},
+                                     {0.3f, 0.6f, 0.1f, 0.0f}}};
+  QImage single = img, threaded = img;
+  model::simple::colorMatrix(single, model::pointop::identityMatrix());
+  EXPECT_TRUE(single == img);
+  model::colormatrix::apply(single, gray, 1);
+  model::colormatrix::apply(threaded, gray, 4);
+  EXPECT_TRUE(single == threaded);
+}
+
+// Уровни: нейтральные параметры - тождество, яркость и гамма по формуле
+TEST_F(pointopFixture, levelsTable) {
+  using namespace model::pointop;
+  EXPECT_TRUE(levels(0, 1, 1) == identityLut());
+  const Lut bright = levels(20, 1, 1);
+  EXPECT_EQ(bright[RED][0], 20);
+  EXPECT_EQ(bright[GREEN][100], 120);
+  EXPECT_EQ(bright[BLUE][250], 255);
+  const Lut flat = levels(0, 0, 1);
+  EXPECT_EQ(flat[RED][0], 128);
+  EXPECT_EQ(flat[RED][255], 128);
+  const Lut gamma = levels(0, 1, 2);
+  EXPECT_EQ(gamma[RED][64], 128);
+  EXPECT_EQ(gamma[RED][255], 255);
+}
+
+// Настройки ползунков сливаются в одну операцию без функции пикселя и
+// совпадают с последовательным применением частей
+TEST_F(pointopFixture, adjustmentFuses) {
+  using namespace model::pointop;
+  Adjustment settings;
+  EXPECT_TRUE(adjustment(settings).isLut());
+  std::vector<QRgb> same = pixels;
+  adjustment(settings).apply(same.data(), same.size());
+  EXPECT_EQ(same, pixels);
+
+  settings.weights[RED] = 1;
+  settings.weights[GREEN] = 2;
+  settings.weights[BLUE] = 1;
+  settings.tone = QColor(255, 160, 64);
+  settings.toning = 0.5f;
+  settings.brightness = 10;
+  settings.contrast = 1.5f;
+  settings.gamma = 0.8f;
+  const PointOp fused = adjustment(settings);
+  EXPECT_FALSE(fused.isFunction());
+  std::vector<QRgb> once = pixels;
+  fused.apply(once.data(), once.size());
+  auto expected =
+      sequential(pixels, {grayscale(1, 2, 1), toning(settings.tone, 0.5f),
+                          PointOp::lut(levels(10, 1.5f, 0.8f))});
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    ASSERT_NEAR(qRed(once[i]), qRed(expected[i]), 2) << i;
+    ASSERT_NEAR(qGreen(once[i]), qGreen(expected[i]), 2) << i;
+    ASSERT_NEAR(qBlue(once[i]), qBlue(expected[i]), 2) << i;
+  }
+}
+
+// Веса оттенков серого нормируются, тонирование с силой 0 - тождество
+TEST_F(pointopFixture, weightedGrayscaleAndToning) {
+  using namespace model::pointop;
+  EXPECT_EQ(grayscale(2, 2, 2).apply(qRgb(30, 60, 90)), qRgb(60, 60, 60));
+  EXPECT_EQ(grayscale(0, 1, 0).apply(qRgb(30, 60, 90)), qRgb(60, 60, 60));
+  EXPECT_EQ(grayscale(0, 0, 0).apply(qRgb(30, 60, 90)), qRgb(30, 60, 90));
+  std::vector<QRgb> same = pixels;
+  toning(QColor(200, 100, 50), 0).apply(same.data(), same.size());
+  EXPECT_EQ(same, pixels);
+  std::vector<QRgb> full = pixels;
+  toning(QColor(200, 100, 50), 1).apply(full.data(), full.size());
+  // полная сила - прежнее тонирование с точностью до округления
+  auto toned = sequential(pixels, {toning(QColor(200, 100, 50))});
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    ASSERT_NEAR(qRed(full[i]), qRed(toned[i]), 1) << i;
+    ASSERT_NEAR(qBlue(full[i]), qBlue(toned[i]), 1) << i;
+  }
+}
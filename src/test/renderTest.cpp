@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <QGraphicsScene>
+#include <fstream>
+#include <mutex>
+#include <random>
+
+#include "../controller/controller.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/pyramid.hpp"
+#include "../model/render.hpp"
+#include "../view/tileditem.h"
+
+namespace {
+// Резидентная память процесса в байтах (0, если /proc недоступен). Свободная
+// память арен malloc сначала возвращается системе, чтобы замер не зависел
+// от того, сколько ее осталось от предыдущих тестов
+long long residentBytes() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  std::ifstream statm("/proc/self/statm");
+  long long pages = 0, resident = 0;
+  if (!(statm >> pages >> resident)) return 0;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+}  // namespace
+
+class renderFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(36);
+    std::uniform_int_distribution<int> dist(0, 255);
+    img = QImage(300, 200, QImage::Format_RGB32);
+    for (int y = 0; y < img.height(); ++y)
+      for (int x = 0; x < img.width(); ++x)
+        img.setPixel(x, y, qRgb(dist(gen), dist(gen), dist(gen)));
+    chain.push(model::pipeline::Operation::convolution(
+        "Gaussian Blur", model::filter::gaussianBlur));
+    chain.push(model::pipeline::negative());
+    chain.push(model::pipeline::Operation::convolution(
+        "Sharpen", model::filter::sharpen));
+  }
+
+  QImage img;
+  model::pipeline::Pipeline chain;
+};
+
+// Плитки фоновой отрисовки складываются в тот же результат, что и run
+TEST_F(renderFixture, tilesMatchRun) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::render::Renderer renderer(4);
+  std::mutex mutex;
+  int tiles = 0, done = 0;
+  auto generation = renderer.start(
+      chain, source, QRect(0, 0, 100, 100), 1.0,
+      [&](const model::render::Tile &) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++tiles;
+      },
+      [&](std::uint64_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++done;
+      },
+      64);
+  renderer.wait();
+  EXPECT_EQ(generation, renderer.generation());
+  EXPECT_EQ(tiles, 5 * 4);
+  EXPECT_EQ(done, 1);
+  ASSERT_FALSE(renderer.result().isNull());
+  EXPECT_TRUE(renderer.result().toImage() == chain.run(img));
+}
+
+// Видимые плитки считаются раньше остальных, первой - центральная
+TEST_F(renderFixture, visibleTilesFirst) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::render::Renderer renderer(1);
+  const QRect visible(130, 60, 100, 60);
+  std::mutex mutex;
+  std::vector<model::render::Tile> order;
+  renderer.start(
+      chain, source, visible, 1.0,
+      [&](const model::render::Tile &tile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(tile);
+      },
+      {}, 50);
+  renderer.wait();
+  ASSERT_EQ(order.size(), 6u * 4u);
+  EXPECT_TRUE(order[0].rect.contains(QRect(179, 89, 1, 1)));
+  std::size_t shown = 0;
+  while (shown < order.size() && order[shown].visible) ++shown;
+  EXPECT_EQ(shown, 3u * 2u);
+  for (std::size_t i = shown; i < order.size(); ++i)
+    EXPECT_FALSE(order[i].rect.intersects(visible));
+  for (auto const &tile : order)
+    EXPECT_TRUE(tile.pixels.toImage() == chain.run(img).copy(tile.rect));
+}
+
+// При уменьшенном показе первым приходит черновик видимой области на
+// уровне пирамиды, итог - полного разрешения
+TEST_F(renderFixture, draftAtPyramidLevelFirst) {
+  auto source = model::ImageBuffer::fromImage(img);
+  model::render::Renderer renderer(3);
+  const QRect visible(10, 6, 200, 150);
+  std::mutex mutex;
+  std::vector<model::render::Tile> order;
+  renderer.start(
+      chain, source, visible, 0.3,
+      [&](const model::render::Tile &tile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(tile);
+      },
+      {}, 64);
+  renderer.wait();
+  ASSERT_EQ(order.size(), 1u + 5u * 4u);
+  const auto &first = order.front();
+  EXPECT_EQ(first.level, 1);
+  EXPECT_EQ(first.rect, QRect(10, 6, 200, 150));
+  auto reduced = model::pyramid::halve(source.view(first.rect));
+  EXPECT_TRUE(first.pixels.toImage() == chain.run(reduced).toImage());
+  for (std::size_t i = 1; i < order.size(); ++i)
+    EXPECT_EQ(order[i].level, 0);
+  EXPECT_TRUE(renderer.result().toImage() == chain.run(img));
+
+  order.clear();
+  renderer.start(
+      chain, source, QRect(1, 3, 7, 5), 0.2,
+      [&](const model::render::Tile &tile) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(tile);
+      },
+      {}, 64);
+  renderer.wait();
+  ASSERT_FALSE(order.empty());
+  EXPECT_EQ(order.front().level, 2);
+  EXPECT_EQ(order.front().rect, QRect(0, 0, 8, 8));
+}
+
+// Новый запуск отменяет прежний, отмененная отрисовка не дает результата
+TEST_F(renderFixture, restartAndCancel) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  model::render::Renderer renderer(2);
+  EXPECT_EQ(controller::chain::start(data, renderer, QRect(), 1.0, {}, {},
+                                     reason, status),
+            0u);
+  EXPECT_FALSE(status);
+
+  ASSERT_TRUE(controller::image_validation(data, img));
+  controller::chain::append(data, model::pipeline::sepia());
+  auto first = controller::chain::start(data, renderer, QRect(0, 0, 50, 50),
+                                        1.0, {}, {}, reason, status);
+  controller::chain::append(data, model::pipeline::negative());
+  auto second = controller::chain::start(data, renderer, QRect(0, 0, 50, 50),
+                                         1.0, {}, {}, reason, status);
+  EXPECT_TRUE(status);
+  EXPECT_GT(second, first);
+  renderer.setVisible(QRect(200, 100, 50, 50));
+  renderer.wait();
+  EXPECT_FALSE(controller::chain::commit(data, renderer, first));
+  ASSERT_TRUE(controller::chain::commit(data, renderer, second));
+  EXPECT_TRUE(data.resultingImage.toImage() == data.chain.run(img));
+
+  controller::chain::drop(data);
+  controller::chain::start(data, renderer, QRect(), 1.0, {}, {}, reason,
+                           status);
+  renderer.cancel();
+  renderer.wait();
+  EXPECT_TRUE(renderer.result().isNull());
+}
+
+// Сто фильтров подряд, как в окне: плитки, черновики и уровни пирамиды
+// рисуются в постоянный слой результата на сцене, число элементов сцены
+// не меняется, память не растет с числом фильтров
+TEST_F(renderFixture, hundredFiltersBoundedMemory) {
+  if (!residentBytes()) GTEST_SKIP() << "no /proc/self/statm";
+  QImage big(384, 384, QImage::Format_RGB32);
+  for (int y = 0; y < big.height(); ++y)
+    for (int x = 0; x < big.width(); ++x)
+      big.setPixel(x, y, img.pixel(x % img.width(), y % img.height()));
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  ASSERT_TRUE(controller::image_validation(data, big));
+  // кеш результатов и снимки истории ограничены своими бюджетами, здесь
+  // они малы
+  data.cache->setBudget(std::size_t(4) << 20);
+  data.history.setBudget(std::size_t(4) << 20);
+  QGraphicsScene scene;
+  auto layer = new s21::TiledItem();
+  scene.addItem(layer);
+  layer->setImage(big);
+  const auto items = scene.items().size();
+  model::render::Renderer renderer(4);
+  std::mutex mutex;
+  std::vector<model::render::Tile> delivered;
+  auto apply = [&](int i) {
+    if (i % 25 == 24)
+      controller::chain::append(data, model::pipeline::Operation::convolution(
+                                          "Sharpen", model::filter::sharpen));
+    else if (i % 2)
+      controller::chain::append(data, model::pipeline::negative());
+    else
+      controller::chain::append(data, model::pipeline::sepia());
+    auto generation = controller::chain::start(
+        data, renderer, QRect(0, 0, 128, 128), i % 3 ? 1.0 : 0.5,
+        [&](const model::render::Tile &tile) {
+          std::lock_guard<std::mutex> lock(mutex);
+          delivered.push_back(tile);
+        },
+        {}, reason, status);
+    renderer.wait();
+    // плитки рисуются в слой в потоке GUI, как в MainWindow::show_tile
+    for (auto const &tile : delivered) {
+      if (tile.level > 0)
+        layer->paintOver(QPixmap::fromImage(tile.pixels.toImage()),
+                         tile.rect);
+      else
+        layer->setTile(tile.rect.topLeft(), tile.pixels.toImage());
+    }
+    delivered.clear();
+    ASSERT_TRUE(controller::chain::commit(data, renderer, generation));
+    auto levels = model::pyramid::build(data.resultingImage, 64);
+    std::vector<QImage> images;
+    for (std::size_t level = 1; level < levels.size(); ++level)
+      images.push_back(levels[level].toImage());
+    layer->setLevels(images, layer->revision());
+    ASSERT_EQ(scene.items().size(), items);
+  };
+  for (int i = 0; i < 10; ++i) apply(i);
+  const long long before = residentBytes();
+  for (int i = 10; i < 100; ++i) apply(i);
+  const long long growth = residentBytes() - before;
+  // утечка одного результата с его плитками и пирамидой на фильтр дала бы
+  // больше 100 МБ, разогрев арен malloc в потоках отрисовки занимает до
+  // 20 МБ
+  EXPECT_LT(growth, 32LL << 20) << "RSS grew by " << (growth >> 20) << " MB";
+  EXPECT_EQ(data.chain.operations().size(), 100u);
+  EXPECT_EQ(layer->size(), big.size());
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "../controller/controller.hpp"
+#include "../model/model.hpp"
+#include "../model/pipeline.hpp"
+#include "../model/pointop.hpp"
+#include "../model/render.hpp"
+
+class sessionFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::mt19937 gen(33);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (int i = 0; i < 4; ++i) {
+      QImage img(23 + 5 * i, 17 + 3 * i, QImage::Format_RGB32);
+      for (int y = 0; y < img.height(); ++y)
+        for (int x = 0; x < img.width(); ++x)
+          img.setPixel(x, y, qRgb(dist(gen), dist(gen), dist(gen)));
+      images.push_back(img);
+    }
+  }
+
+  std::vector<QImage> images;
+  std::vector<QStringList> chains{
+      {"sharpen"},
+      {"negative", "box-blur"},
+      {"grayscale:luma", "emboss", "toning:#ff8000"},
+      {"custom:0,0,0,0,1,0,0,0,0", "sepia", "gaussian-blur"},
+      {"laplacian", "matrix:0,0,1,0,1,0,1,0,0"}};
+};
+
+// Сеансы независимы: результат одного не влияет на другой
+TEST_F(sessionFixture, sessionsAreIndependent) {
+  s21::ProgramData first, second;
+  QString reason;
+  bool status{false};
+  ASSERT_TRUE(controller::image_validation(first, images[0]));
+  ASSERT_TRUE(controller::image_validation(second, images[1]));
+  QImage a = controller::process(first, {"negative"}, reason, status);
+  ASSERT_TRUE(status);
+  EXPECT_TRUE(second.resultingImage.toImage() == images[1]);
+  EXPECT_TRUE(first.resultingImage.toImage() == a);
+  EXPECT_FALSE(controller::image_validation(second, QImage()));
+  EXPECT_TRUE(controller::process(second, {"negative"}, reason, status)
+                  .isNull());
+  EXPECT_FALSE(status);
+}
+
+// Сотни одновременных задач дают те же результаты, что и последовательные
+TEST_F(sessionFixture, concurrentJobs) {
+  const int jobs = 400;
+  auto imageOf = [&](int job) { return images[job % images.size()]; };
+  auto chainOf = [&](int job) { return chains[(job / 4) % chains.size()]; };
+
+  std::vector<QImage> expected(jobs);
+  for (int job = 0; job < jobs; ++job) {
+    s21::ProgramData data;
+    QString reason;
+    bool status{false};
+    controller::image_validation(data, imageOf(job));
+    expected[job] = controller::process(data, chainOf(job), reason, status);
+    ASSERT_TRUE(status) << reason.toStdString();
+  }
+
+  std::vector<QImage> results(jobs);
+  std::atomic<int> next{0};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 16; ++t) {
+    workers.emplace_back([&]() {
+      for (int job = next++; job < jobs; job = next++) {
+        s21::ProgramData data;
+        QString reason;
+        bool status{false};
+        if (!controller::image_validation(data, imageOf(job))) continue;
+        QImage img = controller::process(data, chainOf(job), reason, status);
+        if (status) results[job] = img;
+      }
+    });
+  }
+  for (auto &worker : workers) worker.join();
+  for (int job = 0; job < jobs; ++job)
+    EXPECT_TRUE(results[job] == expected[job]) << "job " << job;
+}
+
+// Предпросмотр считается на прокси и не меняет полный результат сеанса
+TEST_F(sessionFixture, proxyPreview) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  ASSERT_TRUE(controller::image_validation(data, images[3]));
+  auto preview = controller::proxy(data, QSize(13, 13));
+  ASSERT_TRUE(preview.isValidImage);
+  EXPECT_EQ(preview.sourceImage.width(), 13);
+  EXPECT_EQ(preview.sourceImage.height(), 9);
+
+  QPixmap toned = controller::simple<4>(
+      preview, std::forward_as_tuple(model::simple::toning,
+                                     QColor(255, 128, 0), reason, status));
+  EXPECT_TRUE(status);
+  EXPECT_EQ(toned.width(), 13);
+  controller::convolution(preview, "0,0,0,0,1,0,0,0,0", reason, status);
+  EXPECT_TRUE(status);
+  EXPECT_TRUE(data.resultingImage.toImage() == images[3]);
+  // экранные результаты не попадают в кеш полноразмерных
+  EXPECT_EQ(preview.cache, nullptr);
+  EXPECT_EQ(data.cache->size(), 0u);
+  EXPECT_FALSE(controller::proxy(s21::ProgramData(), QSize(9, 9)).isValidImage);
+
+  // пока отрисовка не принята, прокси - текущая цепочка над уменьшенным
+  // источником, а не прежний результат
+  controller::chain::append(data, model::pipeline::negative());
+  auto pending = controller::proxy(data, QSize(13, 13));
+  EXPECT_TRUE(pending.sourceImage.toImage() ==
+              data.chain.run(preview.sourceImage).toImage());
+}
+
+// Настройка ползунками: прокси видимой части, операция только над ним;
+// описания для командной строки дают ту же операцию
+TEST_F(sessionFixture, adjustVisibleRegion) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  EXPECT_TRUE(controller::adjust(data, {}, reason, status).isNull());
+  EXPECT_FALSE(status);
+  ASSERT_TRUE(controller::image_validation(data, images[3]));
+  const QRect region(4, 3, 20, 10);
+  auto preview = controller::proxy(data, QSize(100, 100), region);
+  ASSERT_TRUE(preview.isValidImage);
+  EXPECT_TRUE(preview.sourceImage.toImage() == images[3].copy(region));
+
+  model::pointop::Adjustment adjustment;
+  adjustment.brightness = 30;
+  adjustment.gamma = 1.4f;
+  QPixmap qpm = controller::adjust(preview, adjustment, reason, status);
+  ASSERT_TRUE(status);
+  QImage expected = images[3].copy(region);
+  model::pipeline::Pipeline chain;
+  chain.push(model::pipeline::levels(30, 1, 1.4f));
+  EXPECT_TRUE(qpm.toImage().convertToFormat(QImage::Format_RGB32) ==
+              chain.run(expected));
+  EXPECT_TRUE(data.resultingImage.toImage() == images[3]);
+
+  model::pipeline::Operation op;
+  ASSERT_TRUE(controller::makeOperation("levels:30,1,1.4", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::levels(30, 1, 1.4f).digest());
+  ASSERT_TRUE(controller::makeOperation("toning:#ff8000,0.5", op, reason));
+  EXPECT_EQ(op.digest(),
+            model::pipeline::toning(QColor(255, 128, 0), 0.5f).digest());
+  ASSERT_TRUE(controller::makeOperation("grayscale:1,1,1", op, reason));
+  ASSERT_TRUE(controller::makeOperation("grayscale:dissat", op, reason));
+  EXPECT_EQ(op.digest(), model::pipeline::grayscale(DISSAT).digest());
+  EXPECT_FALSE(controller::makeOperation("grayscale:lightness", op, reason));
+  EXPECT_FALSE(controller::makeOperation("grayscale:x", op, reason));
+  EXPECT_FALSE(controller::makeOperation("levels:1,2", op, reason));
+  EXPECT_FALSE(controller::makeOperation("toning:nocolor,1", op, reason));
+}
+
+// Предпросмотр ядра: ошибка разбора отменяет расчет, новый запуск - прежний
+TEST_F(sessionFixture, kernelPreviewRestarts) {
+  s21::ProgramData data;
+  QString reason;
+  bool status{false};
+  model::render::Renderer renderer(2);
+  EXPECT_EQ(controller::kernelPreview(data, renderer, "0,0,0,0,1,0,0,0,0", {},
+                                      reason, status),
+            0u);
+  ASSERT_TRUE(controller::image_validation(data, images[3]));
+  auto preview = controller::proxy(data, QSize(20, 20));
+  std::mutex mutex;
+  std::vector<std::uint64_t> done;
+  auto count = [&](std::uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    done.push_back(generation);
+  };
+  auto first = controller::kernelPreview(preview, renderer, "1,1,1,1,1,1,1,1,1",
+                                         count, reason, status);
+  EXPECT_TRUE(status);
+  EXPECT_EQ(controller::kernelPreview(preview, renderer, "1,1,1,1", count,
+                                      reason, status),
+            0u);
+  EXPECT_FALSE(status);
+  EXPECT_EQ(reason, QString("Invalid size."));
+  renderer.wait();
+  EXPECT_TRUE(renderer.result().isNull());
+  // первый расчет мог успеть закончиться до отмены, но только он
+  for (auto generation : done) EXPECT_EQ(generation, first);
+  done.clear();
+
+  auto second = controller::kernelPreview(
+      preview, renderer, "0,0,0,0,2,0,0,0,0", count, reason, status);
+  EXPECT_GT(second, first);
+  renderer.wait();
+  model::pipeline::Pipeline twice;
+  twice.push(model::pipeline::Operation::convolution(
+      "Custom", {0, 0, 0, 0, 2, 0, 0, 0, 0}));
+  EXPECT_TRUE(renderer.result().toImage() ==
+              twice.run(preview.sourceImage).toImage());
+  EXPECT_EQ(done, std::vector<std::uint64_t>{second});
+  EXPECT_TRUE(data.resultingImage.toImage() == images[3]);
+}
+
+// Прокси предпросмотра уменьшается, если расчет не уложился в кадр
+TEST_F(sessionFixture, previewBoundFitsBudget) {
+  const QSize viewport(800, 600);
+  EXPECT_EQ(controller::previewBound(viewport, QSize(), 0, 16), viewport);
+  EXPECT_EQ(controller::previewBound(viewport, viewport, 64, 16),
+            QSize(400, 300));
+  EXPECT_EQ(controller::previewBound(viewport, QSize(400, 300), 4, 16),
+            viewport);
+  EXPECT_EQ(controller::previewBound(viewport, viewport, 1e6, 16),
+            QSize(100, 75));
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../model/metrics.hpp"
+#include "../model/trace.hpp"
+
+class traceFixture : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model::trace::clear();
+    path = (std::filesystem::temp_directory_path() / "photolab-trace.json")
+               .string();
+  }
+
+  void TearDown() override {
+    model::trace::enable(false);
+    model::trace::clear();
+    std::filesystem::remove(path);
+  }
+
+  // Разбор записанного файла как JSON
+  QJsonObject parse() const {
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    QJsonParseError error;
+    const QJsonDocument document =
+        QJsonDocument::fromJson(QByteArray::fromStdString(text.str()), &error);
+    EXPECT_EQ(error.error, QJsonParseError::NoError);
+    return document.object();
+  }
+
+  std::string path;
+};
+
+// Выключенная трассировка ничего не записывает, clear сбрасывает события
+TEST_F(traceFixture, disabledRecordsNothing) {
+  { model::trace::Scope scope("ignored"); }
+  EXPECT_EQ(model::trace::eventsCount(), 0u);
+  model::trace::enable(true);
+  { model::trace::Scope scope("recorded"); }
+  EXPECT_EQ(model::trace::eventsCount(), 1u);
+  model::trace::clear();
+  EXPECT_EQ(model::trace::eventsCount(), 0u);
+}
+
+// Вложенные интервалы и потоки попадают в файл Chrome trace: внутренний
+// интервал лежит внутри внешнего, у каждого потока есть имя
+TEST_F(traceFixture, nestedScopesToChromeJson) {
+  model::trace::enable(true);
+  {
+    model::trace::Scope outer("outer", "rows \"0-7\"");
+    { model::trace::Scope inner("inner"); }
+    std::thread worker([] { model::trace::Scope scope("worker"); });
+    worker.join();
+  }
+  ASSERT_EQ(model::trace::eventsCount(), 3u);
+  ASSERT_TRUE(model::trace::writeChromeJson(path));
+
+  const QJsonArray events = parse().value("traceEvents").toArray();
+  QJsonObject outer, inner, worker;
+  int threadNames = 0;
+  for (qsizetype i = 0; i < events.size(); ++i) {
+    const QJsonObject event = events.at(i).toObject();
+    const QString name = event.value("name").toString();
+    if (event.value("ph").toString() == "M") {
+      EXPECT_EQ(name, QString("thread_name"));
+      ++threadNames;
+    } else if (name == "outer") {
+      outer = event;
+    } else if (name == "inner") {
+      inner = event;
+    } else if (name == "worker") {
+      worker = event;
+    }
+  }
+  EXPECT_EQ(threadNames, 2);
+  ASSERT_FALSE(outer.isEmpty());
+  ASSERT_FALSE(inner.isEmpty());
+  ASSERT_FALSE(worker.isEmpty());
+  EXPECT_EQ(outer.value("args").toObject().value("detail").toString(),
+            QString("rows \"0-7\""));
+  EXPECT_EQ(outer.value("tid").toInt(), inner.value("tid").toInt());
+  EXPECT_NE(outer.value("tid").toInt(), worker.value("tid").toInt());
+  const double begin = outer.value("ts").toDouble();
+  const double end = begin + outer.value("dur").toDouble();
+  EXPECT_GE(inner.value("ts").toDouble(), begin);
+  EXPECT_LE(inner.value("ts").toDouble() + inner.value("dur").toDouble(),
+            end);
+  EXPECT_GE(worker.value("ts").toDouble(), inner.value("ts").toDouble());
+}
+
+// Пустая трасса - тоже корректный JSON; недоступный путь - ошибка
+TEST_F(traceFixture, emptyTraceAndBadPath) {
+  ASSERT_TRUE(model::trace::writeChromeJson(path));
+  EXPECT_EQ(parse().value("traceEvents").toArray().size(), 0);
+  EXPECT_FALSE(model::trace::writeChromeJson("/nonexistent/dir/trace.json"));
+}
+
+// События и счетчики пишутся в буферы потоков: после завершения потоков
+// ничего не теряется, пока поток жив - тоже видно; clear и reset
+// сбрасывают все буферы
+TEST_F(traceFixture, threadBuffersMerged) {
+  model::trace::enable(true);
+  model::metrics::reset();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 8; ++t)
+    workers.emplace_back([] {
+      for (int i = 0; i < 100; ++i) {
+        model::trace::Scope scope("step");
+        model::metrics::count("test.steps");
+      }
+    });
+  for (auto &worker : workers) worker.join();
+  { model::trace::Scope scope("main"); }
+  model::metrics::count("test.steps");
+  EXPECT_EQ(model::trace::eventsCount(), 801u);
+  EXPECT_EQ(model::metrics::counter("test.steps"), 801);
+  EXPECT_EQ(model::metrics::counters().at("test.steps"), 801);
+  model::trace::clear();
+  model::metrics::reset();
+  EXPECT_EQ(model::trace::eventsCount(), 0u);
+  EXPECT_EQ(model::metrics::counter("test.steps"), 0);
+}